@@ -96,6 +96,9 @@ class bayesnet {
         size_t get_nr_probabilities();
 
         static bayesnet* read(const char*); // throws bayesnet_exception
+        static std::string get_cache_filename(const char*);
+        bool save(const char*, const char *source = NULL);
+        bool load(const char*, const char *source = NULL);
 
         inline uint32_t* get_states();
         inline uint32_t* get_parent(unsigned int);
@@ -110,6 +113,8 @@ class bayesnet {
         inline unsigned int get_cpt_size();
     private:
         void destroy();
+        void *mapping; // binary cache the arrays point into, if loaded
+        size_t mapping_size;
         BITSTREAM msg;
         SIZE msg_size;
         bool dirty;
@@ -7,6 +7,7 @@
 #include <map>
 #include <set>
 #include <vector>
+#include <string>
 #include "config.h"
 
 class bayesnet;
@@ -91,7 +92,8 @@ class cnf {
             SYMPLIFY,
             QUINE_MCCLUSKEY,
             SUPPRESS_CONSTRAINTS,
-            BOOL
+            BOOL,
+            ESPRESSO
         };
 
         cnf();
@@ -104,29 +106,48 @@ class cnf {
         void set_encoding(int);
         void set_optimization(opt_t);
         void set_qm_limit(int);
+        void set_threads(unsigned int);
 
         void print();
 
         const uint32_t* get_states() const;
         const std::vector<probability_t>& get_weight_to_probability() const;
-        expression_t* get_expression(int i = -1) const;
-        unsigned int get_nr_expressions() const;
+        expression_t* get_expression() const;
         const std::vector<probability_t> & get_probability_to_weight() const;
         unsigned int get_nr_variables() const;
         unsigned int get_nr_literals() const;
         unsigned int get_nr_weights() const;
         bayesnet* get_bayesnet() const;
     private:
-        int write(const char*, int i);
-        template <class T> void reduce(std::vector<uint32_t> &, std::vector<clause> &, std::map<uint32_t,uint32_t> &);
+        struct clause_counts {
+            unsigned long int clauses;
+            unsigned long int literals;
+            int min;
+            int max;
+        };
+
+        int write(const char*, expression &, int i);
+        int write_stream(const char*);
+        void write_header(FILE *, expression &, int i, const clause_counts &);
+        void write_footer(FILE *, expression &);
+        void stats(FILE *, expression_t *, const clause_counts &);
+        clause_counts count(const expression &) const;
+        clause_counts count_stream();
+        template <class F> void each_value_clause(unsigned int, F);
+        template <class F> void each_exclusion_clause(unsigned int, F);
+        template <class F> void each_cpt_clause(unsigned int, F);
+        template <class F> void each_clause(F);
+        template <class T> void reduce(std::vector<uint32_t> &, std::vector<clause> &, std::map<uint32_t,uint32_t> &, std::string &);
+        void minimize(std::vector<uint32_t> &, std::vector<clause> &, std::map<uint32_t,uint32_t> &, std::string &);
         inline uint32_t v_to_l(uint32_t, uint32_t);
         probability_t get_probability(unsigned int);
         probability_t get_probability(unsigned int, expression &expr);
         probability_t get_probability(weight_t);
 
-        void encode_partitions();
+        void encode_partition(unsigned int, expression &, const std::vector< std::vector<unsigned int> > &, const std::vector< std::vector<unsigned int> > &);
         void encode_constraints();
-        void encode_probabilities();
+        void encode_probabilities(bool literals = true);
+        void encode_weights();
         void encode_prime();
         void encode_deterministic_probabilities();
         void encode_determinism();
@@ -147,15 +168,21 @@ class cnf {
             OPT_SUPPRESS_CONSTRAINTS,
             OPT_SYMPLIFY,
             OPT_QUINE_MCCLUSKEY,
+            OPT_ESPRESSO,
             OPT_BOOL;
 
         int QM_LIMIT;
+        unsigned int THREADS;
         unsigned int CONSTRAINTS;
         unsigned int VARIABLES;
+        bool STREAM;
         expression_t expr;
-        std::vector<expression> exprs;
         std::vector< std::map<unsigned int, unsigned int> > variable_expr_map;
 
+        // without Quine-McCluskey the clauses are generated while writing,
+        // only the weight of every CPT entry is kept
+        std::vector<weight_t> entry_to_weight;
+
         std::vector<probability_t> weight_to_probability;
         bayesnet *bn;
 };
@@ -64,6 +64,7 @@ namespace HUGIN {
         unsigned int dimensions;
         std::vector<unsigned int> dim;
         std::vector<std::string> value;
+        std::vector<double> number; // float values, unless any is not a number
     };
 
     struct attribute {
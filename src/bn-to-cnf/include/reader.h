@@ -58,19 +58,38 @@ class reader {
         bool get_word_peek_equal(std::string);
         bool get_word_peek_not_equal(std::string);
 
+        bool get_number(double&);
+        bool next_char_equal(char);
+
         char get_char();
         void unget_char(char);
         int get_scope_depth();
         delimiter_t get_scope_delimiter();
         void set_filename(std::string);
         void set_fd(FILE*);
+        void set_buffer(const char*, size_t);
         std::string get_filename();
         void allow_eof(bool);
         static std::vector<std::string> string_to_words(std::string);
     private:
+        void reset();
+        const delimiter_t& lookup(char);
+
         bool eof_allowed;
         std::string filename;
-        FILE *file;
+
+        // the input is either mapped or copied into owned, and read from
+        // data[0..size) without going through stdio
+        const char *data;
+        size_t size;
+        size_t pos;
+        bool mapped;
+        std::string owned;
+
+        // delimiter of each character in hierarchical mode
+        delimiter_t table[256];
+        bool table_valid;
+
         int row;
         int col;
         std::vector<delimiter_t> delimiters;
@@ -6,7 +6,13 @@
 #include <string.h>
 #include "cnf.h"
 #include "parser.h"
+#include "misc.h"
 #include <algorithm>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 using namespace std;
 
@@ -197,6 +203,8 @@ bayesnet::bayesdict* bayesnet::get_dict_cpy(){
 }
 
 bayesnet::bayesnet(){
+    mapping = NULL;
+    mapping_size = 0;
     dict = NULL;
     size = 0;
     msg = NULL;
@@ -335,7 +343,19 @@ void bayesnet::print(){
     }
 }
 
+/**
+ * Reads a HUGIN network, or its binary cache if that is up to date. A parsed
+ * network is cached for the next read, if the cache can be written.
+ */
 bayesnet* bayesnet::read(const char *infile){
+    const string kCache = get_cache_filename(infile);
+    bayesnet *bn = new bayesnet();
+    if(bn->load(kCache.c_str(), infile)){
+        bn->set_filename(infile);
+        return bn;
+    }
+    delete bn;
+
     parser<hugin> net;
     try {
         net.process(infile);
@@ -345,15 +365,288 @@ bayesnet* bayesnet::read(const char *infile){
 
     // get bayesian network
     try {
-        return net.get_bayesnet();
+        bn = net.get_bayesnet();
     } catch(throw_string_error &e){
         throw bayesnet_exception("%s", e.what());
     }
-    return NULL;
+
+    if(bn)
+        bn->save(kCache.c_str(), infile);
+    return bn;
+}
+
+string bayesnet::get_cache_filename(const char *infile){
+    string cache(infile);
+    if(strcmp(get_filename_ext(infile), "net") == 0)
+        cache.resize(cache.size()-3);
+    else cache += ".";
+    cache += "bnb";
+    return cache;
+}
+
+namespace {
+
+/**
+ * Layout of the binary cache: a header followed by the flat arrays of the
+ * network and its names, each section 8 byte aligned such that a mapped
+ * cache is used in place. The stamp of the .net file it was created from
+ * tells whether it is still up to date, and a checksum over everything after
+ * the header whether its contents are still as written.
+ */
+const char kCacheMagic[8] = {'B','N','C','A','C','H','E','\0'};
+const uint32_t kCacheVersion = 2;
+const uint32_t kCacheEndian = 0x01020304;
+
+struct cache_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian;
+    uint32_t probability_size;
+    uint32_t size;
+    uint64_t source_size;
+    int64_t source_sec;
+    int64_t source_nsec;
+    uint64_t nr_probabilities;
+    uint64_t nr_parents;
+    uint64_t nr_children;
+    uint64_t nr_strings;    // variable name followed by its value names
+    uint64_t string_bytes;
+    uint64_t checksum;
+};
+
+struct cache_layout {
+    size_t cpt, states, cpt_offset, parent_offset, child_offset;
+    size_t parent, child, string_offset, strings, end;
+};
+
+inline size_t cache_align(size_t n){
+    return (n + 7) & ~((size_t) 7);
+}
+
+cache_layout get_cache_layout(const cache_header &h){
+    cache_layout l;
+    size_t o = cache_align(sizeof(cache_header));
+    l.cpt = o;              o = cache_align(o + sizeof(probability_t)*h.nr_probabilities);
+    l.states = o;           o = cache_align(o + sizeof(uint32_t)*h.size);
+    l.cpt_offset = o;       o = cache_align(o + sizeof(uint32_t)*(h.size+1));
+    l.parent_offset = o;    o = cache_align(o + sizeof(uint32_t)*(h.size+1));
+    l.child_offset = o;     o = cache_align(o + sizeof(uint32_t)*(h.size+1));
+    l.parent = o;           o = cache_align(o + sizeof(uint32_t)*h.nr_parents);
+    l.child = o;            o = cache_align(o + sizeof(uint32_t)*h.nr_children);
+    l.string_offset = o;    o = cache_align(o + sizeof(uint32_t)*(h.nr_strings+1));
+    l.strings = o;          o = cache_align(o + h.string_bytes);
+    l.end = o;
+    return l;
+}
+
+bool get_cache_stamp(const char *source, cache_header &h){
+    struct stat st;
+    if(stat(source, &st) != 0)
+        return false;
+    h.source_size = st.st_size;
+    h.source_sec = st.st_mtim.tv_sec;
+    h.source_nsec = st.st_mtim.tv_nsec;
+    return true;
+}
+
+// FNV-1a over the 8 byte words of the sections, which are all aligned
+uint64_t get_cache_checksum(const char *b, const cache_layout &l){
+    uint64_t hash = 14695981039346656037ULL;
+    const uint64_t *kWords = (const uint64_t*) (b + l.cpt);
+    const size_t kNrWords = (l.end - l.cpt) / sizeof(uint64_t);
+    for(size_t i = 0; i < kNrWords; i++)
+        hash = (hash ^ kWords[i]) * 1099511628211ULL;
+    return hash;
+}
+
+bool is_offset_array(const uint32_t *offset, uint32_t n, uint64_t total){
+    for(uint32_t i = 0; i < n; i++)
+        if(offset[i] > offset[i+1])
+            return false;
+    return offset[0] == 0 && offset[n] == total;
+}
+
+}
+
+/**
+ * Writes the network to a binary cache, stamped with the source file if
+ * given. The cache is written next to its destination and renamed, such
+ * that concurrent readers never see a partial cache.
+ */
+bool bayesnet::save(const char *cachefile, const char *source){
+    if(!dict || size == 0)
+        return false;
+
+    cache_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, kCacheMagic, sizeof(h.magic));
+    h.version = kCacheVersion;
+    h.endian = kCacheEndian;
+    h.probability_size = sizeof(probability_t);
+    h.size = size;
+    if(source && !get_cache_stamp(source, h))
+        return false;
+    h.nr_probabilities = cpt_offset[size];
+    h.nr_parents = parent_offset[size];
+    h.nr_children = child_offset[size];
+
+    vector<uint32_t> string_offset(1, 0);
+    string strings;
+    for(unsigned int i = 0; i < size; i++){
+        strings += dict->id_to_name[i];
+        string_offset.push_back(strings.size());
+        for(auto it = dict->value[i].begin(); it != dict->value[i].end(); it++){
+            strings += *it;
+            string_offset.push_back(strings.size());
+        }
+    }
+    h.nr_strings = string_offset.size()-1;
+    h.string_bytes = strings.size();
+
+    const cache_layout kLayout = get_cache_layout(h);
+    vector<char> buffer(kLayout.end, 0);
+    char *b = &buffer[0];
+    memcpy(b, &h, sizeof(h));
+    memcpy(b + kLayout.cpt, cpt, sizeof(probability_t)*h.nr_probabilities);
+    memcpy(b + kLayout.states, states, sizeof(uint32_t)*size);
+    memcpy(b + kLayout.cpt_offset, cpt_offset, sizeof(uint32_t)*(size+1));
+    memcpy(b + kLayout.parent_offset, parent_offset, sizeof(uint32_t)*(size+1));
+    memcpy(b + kLayout.child_offset, child_offset, sizeof(uint32_t)*(size+1));
+    memcpy(b + kLayout.parent, parent, sizeof(uint32_t)*h.nr_parents);
+    memcpy(b + kLayout.child, child, sizeof(uint32_t)*h.nr_children);
+    memcpy(b + kLayout.string_offset, &string_offset[0], sizeof(uint32_t)*string_offset.size());
+    memcpy(b + kLayout.strings, strings.data(), strings.size());
+    ((cache_header*) b)->checksum = get_cache_checksum(b, kLayout);
+
+    char tmpfile[4096];
+    snprintf(tmpfile, sizeof(tmpfile), "%s.%d.tmp", cachefile, (int) getpid());
+    FILE *file = fopen(tmpfile, "wb");
+    if(!file)
+        return false;
+    const bool kWritten = fwrite(b, 1, buffer.size(), file) == buffer.size();
+    if(fclose(file) != 0 || !kWritten || rename(tmpfile, cachefile) != 0){
+        unlink(tmpfile);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Maps a binary cache written by save. Returns false, leaving the network
+ * untouched, if the cache is missing, malformed, corrupted, of another
+ * version, or older than or not stamped with the source file if that is given.
+ */
+bool bayesnet::load(const char *cachefile, const char *source){
+    int fd = open(cachefile, O_RDONLY);
+    if(fd < 0)
+        return false;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(cache_header)){
+        close(fd);
+        return false;
+    }
+
+    // private writable mapping, such that in-place changes to the arrays
+    // never reach the cache
+    const size_t kMappingSize = st.st_size;
+    void *m = mmap(NULL, kMappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(m == MAP_FAILED)
+        return false;
+
+    const char *b = (const char*) m;
+    const cache_header &h = *((const cache_header*) b);
+    bool valid = memcmp(h.magic, kCacheMagic, sizeof(h.magic)) == 0
+        && h.version == kCacheVersion
+        && h.endian == kCacheEndian
+        && h.probability_size == sizeof(probability_t)
+        && h.size > 0
+        && h.string_bytes < UINT32_MAX
+        && get_cache_layout(h).end == kMappingSize;
+
+    if(valid && source){
+        cache_header stamp;
+        valid = get_cache_stamp(source, stamp)
+            && stamp.source_size == h.source_size
+            && stamp.source_sec == h.source_sec
+            && stamp.source_nsec == h.source_nsec
+            && (st.st_mtim.tv_sec > h.source_sec
+                || (st.st_mtim.tv_sec == h.source_sec && st.st_mtim.tv_nsec >= h.source_nsec));
+    }
+
+    cache_layout l;
+    if(valid){
+        l = get_cache_layout(h);
+        valid = get_cache_checksum(b, l) == h.checksum;
+    }
+
+    if(valid){
+        const uint32_t *kStates = (const uint32_t*) (b + l.states);
+        const uint32_t *kParent = (const uint32_t*) (b + l.parent);
+        const uint32_t *kChild = (const uint32_t*) (b + l.child);
+        uint64_t nr_strings = h.size;
+        for(uint32_t i = 0; i < h.size; i++)
+            nr_strings += kStates[i];
+        for(uint64_t i = 0; i < h.nr_parents && valid; i++)
+            valid = kParent[i] < h.size;
+        for(uint64_t i = 0; i < h.nr_children && valid; i++)
+            valid = kChild[i] < h.size;
+
+        valid = valid
+            && nr_strings == h.nr_strings
+            && is_offset_array((const uint32_t*) (b + l.cpt_offset), h.size, h.nr_probabilities)
+            && is_offset_array((const uint32_t*) (b + l.parent_offset), h.size, h.nr_parents)
+            && is_offset_array((const uint32_t*) (b + l.child_offset), h.size, h.nr_children)
+            && is_offset_array((const uint32_t*) (b + l.string_offset), h.nr_strings, h.string_bytes);
+    }
+
+    if(!valid){
+        munmap(m, kMappingSize);
+        return false;
+    }
+
+    destroy();
+    clear();
+    clear_dict();
+
+    char *w = (char*) m;
+    mapping = m;
+    mapping_size = kMappingSize;
+    size = h.size;
+    nr_probabilities = h.nr_probabilities;
+    cpt = (probability_t*) (w + l.cpt);
+    states = (uint32_t*) (w + l.states);
+    cpt_offset = (uint32_t*) (w + l.cpt_offset);
+    parent_offset = (uint32_t*) (w + l.parent_offset);
+    child_offset = (uint32_t*) (w + l.child_offset);
+    parent = (uint32_t*) (w + l.parent);
+    child = (uint32_t*) (w + l.child);
+
+    const uint32_t *kStringOffset = (const uint32_t*) (b + l.string_offset);
+    const char *kStrings = b + l.strings;
+    dict = new bayesdict();
+    dict->value.resize(size);
+    uint64_t j = 0;
+    for(unsigned int i = 0; i < size; i++, j++){
+        string name(kStrings + kStringOffset[j], kStringOffset[j+1] - kStringOffset[j]);
+        dict->name_to_id[name] = i;
+        dict->id_to_name.push_back(name);
+        for(unsigned int k = 0; k < states[i]; k++){
+            j++;
+            dict->value[i].push_back(string(kStrings + kStringOffset[j], kStringOffset[j+1] - kStringOffset[j]));
+        }
+    }
+    return true;
 }
 
 void bayesnet::clear(){
-    if(size > 0){
+    if(mapping){
+        munmap(mapping, mapping_size);
+        mapping = NULL;
+        mapping_size = 0;
+        size = 0;
+    } else if(size > 0){
         size = 0;
         free(cpt);
         free(parent);
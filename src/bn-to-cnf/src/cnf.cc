@@ -1,6 +1,7 @@
 #include "cnf.h"
 #include "misc.h"
 #include <quine-mccluskey/qm.h>
+#include <quine-mccluskey/espresso.h>
 #include "bayesnet.h"
 #include <stack>
 #include <array>
@@ -12,11 +13,15 @@
 #include <array>
 #include <map>
 #include <math.h>
+#include <thread>
+#include <atomic>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdarg.h>
+#include <assert.h>
 
 using namespace std;
 
@@ -27,6 +32,95 @@ T& dynamic_assign(std::vector<T> &v, unsigned int i){
     return v[i];
 }
 
+// printf to the end of a string, used for output of concurrent CPTs
+static void append(std::string &str, const char *format, ...){
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if(n >= (int) sizeof(buf)){
+        std::vector<char> big(n+1);
+        va_start(args, format);
+        vsnprintf(&big[0], big.size(), format, args);
+        va_end(args);
+        str.append(&big[0], n);
+    } else if(n > 0)
+        str.append(buf, n);
+}
+
+// runs f(i) for all i in [0,n) on at most the given number of threads,
+// indices are handed out one at a time as CPTs differ a lot in cost
+template <class F>
+static void parallel_for(unsigned int n, unsigned int threads, F f){
+    if(threads > n)
+        threads = n;
+    if(threads <= 1){
+        for(unsigned int i = 0; i < n; i++)
+            f(i);
+        return;
+    }
+
+    std::atomic<unsigned int> next(0);
+    auto worker = [&](){
+        unsigned int i;
+        while((i = next.fetch_add(1, std::memory_order_relaxed)) < n)
+            f(i);
+    };
+    std::vector<std::thread> pool;
+    for(unsigned int t = 1; t < threads; t++)
+        pool.emplace_back(worker);
+    worker();
+    for(auto it = pool.begin(); it != pool.end(); it++)
+        it->join();
+}
+
+// formats DIMACS clauses into a fixed buffer that is handed to the file in
+// large blocks, instead of a formatted write per literal
+class dimacs_writer {
+    public:
+        dimacs_writer(FILE *file) : file(file), pos(0) {}
+        ~dimacs_writer(){ flush(); }
+
+        inline void put(long long x){
+            if(pos + 24 > sizeof(buffer))
+                flush();
+            if(x < 0){
+                buffer[pos++] = '-';
+                x = -x;
+            }
+            char digits[20];
+            int n = 0;
+            do {
+                digits[n++] = '0' + x % 10;
+                x /= 10;
+            } while(x > 0);
+            while(n > 0)
+                buffer[pos++] = digits[--n];
+            buffer[pos++] = ' ';
+        }
+
+        inline void end(){
+            if(pos + 2 > sizeof(buffer))
+                flush();
+            buffer[pos++] = '0';
+            buffer[pos++] = '\n';
+        }
+
+        void flush(){
+            if(pos > 0)
+                fwrite(buffer, 1, pos, file);
+            pos = 0;
+        }
+    private:
+        FILE *file;
+        size_t pos;
+        char buffer[1 << 16];
+};
+
+// CPT entries of probability 1 that simplification removed, they are not written
+static const weight_t OMITTED = -2;
+
 expression::expression(){
     clear();
 }
@@ -207,25 +301,120 @@ probability_t cnf::get_probability(unsigned int i, expression &expr){
     } else return get_probability(i);
 }
 
+// at least one value of variable i holds
+template <class F>
+void cnf::each_value_clause(unsigned int i, F f){
+    if(OPT_BOOL && bn->states[i] == 2)
+        return;
+
+    std::vector<literal_t> literals(bn->states[i]);
+    for(unsigned int v = 0; v < bn->states[i]; v++)
+        literals[v] = v_to_l(i,v);
+    f(literals);
+}
+
+// no two values of variable i hold at once
+template <class F>
+void cnf::each_exclusion_clause(unsigned int i, F f){
+    if(OPT_BOOL && bn->states[i] == 2)
+        return;
+
+    unsigned int values = bn->states[i];
+    uint32_t literal_base = v_to_l(i,0);
+    std::vector<literal_t> literals(2);
+    for(unsigned int v = 0; v < values-1; v++){
+        for(unsigned int vv = v+1; vv < values; vv++){
+            literals[0] = -1*(literal_base+v);
+            literals[1] = -1*(literal_base+vv);
+            f(literals);
+        }
+    }
+}
+
+// one clause per entry of the CPT of variable i, f(q, literals) for entry q
+template <class F>
+void cnf::each_cpt_clause(unsigned int i, F f){
+    unsigned int m = bn->get_parent_size(i);
+    std::vector<int> max(m+1), ctr(m+1), variable(m+1);
+    size_t entries = 1;
+    for(unsigned int j = 0; j < m; j++){
+        variable[j] = bn->get_parent(i)[j];
+        max[j] = expr.values[variable[j]];
+        ctr[j] = 0;
+        entries *= max[j];
+    }
+    variable[m] = i;
+    max[m] = expr.values[i];
+    ctr[m] = 0;
+    entries *= max[m];
+
+    std::vector<literal_t> literals(m+1);
+    for(size_t q = 0; q < entries; q++){
+        for(unsigned int j = 0; j <= m; j++){
+            if(OPT_BOOL && max[j] == 2){
+                uint32_t lid = v_to_l(variable[j],0);
+                if(ctr[j]==1)
+                    literals[j] = -1*lid;
+                else
+                    literals[j] = lid;
+            } else {
+                uint32_t lid = v_to_l(variable[j],ctr[j]);
+                literals[j] = -1*lid;
+            }
+        }
+        f(q, literals);
+
+        // next assignment, the value of variable i changes fastest
+        int j = m;
+        while(j >= 0 && ctr[j] == max[j]-1)
+            ctr[j--] = 0;
+        if(j >= 0)
+            ctr[j]++;
+    }
+}
+
+// generates the clauses in the order of the in-memory encoding, f(literals, w)
+template <class F>
+void cnf::each_clause(F f){
+    if(encoding == 0){
+        for(unsigned int i = 0; i < bn->size; i++)
+            each_value_clause(i, [&](const std::vector<literal_t> &literals){ f(literals, -1); });
+        for(unsigned int i = 0; i < bn->size; i++)
+            each_exclusion_clause(i, [&](const std::vector<literal_t> &literals){ f(literals, -1); });
+    }
+
+    for(unsigned int i = 0; i < bn->size; i++){
+        const weight_t *weights = &(entry_to_weight[bn->cpt_offset[i]]);
+        each_cpt_clause(i, [&](size_t q, const std::vector<literal_t> &literals){
+            if(weights[q] != OMITTED)
+                f(literals, weights[q]);
+        });
+    }
+}
+
 void cnf::clear(){
     expr.clear();
 
     weight_to_probability.clear();
+    entry_to_weight.clear();
 
     CONSTRAINTS = 0;
     VARIABLES = 0;
+    STREAM = false;
     OPT_SUPPRESS_CONSTRAINTS = false;
     OPT_EQUAL_PROBABILITIES = false;
     OPT_PARTITION = false;
     OPT_DETERMINISTIC_PROBABILITIES = false;
     OPT_SYMPLIFY = false;
     OPT_QUINE_MCCLUSKEY = false;
+    OPT_ESPRESSO = false;
     OPT_BOOL = false;
     expr.clauses.clear();
     qm_eligible = 0;
     qm_possible = 0;
     qm_variable_count.clear();
     QM_LIMIT = -1;
+    set_threads(0);
     encoding = 0; // default encoding containing constraints
     this->~cnf();
 }
@@ -316,24 +505,67 @@ void cnf::clear(){
 //     return 0;
 // }
 
-int cnf::write(const char* outfile, int i){
-    expression_t *tmp;
-    if(i < 0)
-        tmp = &expr;
-    else tmp = &(exprs[i]);
-    expression &expr = *tmp;
+void cnf::write_header(FILE *file, expression &expr, int i, const clause_counts &counts){
+    fprintf(file, "c DIMACS CNF Format\n");
+    fprintf(file, "c\n");
+    stats(file, &expr, counts);
+    fprintf(file, "c\n");
+    if(i >= 0){
+        fprintf(file, "c CNF representation of variable '%s'\n", bn->get_node_name(i).c_str());
+        fprintf(file, "c\n");
+    }
+    fprintf(file, "c ===================================================\n");
+}
+
+void cnf::write_footer(FILE *file, expression &expr){
+    fprintf(file, "c ===================================================\n");
+    //fprintf(file, "c clauses       : %-6u\n", expr.clauses.size());
+    //fprintf(file, "c literals      : %-6u (1-%u)\n", expr.LITERALS,expr.LITERALS);
+    //fprintf(file, "c probabilities : %-6u (%u-%u)\n", weight_to_probability.size(), expr.LITERALS+1, expr.LITERALS+weight_to_probability.size());
+    fprintf(file, "c\n");
+    fprintf(file, "c literal-to-real-weight mapping:\n");
+    fprintf(file, "c     1-%u = 1\n",expr.LITERALS);
+
+    if(expr.is_mapped()){
+        for(unsigned int i = 0; i < expr.weight_to_weight_map.size(); i++)
+            fprintf(file, "c     %u = %f\n", expr.LITERALS+1+i, get_probability(expr.weight_to_weight_map[i]));
+    } else {
+        for(unsigned int i = 0; i < weight_to_probability.size(); i++)
+            fprintf(file, "c     %u = %f\n", expr.LITERALS+1+i, weight_to_probability[i]);
+    }
 
+    fprintf(file, "c\nc variable-to-literal mapping:\n");
+    for(unsigned int v = 0; v < expr.get_nr_variables(); v++){
+        fprintf(file, "c     %u = {",v);
+        for(unsigned int l = 0; l < expr.values[v]; l++){
+            if(l > 0) fprintf(file,",");
+            fprintf(file, "%u",expr.variable_to_literal[v]+l);
+            if(OPT_BOOL && expr.values[v] == 2)
+                break;
+        }
+        fprintf(file,"}\n");
+    }
+
+    if(bn){
+        fprintf(file, "c\nc variable-and-values-to-names mapping:\n");
+        fprintf(file, "c     <variable> <nr of values> <variable name>\n");
+        fprintf(file, "c          <value literal> <value name>\n");
+        fprintf(file, "c         [<value literal> <value name>]\nc\n");
+        for(unsigned int v = 0; v < expr.get_nr_variables(); v++){
+            unsigned int old_variable = v;
+            if(expr.is_mapped())
+                old_variable = expr.variable_to_variable_map[v];
+            fprintf(file, "c     %u %u \"%s\"\n", v, expr.values[v], bn->get_node_name(old_variable).c_str());
+            for(unsigned int l = 0; l < expr.values[v]; l++)
+                fprintf(file, "c         %u \"%s\"\n", expr.variable_to_literal[v]+l, bn->get_node_value_name(old_variable,l).c_str());
+        }
+    }
+}
+
+int cnf::write(const char* outfile, expression &expr, int i){
     FILE *file = fopen(outfile,"w");
     if(file){
-        fprintf(file, "c DIMACS CNF Format\n");
-        fprintf(file, "c\n");
-        stats(file, &expr);
-        fprintf(file, "c\n");
-        if(i >= 0){
-            fprintf(file, "c CNF representation of variable '%s'\n", bn->get_node_name(i).c_str());
-            fprintf(file, "c\n");
-        }
-        fprintf(file, "c ===================================================\n");
+        write_header(file, expr, i, count(expr));
         unsigned int counter = 0;
         for(unsigned int i = 0; i < expr.clauses.size(); i++){
             probability_t p = get_probability(i,expr);
@@ -342,66 +574,61 @@ int cnf::write(const char* outfile, int i){
         }
 
         fprintf(file, "p cnf %u %u\n", expr.LITERALS+expr.WEIGHTS, counter);
-        for(unsigned int i = 0; i < expr.clauses.size(); i++){
-            if(!OPT_SYMPLIFY || get_probability(i,expr) != 1){
-                clause &c = expr.clauses[i];
-                for(unsigned int j = 0; j < c.literals.size(); j++)
-                    fprintf(file, "%d ", c.literals[j]);
-
-                if(get_probability(i,expr) != -1 && (!OPT_SYMPLIFY || get_probability(i,expr) != 0))
-                    fprintf(file, "%u ", expr.LITERALS+1+c.w);
-
-                fprintf(file,"0\n");
+        fflush(file);
+        {
+            dimacs_writer out(file);
+            for(unsigned int i = 0; i < expr.clauses.size(); i++){
+                probability_t p = get_probability(i,expr);
+                if(!OPT_SYMPLIFY || p != 1){
+                    clause &c = expr.clauses[i];
+                    for(unsigned int j = 0; j < c.literals.size(); j++)
+                        out.put(c.literals[j]);
+
+                    if(p != -1 && (!OPT_SYMPLIFY || p != 0))
+                        out.put(expr.LITERALS+1+c.w);
+
+                    out.end();
+                }
             }
         }
 
-        fprintf(file, "c ===================================================\n");
-        //fprintf(file, "c clauses       : %-6u\n", expr.clauses.size());
-        //fprintf(file, "c literals      : %-6u (1-%u)\n", expr.LITERALS,expr.LITERALS);
-        //fprintf(file, "c probabilities : %-6u (%u-%u)\n", weight_to_probability.size(), expr.LITERALS+1, expr.LITERALS+weight_to_probability.size());
-        fprintf(file, "c\n");
-        fprintf(file, "c literal-to-real-weight mapping:\n");
-        fprintf(file, "c     1-%u = 1\n",expr.LITERALS);
+        write_footer(file, expr);
+        fclose(file);
 
-        if(expr.is_mapped()){
-            for(unsigned int i = 0; i < expr.weight_to_weight_map.size(); i++)
-                fprintf(file, "c     %u = %f\n", expr.LITERALS+1+i, get_probability(expr.weight_to_weight_map[i]));
-        } else {
-            for(unsigned int i = 0; i < weight_to_probability.size(); i++)
-                fprintf(file, "c     %u = %f\n", expr.LITERALS+1+i, weight_to_probability[i]);
-        }
+    } else fprintf(stderr, "Could not open file '%s'\n", outfile);
+    return 0;
 
-        fprintf(file, "c\nc variable-to-literal mapping:\n");
-        for(unsigned int v = 0; v < expr.get_nr_variables(); v++){
-            fprintf(file, "c     %u = {",v);
-            for(unsigned int l = 0; l < expr.values[v]; l++){
-                if(l > 0) fprintf(file,",");
-                fprintf(file, "%u",expr.variable_to_literal[v]+l);
-                if(OPT_BOOL && expr.values[v] == 2)
-                    break;
-            }
-            fprintf(file,"}\n");
-        }
+}
 
-        if(bn){
-            fprintf(file, "c\nc variable-and-values-to-names mapping:\n");
-            fprintf(file, "c     <variable> <nr of values> <variable name>\n");
-            fprintf(file, "c          <value literal> <value name>\n");
-            fprintf(file, "c         [<value literal> <value name>]\nc\n");
-            for(unsigned int v = 0; v < expr.get_nr_variables(); v++){
-                unsigned int old_variable = v;
-                if(expr.is_mapped())
-                    old_variable = expr.variable_to_variable_map[v];
-                fprintf(file, "c     %u %u \"%s\"\n", v, expr.values[v], bn->get_node_name(old_variable).c_str());
-                for(unsigned int l = 0; l < expr.values[v]; l++)
-                    fprintf(file, "c         %u \"%s\"\n", expr.variable_to_literal[v]+l, bn->get_node_value_name(old_variable,l).c_str());
-            }
+// writes the complete CNF while generating its clauses, a first pass counts
+// them for the statistics and the header
+int cnf::write_stream(const char* outfile){
+    FILE *file = fopen(outfile,"w");
+    if(file){
+        const clause_counts kCounts = count_stream();
+        write_header(file, expr, -1, kCounts);
+
+        fprintf(file, "p cnf %u %lu\n", expr.LITERALS+expr.WEIGHTS, kCounts.clauses);
+        fflush(file);
+        {
+            dimacs_writer out(file);
+            each_clause([&](const std::vector<literal_t> &literals, weight_t w){
+                for(unsigned int j = 0; j < literals.size(); j++)
+                    out.put(literals[j]);
+
+                probability_t p = get_probability(w);
+                if(p != -1 && (!OPT_SYMPLIFY || p != 0))
+                    out.put(expr.LITERALS+1+w);
+
+                out.end();
+            });
         }
+
+        write_footer(file, expr);
         fclose(file);
 
     } else fprintf(stderr, "Could not open file '%s'\n", outfile);
     return 0;
-
 }
 
 int cnf::write(const char *extra){
@@ -415,21 +642,42 @@ int cnf::write(const char *extra){
     }
     name += ".cnf";
 
-    if(write(name.c_str(),-1) == 0)
+    if((STREAM ? write_stream(name.c_str()) : write(name.c_str(), expr, -1)) == 0)
         printf("\nDIMACS CNF written to: %s\n\n", name.c_str());
     else {
         return 1;
         printf("Could not write to: %s\n\n", name.c_str());
     }
 
-    if(exprs.size() > 0 && OPT_PARTITION) {
-        for(unsigned int v = 0; v < exprs.size(); v++){
-                name = prefix + ".";
+    if(VARIABLES > 0 && OPT_PARTITION) {
+        // in memory, the clauses of every variable are looked up once
+        std::vector< std::vector<unsigned int> > variable_to_constraints(VARIABLES);
+        std::vector< std::vector<unsigned int> > variable_to_clauses(VARIABLES);
+        if(!STREAM){
+            const unsigned int kConstraints = (OPT_SUPPRESS_CONSTRAINTS ? 0 : CONSTRAINTS);
+            for(unsigned int i = 0; i < kConstraints; i++)
+                variable_to_constraints[expr.clause_to_variable[i]].push_back(i);
+            for(unsigned int i = kConstraints; i < expr.clauses.size(); i++)
+                variable_to_clauses[expr.clause_to_variable[i]].push_back(i);
+        }
+
+        // partitions are independent, each is encoded, written and released
+        // by one thread
+        std::vector<string> names(VARIABLES);
+        std::vector<int> failed(VARIABLES, 0);
+        parallel_for(VARIABLES, THREADS, [&](unsigned int v){
+            expression e;
+            encode_partition(v, e, variable_to_constraints, variable_to_clauses);
+
+            names[v] = prefix + ".";
             if(extra)
-                 name += extra;
-            name += "." + to_string(v) + ".cnf";
-            if(write(name.c_str(), v) != 0){
-                printf("Could not write to: %s\n\n", name.c_str());
+                names[v] += extra;
+            names[v] += "." + to_string(v) + ".cnf";
+            failed[v] = write(names[v].c_str(), e, v);
+        });
+        for(unsigned int v = 0; v < VARIABLES; v++){
+            if(failed[v] != 0){
+                printf("Could not write to: %s\n\n", names[v].c_str());
                 return 1;
             }
         }
@@ -438,10 +686,41 @@ int cnf::write(const char *extra){
     return 0;
 }
 
+cnf::clause_counts cnf::count(const expression &e) const {
+    clause_counts counts = { e.clauses.size(), 0, -1, 0 };
+    for(auto it = e.clauses.begin(); it != e.clauses.end(); it++){
+        int size = it->literals.size();
+        counts.literals += size;
+        if(size > counts.max)
+            counts.max = size;
+        if(counts.min < 0 || size < counts.min)
+            counts.min = size;
+    }
+    return counts;
+}
+
+cnf::clause_counts cnf::count_stream(){
+    clause_counts counts = { 0, 0, -1, 0 };
+    each_clause([&](const std::vector<literal_t> &literals, weight_t){
+        int size = literals.size();
+        counts.clauses++;
+        counts.literals += size;
+        if(size > counts.max)
+            counts.max = size;
+        if(counts.min < 0 || size < counts.min)
+            counts.min = size;
+    });
+    return counts;
+}
+
 void cnf::stats(FILE *file, expression_t* e){
     if(!e)
         e = &expr;
 
+    stats(file, e, (STREAM && e == &expr ? count_stream() : count(*e)));
+}
+
+void cnf::stats(FILE *file, expression_t* e, const clause_counts &counts){
     char prefix[10] = {0};
     if(file != stdout)
         strcpy(prefix, "c     ");
@@ -451,10 +730,12 @@ void cnf::stats(FILE *file, expression_t* e){
     fprintf(file,"%s    Boolean recognition  : %s\n", prefix, (OPT_BOOL?"YES":"NO"));
     fprintf(file,"%s    Equal probabilities  : %s\n", prefix, (OPT_EQUAL_PROBABILITIES?"YES":"NO") );
     fprintf(file,"%s    Partition per CPT    : %s\n", prefix, (OPT_PARTITION?"YES":"NO") );
-    fprintf(file,"%s    Quine-McCluskey      : %s  ", prefix, (OPT_QUINE_MCCLUSKEY?"YES":"NO"));
-    if(QM_LIMIT >= 0)
+    fprintf(file,"%s    Quine-McCluskey      : %s  ", prefix, (OPT_QUINE_MCCLUSKEY && !OPT_ESPRESSO?"YES":"NO"));
+    if(QM_LIMIT >= 0 && !OPT_ESPRESSO)
         fprintf(file," (limit %d)", QM_LIMIT);
     fprintf(file,"\n");
+    if(OPT_ESPRESSO)
+        fprintf(file,"%s    Espresso             : YES\n", prefix);
     fprintf(file,"%s    Determinism          : %s\n", prefix, (OPT_DETERMINISTIC_PROBABILITIES?"YES":"NO") );
     fprintf(file,"%s    Simplify             : %s\n", prefix, (OPT_SYMPLIFY?"YES":"NO") );
 
@@ -464,26 +745,9 @@ void cnf::stats(FILE *file, expression_t* e){
     fprintf(file,"%sDeterministic   : %d\n", prefix, e->DETERMINISTIC);
     fprintf(file,"%sUnsatisfiable   : %d\n", prefix, e->ZERO);
     fprintf(file,"%sLiterals        : %d\n", prefix, e->LITERALS);
-    fprintf(file,"%sClauses         : %lu\n", prefix, e->clauses.size());
-
-    int max = 0;
-    int min = -1;
-    unsigned long int total = 0;
-    for(auto it = e->clauses.begin(); it != e->clauses.end(); it++){
-        int size = it->literals.size();
-        total += size;
-        if(size > max)
-            max = size;
-        if(min < 0 || size < min)
-            min = size;
-    }
-
-    vector<uint32_t> sizes(max+1,0);
-    for(auto it = e->clauses.begin(); it != e->clauses.end(); it++)
-        sizes[it->literals.size()]++;
-
-    fprintf(file,"%sLiteral/clauses : %.2f \n", prefix, (float) total/e->clauses.size());
-    fprintf(file,"%sClause sizes    : %d-%d\n", prefix, min, max);
+    fprintf(file,"%sClauses         : %lu\n", prefix, counts.clauses);
+    fprintf(file,"%sLiteral/clauses : %.2f \n", prefix, (float) counts.literals/counts.clauses);
+    fprintf(file,"%sClause sizes    : %d-%d\n", prefix, counts.min, counts.max);
     //printf("clauses/size    : ");
     //for(unsigned int i = 1; i <= max; i++)
     //    printf("%5d ", sizes[i]);
@@ -550,6 +814,21 @@ int cnf::encode(bayesnet *bn){
         }
     }
 
+    // only Quine-McCluskey needs the clauses in memory, otherwise they are
+    // generated while writing
+    STREAM = !OPT_QUINE_MCCLUSKEY;
+    if(STREAM){
+        if(encoding != 0 && encoding != 1){
+            clear();
+            return 1;
+        }
+
+        encode_weights();
+        if(entry_to_weight.empty())
+            clear();
+        return 0;
+    }
+
     switch(encoding){
         case 0:
             encode_constraints(); // note missing break;
@@ -572,9 +851,6 @@ int cnf::encode(bayesnet *bn){
         }
     }
 
-    if(OPT_PARTITION)
-        encode_partitions();
-
     if(expr.clauses.size() == 0)
         clear();
 
@@ -586,79 +862,72 @@ int cnf::encode(bayesnet *bn){
 void cnf::init(){
 }
 
-void cnf::encode_partitions(){
-    exprs.resize(VARIABLES);
-    std::vector< std::vector<unsigned int> > variable_to_constraints;
-    variable_to_constraints.resize(VARIABLES);
+// the clauses of the CPT of variable v and the constraints of its family
+void cnf::encode_partition(unsigned int v, expression &e, const std::vector< std::vector<unsigned int> > &variable_to_constraints, const std::vector< std::vector<unsigned int> > &variable_to_clauses){
+    auto add = [&](const std::vector<literal_t> &literals, weight_t w){
+        e.clauses.push_back(clause());
+        e.clauses.back().w = w;
+        e.clauses.back().literals = literals;
+    };
 
-    // identify constraint clauses
-    if(!OPT_SUPPRESS_CONSTRAINTS){
-        for(unsigned int i = 0; i < CONSTRAINTS; i++){
-            unsigned int v = expr.clause_to_variable[i];
-            variable_to_constraints[v].push_back(i);
-        }
-    } else CONSTRAINTS = 0;
-
-    // add constraint clauses
+    // add constraint clauses for variable v and its parents
     if(!OPT_SUPPRESS_CONSTRAINTS){
-        for(unsigned v = 0; v < VARIABLES; v++){
-            // add constraints for variable v
-            for(unsigned int i = 0; i < variable_to_constraints[v].size(); i++){
-                unsigned int c = variable_to_constraints[v][i];
-                exprs[v].clauses.push_back(expr.clauses[c]);
-            }
-            // add constraint clauses for the parents of v
-            uint32_t* parents = bn->get_parent(v);
-            for(unsigned int i = 0; i < bn->get_parent_size(v); i++){
-                unsigned int vv = parents[i];
-                for(unsigned int i = 0; i < variable_to_constraints[vv].size(); i++){
-                    unsigned int c = variable_to_constraints[vv][i];
-                    exprs[v].clauses.push_back(expr.clauses[c]);
-                }
+        uint32_t* parents = bn->get_parent(v);
+        for(unsigned int i = 0; i <= bn->get_parent_size(v); i++){
+            unsigned int vv = (i == 0 ? v : parents[i-1]);
+            if(STREAM){
+                each_value_clause(vv, [&](const std::vector<literal_t> &literals){ add(literals, -1); });
+                each_exclusion_clause(vv, [&](const std::vector<literal_t> &literals){ add(literals, -1); });
+            } else {
+                for(unsigned int i = 0; i < variable_to_constraints[vv].size(); i++)
+                    e.clauses.push_back(expr.clauses[variable_to_constraints[vv][i]]);
             }
         }
     }
 
-    // divide CPT clauses per variable
-    for(unsigned int i = CONSTRAINTS; i < expr.clauses.size(); i++){
-        unsigned int v = expr.clause_to_variable[i];
-        exprs[v].clauses.push_back(expr.clauses[i]);
+    // add CPT clauses
+    if(STREAM){
+        const weight_t *weights = &(entry_to_weight[bn->cpt_offset[v]]);
+        each_cpt_clause(v, [&](size_t q, const std::vector<literal_t> &literals){
+            if(weights[q] != OMITTED)
+                add(literals, weights[q]);
+        });
+    } else {
+        for(unsigned int i = 0; i < variable_to_clauses[v].size(); i++)
+            e.clauses.push_back(expr.clauses[variable_to_clauses[v][i]]);
     }
 
     // set other variables of expression
-    for(unsigned int i = 0; i < VARIABLES; i++){
-        expression &e = exprs[i];
-        e.map_literals();
-        e.LITERALS = e.literal_to_literal_map.size()-1;
-        e.WEIGHTS = e.weight_to_weight_map.size();
-
-        std::map<unsigned int, unsigned int> variables;
-        e.literal_to_variable.resize(e.LITERALS+1);
-        unsigned int variable = 0;
-        for(unsigned int l = 1; l <= e.LITERALS; l++){
-            literal_t old_l = e.literal_to_literal_map[l];
-            unsigned int old_variable = expr.literal_to_variable[old_l];
-            unsigned int old_values = expr.values[old_variable];
-
-            auto hit = variables.find(old_variable);
-            unsigned int new_variable = variable;
-            if(hit == variables.end())
-                variables[old_variable] = variable++;
-            else new_variable = hit->second;
-
-            e.values.resize(variables.size());
-            e.values[new_variable] = old_values;
-
-            e.variable_to_variable_map.resize(variables.size());
-            e.variable_to_variable_map[new_variable] = old_variable;
-
-            e.literal_to_variable[l] = new_variable;
-        }
-        e.variable_to_literal.resize(e.get_nr_variables());
-        e.variable_to_literal[0] = 1;
-        for(unsigned int i = 1; i < e.values.size(); i++)
-            e.variable_to_literal[i] = e.variable_to_literal[i-1] + e.values[i-1];
+    e.map_literals();
+    e.LITERALS = e.literal_to_literal_map.size()-1;
+    e.WEIGHTS = e.weight_to_weight_map.size();
+
+    std::map<unsigned int, unsigned int> variables;
+    e.literal_to_variable.resize(e.LITERALS+1);
+    unsigned int variable = 0;
+    for(unsigned int l = 1; l <= e.LITERALS; l++){
+        literal_t old_l = e.literal_to_literal_map[l];
+        unsigned int old_variable = expr.literal_to_variable[old_l];
+        unsigned int old_values = expr.values[old_variable];
+
+        auto hit = variables.find(old_variable);
+        unsigned int new_variable = variable;
+        if(hit == variables.end())
+            variables[old_variable] = variable++;
+        else new_variable = hit->second;
+
+        e.values.resize(variables.size());
+        e.values[new_variable] = old_values;
+
+        e.variable_to_variable_map.resize(variables.size());
+        e.variable_to_variable_map[new_variable] = old_variable;
+
+        e.literal_to_variable[l] = new_variable;
     }
+    e.variable_to_literal.resize(e.get_nr_variables());
+    e.variable_to_literal[0] = 1;
+    for(unsigned int i = 1; i < e.values.size(); i++)
+        e.variable_to_literal[i] = e.variable_to_literal[i-1] + e.values[i-1];
 }
 
 void expression::print(){
@@ -716,38 +985,22 @@ void cnf::encode_constraints(){
 
     // variable encoding
     for(unsigned int i = 0; i < bn->size; i++){
-        if(OPT_BOOL && bn->states[i] == 2)
-            continue;
-
-        uint32_t cid = expr.clauses.size();
-        expr.clauses.resize(cid+1);
-        clause_t &c = expr.clauses.back();
-        expr.clause_to_variable.push_back(i);
-        //c.w = -1; // expr.clause_to_weight.push_back(-1);
-        for(unsigned int v = 0; v < bn->states[i]; v++)
-            c.literals.push_back(v_to_l(i,v));
-        CONSTRAINTS++;
+        each_value_clause(i, [&](const std::vector<literal_t> &literals){
+            expr.clauses.resize(expr.clauses.size()+1);
+            expr.clauses.back().literals = literals;
+            expr.clause_to_variable.push_back(i);
+            CONSTRAINTS++;
+        });
     }
 
     // constraint encoding
     for(unsigned int i = 0; i < bn->size; i++){
-        if(OPT_BOOL && bn->states[i] == 2)
-            continue;
-
-        unsigned int values = bn->states[i];
-        uint32_t literal_base = v_to_l(i,0);
-        for(unsigned int v = 0; v < values-1; v++){
-            for(unsigned int vv = v+1; vv < values; vv++){
-                expr.clauses.resize(expr.clauses.size()+1);
-                clause &c = expr.clauses.back();
-                expr.clause_to_variable.push_back(i);
-                //c.w = -1; // clause_to_weight.push_back(-1);
-
-                c.literals.push_back(-1*(literal_base+v));
-                c.literals.push_back(-1*(literal_base+vv));
-                CONSTRAINTS++;
-            }
-        }
+        each_exclusion_clause(i, [&](const std::vector<literal_t> &literals){
+            expr.clauses.resize(expr.clauses.size()+1);
+            expr.clauses.back().literals = literals;
+            expr.clause_to_variable.push_back(i);
+            CONSTRAINTS++;
+        });
     }
 }
 
@@ -763,82 +1016,81 @@ const uint32_t* cnf::get_states() const {
     return bn->states;
 }
 
-void cnf::encode_probabilities(){
+void cnf::encode_probabilities(bool literals){
     //expr.literals.resize(expr.LITERALS+1);
 
-    // weight encoding
+    // every CPT entry yields one clause and one weight, so the block of each
+    // variable is known up front and the blocks can be filled concurrently
+    std::vector<size_t> offset(bn->size+1);
+    offset[0] = 0;
     for(unsigned int i = 0; i < bn->size; i++){
-        unsigned int m = bn->get_parent_size(i);
-        int *max = (int*) malloc(sizeof(int)*(m+1));
-        int *ctr = (int*) malloc(sizeof(int)*(m+1));
-        int *variable = (int*) malloc(sizeof(int)*(m+1));
-        for(unsigned int j = 0; j < m; j++){
-            variable[j] = bn->get_parent(i)[j];
-            max[j] = expr.values[variable[j]];
-            ctr[j] = 0;
-        }
-        variable[m] = i;
-        max[m] = expr.values[i];
-        ctr[m] = 0;
+        size_t entries = expr.values[i];
+        uint32_t *parents = bn->get_parent(i);
+        for(unsigned int j = 0; j < bn->get_parent_size(i); j++)
+            entries *= expr.values[parents[j]];
+        offset[i+1] = offset[i] + entries;
+    }
 
-        int q = 0;
-        while(true){
-            expr.clause_to_variable.push_back(i);
+    const size_t clause_base = expr.clauses.size();
+    const size_t weight_base = weight_to_probability.size();
+    expr.clauses.resize(clause_base + offset[bn->size]);
+    expr.clause_to_variable.resize(clause_base + offset[bn->size]);
+    weight_to_probability.resize(weight_base + offset[bn->size]);
+    expr.WEIGHTS = weight_to_probability.size();
 
-            uint32_t cid = expr.clauses.size();
-            expr.clauses.resize(cid+1);
-            clause_t &c = expr.clauses.back();
+    std::atomic<unsigned int> zero(0), deterministic(0);
 
-            probability_t p = bn->cpt[bn->cpt_offset[i]+q++];
+    // weight encoding
+    parallel_for(bn->size, THREADS, [&](unsigned int i){
+        unsigned int nr_zero = 0, nr_deterministic = 0;
+        for(size_t q = 0; offset[i] + q < offset[i+1]; q++){
+            size_t cid = clause_base + offset[i] + q;
+            expr.clause_to_variable[cid] = i;
+            clause_t &c = expr.clauses[cid];
+
+            probability_t p = bn->cpt[bn->cpt_offset[i]+q];
             if(p == 0)
-                expr.ZERO++;
+                nr_zero++;
 
             if(p == 0 || p == 1)
-                expr.DETERMINISTIC++;
-
-            c.w = weight_to_probability.size(); //clause_to_weight.push_back(weight_to_probability.size());
-            weight_to_probability.push_back(p);
-            expr.WEIGHTS = weight_to_probability.size();
-            //} else clause_to_weight.push_back((uint32_t) p);
-
-            for(unsigned int i = 0; i <= m; i++){
-                uint32_t lid;
-                if(OPT_BOOL && max[i] == 2){
-                    lid = v_to_l(variable[i],0);
-                    if(ctr[i]==1)
-                        c.literals.push_back(-1*lid);
-                    else
-                        c.literals.push_back(lid);
-                    //c.negated.push_back((ctr[i]==1));
-                } else {
-                    lid = v_to_l(variable[i],ctr[i]);
-                    c.literals.push_back(-1*lid);
-                }
+                nr_deterministic++;
 
-                //literal_t &l = expr.literals[lid];
-                //l.clauses.push_back(-1*cid);
-            }
+            c.w = weight_base + offset[i] + q;
+            weight_to_probability[c.w] = p;
+        }
 
-            if(ctr[m] < max[m]-1)
-                ctr[m]++;
-            else {
-                for(int q = m-1; q >= 0; q--){
-                    if(ctr[q] < max[q]-1){
-                        ctr[q]++;
-                        for(unsigned int r = q+1; r <= m; r++)
-                            ctr[r] = 0;
-                        break;
-                    }
-                }
-                if(ctr[m] != 0)
-                    break;
-            }
+        if(literals){
+            each_cpt_clause(i, [&](size_t q, const std::vector<literal_t> &l){
+                expr.clauses[clause_base + offset[i] + q].literals = l;
+            });
         }
 
-        free(max);
-        free(ctr);
-        free(variable);
+        zero += nr_zero;
+        deterministic += nr_deterministic;
+    });
+
+    expr.ZERO += zero;
+    expr.DETERMINISTIC += deterministic;
+}
+
+// the weight of every CPT entry after the optimizations, from clauses without
+// literals that are released afterwards
+void cnf::encode_weights(){
+    encode_probabilities(false);
+    apply_optimization();
+
+    const size_t kEntries = bn->cpt_offset[bn->size];
+    entry_to_weight.resize(kEntries);
+    size_t k = 0;
+    for(size_t q = 0; q < kEntries; q++){
+        if(OPT_SYMPLIFY && bn->cpt[q] == 1)
+            entry_to_weight[q] = OMITTED; // removed by encode_determinism
+        else entry_to_weight[q] = expr.clauses[k++].w;
     }
+    assert(k == expr.clauses.size());
+
+    std::vector<clause>().swap(expr.clauses);
+    array_t().swap(expr.clause_to_variable);
 }
 
 void cnf::encode_determinism(){
@@ -944,7 +1196,7 @@ void cnf::encode_equal_probabilities(){
 }
 
 template <class T>
-void cnf::reduce(std::vector< uint32_t > &clauses, std::vector<clause> &nclauses, std::map<uint32_t,uint32_t> &l_to_i){
+void cnf::reduce(std::vector< uint32_t > &clauses, std::vector<clause> &nclauses, std::map<uint32_t,uint32_t> &l_to_i, std::string &log){
     qm<T> q;
 
     // craeate variables to literal mapping
@@ -1017,7 +1269,7 @@ void cnf::reduce(std::vector< uint32_t > &clauses, std::vector<clause> &nclauses
     for(auto it = constraints.begin(); it != constraints.end(); it++)
         q.remove_prime(*it);
 
-    printf("    #clauses reduced from %lu to %d!\n", clauses.size(), q.get_primes_size());
+    append(log, "    #clauses reduced from %lu to %d!\n", clauses.size(), q.get_primes_size());
     if(clauses.size() < q.get_primes_size())
         fprintf(stderr, "ERROR: nr of clauses increased!!\n");
     //printf("primes %d: ", q.primes.size());
@@ -1036,6 +1288,65 @@ void cnf::reduce(std::vector< uint32_t > &clauses, std::vector<clause> &nclauses
     }
 }
 
+void cnf::minimize(std::vector< uint32_t > &clauses, std::vector<clause> &nclauses, std::map<uint32_t,uint32_t> &l_to_i, std::string &log){
+    espresso e;
+
+    // create variables to literal mapping
+    std::map <unsigned int, std::vector <unsigned int> > v_to_l;
+    for(auto mlit = l_to_i.begin(); mlit != l_to_i.end(); mlit++){
+        e.add_variable(mlit->first, mlit->second);
+        v_to_l[expr.literal_to_variable[mlit->first]].push_back(mlit->first);
+    }
+
+    // assignments that violate the constraint clauses are don't cares
+    for(auto vit = v_to_l.begin(); vit != v_to_l.end(); vit++){
+        std::vector <unsigned int> &literals = vit->second;
+        if(literals.size() < 2)
+            continue;
+
+        // no value is true, only when all values occur in the group
+        if(literals.size() == expr.values[vit->first]){
+            std::vector<int32_t> none;
+            for(unsigned int i = 0; i < literals.size(); i++)
+                none.push_back(-1*literals[i]);
+            e.add_dont_care(none);
+        }
+
+        // two values are true
+        for(unsigned int l1 = 0; l1 < literals.size()-1; l1++){
+            for(unsigned int l2 = l1+1; l2 < literals.size(); l2++){
+                std::vector<int32_t> both;
+                both.push_back(literals[l1]);
+                both.push_back(literals[l2]);
+                e.add_dont_care(both);
+            }
+        }
+    }
+
+    // models, the negation of the clauses
+    for(auto cit = clauses.begin(); cit != clauses.end(); cit++){
+        clause_t &clause = expr.clauses[*cit];
+        std::vector<int32_t> model(clause.literals.size());
+        for(unsigned int i = 0; i < clause.literals.size(); i++)
+            model[i] = -1*clause.literals[i];
+        e.add_model(model);
+    }
+
+    e.solve();
+
+    append(log, "    #clauses reduced from %lu to %d!\n", clauses.size(), e.get_primes_size());
+
+    // copy cubes
+    unsigned int offset = nclauses.size();
+    nclauses.resize(offset+e.get_primes_size());
+    for(unsigned int i = 0; i < e.get_primes_size(); i++){
+        std::vector<int32_t> &l = nclauses[offset+i].literals;
+        e.get_clause(l, i);
+        for(unsigned int j = 0; j < l.size(); j++)
+            l[j] = -1*l[j];
+    }
+}
+
 void cnf::encode_prime(){
     if(expr.clauses.size() > 0){
         qm_variable_count.clear();
@@ -1045,15 +1356,37 @@ void cnf::encode_prime(){
         for(unsigned int i = 0; i < expr.clauses.size(); i++)
             clause_to_weight.push_back(expr.clauses[i].w);
 
-        std::vector<clause> nclauses;
-        std::vector<weight_t> nclause_to_weight;
-        std::vector<uint32_t> nclause_to_variable;
-
-        map<unsigned int, vector<uint32_t> > variable_to_clause;
+        std::vector< std::vector<uint32_t> > variable_to_clause(VARIABLES);
         for(unsigned int c = 0; c < expr.clause_to_variable.size(); c++)
             variable_to_clause[expr.clause_to_variable[c]].push_back(c);
 
-        for(unsigned int v = 0; v < VARIABLES; v++){
+        // the clause groups of a variable are reduced independently of other
+        // variables, so every variable produces its own block of clauses and
+        // output, which are joined in variable order afterwards
+        struct block {
+            std::vector<clause> clauses;
+            std::vector<unsigned int> qm_variable_count;
+            unsigned int qm_eligible;
+            unsigned int qm_possible;
+            std::string log;
+        };
+        std::vector<block> blocks(VARIABLES);
+
+        // hand out the largest CPTs first, so that no thread is left with
+        // a large one at the end
+        std::vector<unsigned int> order(VARIABLES);
+        for(unsigned int v = 0; v < VARIABLES; v++)
+            order[v] = v;
+        std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b){
+            return variable_to_clause[a].size() > variable_to_clause[b].size();
+        });
+
+        parallel_for(VARIABLES, THREADS, [&](unsigned int k){
+            const unsigned int v = order[k];
+            block &b = blocks[v];
+            std::vector<clause> &nclauses = b.clauses;
+            b.qm_eligible = 0;
+            b.qm_possible = 0;
 
             // per variable, group clauses with equal symbolic probability
             map< int, vector<uint32_t> > weight_to_clause;
@@ -1071,78 +1404,89 @@ void cnf::encode_prime(){
                 for(auto cit = clauses.begin(); cit != clauses.end(); cit++){
                     clause_t &clause = expr.clauses[*cit];
                     for(auto lit = clause.literals.begin(); lit != clause.literals.end(); lit++){
-                        if(l_to_i.find(abs(*lit)) == l_to_i.end())
-                            l_to_i[abs(*lit)] = l_to_i.size()-1;
+                        if(l_to_i.find(abs(*lit)) == l_to_i.end()){
+                            const uint32_t index = l_to_i.size();
+                            l_to_i[abs(*lit)] = index;
+                        }
                     }
                 }
 
                 // print current clause group
-                printf("(%u/%u) probability: ", v, VARIABLES);
+                append(b.log, "(%u/%u) probability: ", v, VARIABLES);
                 if(mit->first==-1)
-                    printf("NONE  probability: NONE   ");
-                else printf("%-4d  probability: %-.3f  ", expr.LITERALS+1+mit->first, weight_to_probability[mit->first]);
-                printf("literals: %-4lu  clauses: %-4lu\n", l_to_i.size(), mit->second.size());
-
-                // print participating clauses
-                //for(unsigned int k = 0; k < clauses.size(); k++){
-                //    int i = clauses[k];
-                //    printf("   %3u: v%-4u ", i, expr.clause_to_variable[i]);
-                //    if(get_probability(i) == -1)
-                //        printf("NONE  ");
-                //    else
-                //        printf("p%-4d ",expr.LITERALS+1+clause_to_probability[i]);
-                //    printf("(%-.3f): ", get_probability(i));
-                //    for(unsigned int j = 0; j < expr.clauses[i].literals.size(); j++){
-                //        if(!signbit(expr.clauses[i].literals[j]))
-                //            printf(" %-3d ", expr.clauses[i].literals[j]);
-                //        else
-                //            printf("%-4d ", expr.clauses[i].literals[j]);
-                //    }
-                //    printf("\n");
-                //}
+                    append(b.log, "NONE  probability: NONE   ");
+                else append(b.log, "%-4d  probability: %-.3f  ", expr.LITERALS+1+mit->first, weight_to_probability[mit->first]);
+                append(b.log, "literals: %-4lu  clauses: %-4lu\n", l_to_i.size(), mit->second.size());
 
                 unsigned int offset = nclauses.size();
                 unsigned int CLAUSES = clauses.size();
-                nclause_to_weight.resize(offset+CLAUSES);
-                nclause_to_variable.resize(offset+CLAUSES);
-                for(unsigned int i = 0; i < CLAUSES; i++){
-                    nclause_to_weight[offset+i] = mit->first;
-                    nclause_to_variable[offset+i] = v;
-                }
 
+                // heuristic minimization of clause group, no size limit
+                if(clauses.size() > 1 && OPT_ESPRESSO){
+                    dynamic_assign(b.qm_variable_count, l_to_i.size())++;
+                    b.qm_possible++;
+                    b.qm_eligible++;
+                    minimize(clauses, nclauses, l_to_i, b.log);
                 // perform Quine-McCluskey on clause group
-                if(clauses.size() > 1){
-                    dynamic_assign(qm_variable_count, l_to_i.size())++;
-                    qm_possible++;
+                } else if(clauses.size() > 1){
+                    dynamic_assign(b.qm_variable_count, l_to_i.size())++;
+                    b.qm_possible++;
                     #if __LP64__
                     if((QM_LIMIT > 0 && l_to_i.size() > (unsigned int) QM_LIMIT) || l_to_i.size() > 128){
                     #else
                     if((QM_LIMIT > 0 && l_to_i.size() > (unsigned int) QM_LIMIT) || l_to_i.size() > 64){
                     #endif
-                        printf("  SKIPPED\n");
+                        append(b.log, "  SKIPPED\n");
                         nclauses.resize(offset+CLAUSES);
                         for(unsigned int i = 0; i < CLAUSES; i++)
                             nclauses[offset+i] = expr.clauses[clauses[i]];
                     } else {
-                        qm_eligible++;
+                        b.qm_eligible++;
                         if(l_to_i.size() <= 32)
-                            reduce<uint32_t>(clauses, nclauses, l_to_i);
+                            reduce<uint32_t>(clauses, nclauses, l_to_i, b.log);
                         else if(l_to_i.size() <= 64)
-                            reduce<uint64_t>(clauses, nclauses, l_to_i);
+                            reduce<uint64_t>(clauses, nclauses, l_to_i, b.log);
                         #if __LP64__
                         else if(l_to_i.size() <= 128)
-                            reduce<uint128_t>(clauses, nclauses, l_to_i);
+                            reduce<uint128_t>(clauses, nclauses, l_to_i, b.log);
                         #endif
                     }
                 } else if(clauses.size() == 1) {
                     nclauses.resize(offset+1);
                     nclauses[offset] = expr.clauses[clauses[0]];
                 }
+
+                // reduced clauses keep the probability of their group
+                for(unsigned int i = offset; i < nclauses.size(); i++)
+                    nclauses[i].w = mit->first;
             }
+        });
+
+        std::vector<clause> nclauses;
+        std::vector<uint32_t> nclause_to_variable;
+        size_t total = 0;
+        for(unsigned int v = 0; v < VARIABLES; v++)
+            total += blocks[v].clauses.size();
+        nclauses.reserve(total);
+        nclause_to_variable.reserve(total);
+
+        for(unsigned int v = 0; v < VARIABLES; v++){
+            block &b = blocks[v];
+            fputs(b.log.c_str(), stdout);
+            for(auto it = b.clauses.begin(); it != b.clauses.end(); it++){
+                nclauses.push_back(clause());
+                nclauses.back().w = it->w;
+                nclauses.back().literals.swap(it->literals);
+                nclause_to_variable.push_back(v);
+            }
+            for(unsigned int i = 0; i < b.qm_variable_count.size(); i++)
+                dynamic_assign(qm_variable_count, i) += b.qm_variable_count[i];
+            qm_eligible += b.qm_eligible;
+            qm_possible += b.qm_possible;
+            std::vector<clause>().swap(b.clauses);
         }
         expr.clause_to_variable = nclause_to_variable;
-        clause_to_weight = nclause_to_weight;
-        expr.clauses = nclauses;
+        expr.clauses.swap(nclauses);
     }
 }
 
@@ -1150,11 +1494,18 @@ void cnf::set_qm_limit(int max){
     QM_LIMIT = max;
 }
 
+void cnf::set_threads(unsigned int threads){
+    THREADS = threads;
+    if(THREADS == 0)
+        THREADS = std::max(1u, std::thread::hardware_concurrency());
+}
+
 void cnf::set_optimization(opt_t opt){
     switch(opt){
         case PARTITION:
             if(!OPT_QUINE_MCCLUSKEY) // not implemented when constraints or not at the beginning
                 OPT_PARTITION = true;
+            // fall through
         case EQUAL_PROBABILITIES:
             OPT_EQUAL_PROBABILITIES = true;
             break;
@@ -1165,6 +1516,9 @@ void cnf::set_optimization(opt_t opt){
             OPT_DETERMINISTIC_PROBABILITIES = true;
             OPT_SYMPLIFY = true;
             break;
+        case ESPRESSO:
+            OPT_ESPRESSO = true;
+            // fall through
         case QUINE_MCCLUSKEY:
             OPT_QUINE_MCCLUSKEY = true;
             OPT_EQUAL_PROBABILITIES = true;
@@ -1232,13 +1586,7 @@ const std::vector<probability_t>& cnf::get_weight_to_probability() const {
     return weight_to_probability;
 }
 
-expression_t* cnf::get_expression(int i) const {
-    if(i < 0)
-        return (expression_t*) &expr;
-    else return (expression_t*) &(exprs[i]);
-}
-
-unsigned int cnf::get_nr_expressions() const{
-    return exprs.size();
+expression_t* cnf::get_expression() const {
+    return (expression_t*) &expr;
 }
 
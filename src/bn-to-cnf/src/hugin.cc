@@ -126,13 +126,25 @@ void variable::parse(reader &input, unsigned int d){
         int values = 0;
         do {
             values++;
+            double x;
             if(type == string_variable){
                 input.get_word_equal_or_assert("\"");
                 if(input.get_word_peek_not_equal("\""))
                     value.push_back(input.get_word());
                 input.get_word_equal_or_assert("\"");
-            } else value.push_back(input.get_word());
-        } while(d>0 && input.get_word_peek_not_equal(")"));
+            } else if(value.empty() && input.get_number(x)){
+                number.push_back(x);
+            } else {
+                // not a list of numbers after all, keep all values as words
+                for(auto it = number.begin(); it != number.end(); it++){
+                    char buffer[32];
+                    snprintf(buffer, sizeof(buffer), "%.17g", *it);
+                    value.push_back(buffer);
+                }
+                number.clear();
+                value.push_back(input.get_word());
+            }
+        } while(d>0 && !input.next_char_equal(')'));
         if(d > 0)
             dim[dim.size()-1] = values;
     }
@@ -149,6 +161,8 @@ void variable::print(){
         printf("[%d]", dim[i]);
     for(unsigned int i = 0; i < value.size(); i++)
         printf(" %s", value[i].c_str());
+    for(unsigned int i = 0; i < number.size(); i++)
+        printf(" %g", number[i]);
     printf("\n");
 }
 
@@ -260,8 +274,10 @@ bayesnet* hugin::get_bayesnet(){
             if (n == NULL)
                 throw hugin_error("node '%s' not found to store CPT", words[0].c_str());
 
-            for (unsigned int i = 0; i < attr->value.value.size(); i++)
-                n->cpt.push_back(atof(attr->value.value[i].c_str()));
+            const variable &kData = attr->value;
+            n->cpt.insert(n->cpt.end(), kData.number.begin(), kData.number.end());
+            for (unsigned int i = 0; i < kData.value.size(); i++)
+                n->cpt.push_back(atof(kData.value[i].c_str()));
 
         } else throw hugin_error("node type unknown");
     }
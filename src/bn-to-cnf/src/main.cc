@@ -28,10 +28,12 @@ void help(){
     fprintf(stderr, "         -b: Boolean variables are not mapped\n");
     fprintf(stderr, "         -q: Quine-McCluskey (QM)\n");
     fprintf(stderr, "         -l <limit>: Limit problem size for QM\n");
+    fprintf(stderr, "         -m: Heuristic minimization (Espresso), instead of QM\n");
     fprintf(stderr, "      other:\n");
     fprintf(stderr, "         -i <filename>: Input (HUGIN .net file)\n");
     fprintf(stderr, "         -w: Write CNF in DIMACS format to file\n");
     fprintf(stderr, "         -s: Show stats\n");
+    fprintf(stderr, "         -t <threads>: Threads used for encoding (0 = all cores)\n");
     fprintf(stderr, "         -h: Help\n");
 }
 
@@ -43,7 +45,7 @@ int main(int argc, char **argv){
     char ext[20] = {0};
 
     bool write = false, stats = false;
-    while ((c = getopt(argc, argv, "i:adecswbhpql:")) != -1){
+    while ((c = getopt(argc, argv, "i:adecswbhpqml:t:")) != -1){
         switch (c){
             case 'p': // partitioned
                 f.set_optimization(cnf::opt_t::PARTITION);
@@ -66,6 +68,9 @@ int main(int argc, char **argv){
             case 'q': // bool variables are not mapped
                 f.set_optimization(cnf::opt_t::QUINE_MCCLUSKEY);
                 break;
+            case 'm': // heuristic minimization without size limit
+                f.set_optimization(cnf::opt_t::ESPRESSO);
+                break;
             case 'l': // bool variables are not mapped
                 if(isnumber(optarg))
                     f.set_qm_limit(atoi(optarg));
@@ -74,6 +79,14 @@ int main(int argc, char **argv){
                     return 1;
                 }
                 break;
+            case 't':
+                if(isnumber(optarg) && atoi(optarg) >= 0)
+                    f.set_threads(atoi(optarg));
+                else {
+                    fprintf(stderr, "Argument to option -t (%s) is not a number\n", optarg);
+                    return 1;
+                }
+                break;
             case 'w':
                 write = true;
                 break;
@@ -107,20 +120,12 @@ int main(int argc, char **argv){
         return 1;
     }
 
-    parser<hugin> net;
-    try {
-        net.process(infile);
-    } catch(parser_exception &e){
-        fprintf(stderr, "Failed to parse %s (%s)\n", infile, e.what());
-        return 1;
-    }
-
     bayesnet *bn = NULL;
     try {
-        bn = net.get_bayesnet();
+        bn = bayesnet::read(infile);
         if(bn == NULL)
             fprintf(stderr, "FAILED\n");
-    } catch(throw_string_error &e){
+    } catch(bayesnet_exception &e){
         fprintf(stderr, "error: %s\n", e.what());
         fprintf(stderr, "FAILED\n");
         return -1;
@@ -1,19 +1,21 @@
 #include "reader.h"
 #include <algorithm>
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 using namespace std;
 
 vector<string> reader::string_to_words(string text){
     vector<string> words;
-    FILE * file;
-    file = tmpfile();
-    fputs (text.c_str(), file);
-    rewind(file);
 
     reader input;
     input.add_delimiters(ignore_delimiter, 3, ' ', '\t', '\n', '\r');
-    input.set_fd(file);
+    input.set_buffer(text.data(), text.size());
     while(input.get_word_peek() != input.last_word())
         words.push_back(input.get_word());
 
@@ -22,44 +24,90 @@ vector<string> reader::string_to_words(string text){
 
 
 reader::reader(){
-    file = NULL;
+    data = NULL;
+    size = 0;
+    pos = 0;
+    mapped = false;
+    table_valid = false;
+    reset();
+}
+
+reader::~reader(){
+    close();
+}
+
+void reader::reset(){
     row = 1;
     col = 0;
     hierarchical = true;
     commented = false;
     eof_allowed = true;
+    while(!scope.empty())
+        scope.pop();
 }
 
-reader::~reader(){
+void reader::set_fd(FILE *f){
     close();
+    owned.clear();
+    char buffer[1 << 16];
+    size_t n;
+    while((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+        owned.append(buffer, n);
+    fclose(f);
+
+    data = owned.data();
+    size = owned.size();
 }
 
-void reader::set_fd(FILE *f){
-    file = f;
+void reader::set_buffer(const char *buffer, size_t n){
+    close();
+    owned.assign(buffer, n);
+    data = owned.data();
+    size = owned.size();
 }
 
 bool reader::open(){
-    if(!file && !filename.empty()){
-        file = fopen(filename.c_str(), "r");
-        if(file){
-            row = 1;
-            col = 0;
-            hierarchical = true;
-            commented = false;
-            eof_allowed = true;
-            while(!scope.empty())
-                scope.pop();
-            return true;
+    if(!data && !filename.empty()){
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if(fd < 0)
+            return false;
+
+        struct stat st;
+        if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0){
+            void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(p != MAP_FAILED){
+                madvise(p, st.st_size, MADV_SEQUENTIAL);
+                data = (const char*) p;
+                size = st.st_size;
+                mapped = true;
+            }
         }
+
+        if(!mapped){
+            // not mappable (e.g. a pipe or an empty file), copy it instead
+            owned.clear();
+            char buffer[1 << 16];
+            ssize_t n;
+            while((n = read(fd, buffer, sizeof(buffer))) > 0)
+                owned.append(buffer, n);
+            data = owned.data();
+            size = owned.size();
+        }
+        ::close(fd);
+
+        reset();
+        return true;
     }
     return false;
 }
 
 void reader::close(){
-    if(file){
-        fclose(file);
-        file = NULL;
-    }
+    if(mapped)
+        munmap((void*) data, size);
+    data = NULL;
+    size = 0;
+    pos = 0;
+    mapped = false;
 }
 
 void reader::allow_eof(bool e){
@@ -76,7 +124,8 @@ void reader::unget_char(char c){
         col = 80; // NOTE: total guess :)
     } else col--;
 
-    ungetc(c, file);
+    if(pos > 0)
+        pos--;
 }
 
 void reader::set_filename(string f){
@@ -88,7 +137,7 @@ string reader::get_filename(){
 }
 
 char reader::get_char(){
-    char c = fgetc(file);
+    char c = (pos < size ? data[pos++] : EOF);
     if(c == '\n'){
         row++;
         col = 0;
@@ -146,8 +195,10 @@ void reader::add_delimiter(delimiter_type dt, char c, char ce){
         throw reader_error("scoped delimiters must have ending character");
     else if(!scoped && ce != '\0')
         throw reader_error("ending character provided for non-scoped delimiter");
-    else
+    else {
         delimiters.push_back(create_delimiter(dt,c,ce));
+        table_valid = false;
+    }
 }
 
 bool reader::scoped_delimiter(delimiter_type dt){
@@ -183,18 +234,7 @@ delimiter_t reader::get_delimiter(char c){
                 return scope.top();
             else return create_delimiter(ignore_delimiter, c);
         } else if(hierarchical){
-            delimiter_t *d = NULL;
-            for(unsigned int i = 0; i < delimiters.size(); i++){
-                if(delimiters[i].c == c)
-                    return delimiters[i];
-                else if (scoped_delimiter(delimiters[i].type) && delimiters[i].ce == c){
-                    if(delimiters[i].type != comment_delimiter)
-                        return delimiters[i];
-                    else d = &(delimiters[i]);
-                }
-                if(d != NULL)
-                    return *d;
-            }
+            return lookup(c);
         } else if(!scope.empty()){
             delimiter_t d = scope.top();
             if(d.type == escape_delimiter)
@@ -209,6 +249,34 @@ delimiter_t reader::get_delimiter(char c){
     }
 }
 
+/**
+ * Returns the delimiter of c in hierarchical mode, which only depends on the
+ * delimiters added so far, and is therefore tabulated. The first delimiter
+ * starting with c, or ending with c if it is not a comment, determines it.
+ */
+const delimiter_t& reader::lookup(char c){
+    if(!table_valid){
+        for(unsigned int i = 0; i < 256; i++){
+            const char kC = (char) i;
+            const delimiter_t *d = NULL;
+            for(unsigned int j = 0; j < delimiters.size() && d == NULL; j++){
+                if(delimiters[j].c == kC)
+                    d = &delimiters[j];
+                else if(scoped_delimiter(delimiters[j].type) && delimiters[j].ce == kC)
+                    d = &delimiters[j];
+            }
+
+            if(d != NULL)
+                table[i] = *d;
+            else if(kC == '\\')
+                table[i] = create_delimiter(escape_delimiter, '\\', '*');
+            else table[i] = create_delimiter(no_delimiter, kC);
+        }
+        table_valid = true;
+    }
+    return table[(unsigned char) c];
+}
+
 bool reader::is_delimiter(string w){
     if(w.size() > 1 || w.size() == 0)
         return false;
@@ -264,6 +332,126 @@ string reader::get_word_peek(){
     return bufferword;
 }
 
+/**
+ * Parses a decimal number from [begin,end) and returns the position after it,
+ * or NULL if there is none. Numbers with at most 19 significant digits and a
+ * small exponent are exact in a double, and so is the power of ten scaling
+ * them, thus a single multiplication or division rounds correctly. Others are
+ * left to strtod.
+ */
+static const char* parse_number(const char *begin, const char *end, double &x){
+    static const double kPow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char *p = begin;
+    bool negative = false;
+    if(p != end && (*p == '-' || *p == '+'))
+        negative = (*p++ == '-');
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any = false;
+    bool truncated = false;
+    for(; p != end && *p >= '0' && *p <= '9'; p++, any = true){
+        if(digits < 19){
+            mantissa = 10*mantissa + (*p - '0');
+            if(mantissa > 0) digits++;
+        } else {
+            truncated |= (*p != '0');
+            exponent++;
+        }
+    }
+    if(p != end && *p == '.'){
+        for(p++; p != end && *p >= '0' && *p <= '9'; p++, any = true){
+            if(digits < 19){
+                mantissa = 10*mantissa + (*p - '0');
+                if(mantissa > 0) digits++;
+                exponent--;
+            } else truncated |= (*p != '0');
+        }
+    }
+    if(!any)
+        return NULL;
+
+    if(p != end && (*p == 'e' || *p == 'E')){
+        const char *q = p+1;
+        bool negative_exponent = false;
+        if(q != end && (*q == '-' || *q == '+'))
+            negative_exponent = (*q++ == '-');
+        if(q != end && *q >= '0' && *q <= '9'){
+            int e = 0;
+            for(; q != end && *q >= '0' && *q <= '9'; q++)
+                if(e < 100000) e = 10*e + (*q - '0');
+            exponent += (negative_exponent ? -e : e);
+            p = q;
+        }
+    }
+
+    if(!truncated && mantissa < (UINT64_C(1) << 53) && exponent >= -22 && exponent <= 22){
+        x = (double) mantissa;
+        x = (exponent < 0 ? x / kPow10[-exponent] : x * kPow10[exponent]);
+    } else {
+        const string kNumber(begin, p);
+        x = strtod(kNumber.c_str(), NULL);
+        return p;
+    }
+    if(negative)
+        x = -x;
+    return p;
+}
+
+/**
+ * Reads the next word as a number without constructing it, if it is one.
+ * Otherwise nothing but ignored characters is consumed and false returned,
+ * after which the word can be read by get_word.
+ */
+bool reader::get_number(double &x){
+    if(!bufferword.empty()){
+        const char *kBegin = bufferword.data();
+        const char *kEnd = kBegin + bufferword.size();
+        if(parse_number(kBegin, kEnd, x) != kEnd)
+            return false;
+        bufferword.clear();
+        return true;
+    }
+
+    if(!data || !hierarchical || commented || (!scope.empty() && scope.top().type == escape_delimiter))
+        return false;
+
+    while(pos < size && lookup(data[pos]).type == ignore_delimiter)
+        get_char();
+    if(pos >= size)
+        return false;
+
+    const char *kBegin = data + pos;
+    const char *kEnd = data + size;
+    const char *p = parse_number(kBegin, kEnd, x);
+    if(p == NULL || (p != kEnd && lookup(*p).type == no_delimiter))
+        return false;
+
+    pos += p - kBegin;
+    col += p - kBegin;
+    return true;
+}
+
+/**
+ * Equivalent to get_word_peek_equal for a word consisting of the delimiter c,
+ * but does not construct the next word if it does not start with c.
+ */
+bool reader::next_char_equal(char c){
+    if(bufferword.empty() && data && hierarchical && !commented
+        && (scope.empty() || scope.top().type != escape_delimiter)){
+        while(pos < size && lookup(data[pos]).type == ignore_delimiter)
+            get_char();
+        if(pos < size && lookup(data[pos]).type != comment_delimiter)
+            return data[pos] == c;
+    }
+    return get_word_peek_equal(string(1, c));
+}
+
 string reader::get_word(){
     string word;
     if(!bufferword.empty()){
@@ -271,7 +459,7 @@ string reader::get_word(){
         bufferword.clear();
     } else {
 
-        if(file){
+        if(data){
             char c;
             delimiter_t d;
             do {
@@ -357,6 +545,14 @@ string reader::get_word(){
                     word += c;
                     if(!scope.empty() && scope.top().type == escape_delimiter)
                         scope.pop();
+                    else if(hierarchical && !commented){
+                        // append the rest of a plain word at once
+                        const size_t kBegin = pos;
+                        while(pos < size && data[pos] != '\n' && data[pos] != EOF && lookup(data[pos]).type == no_delimiter)
+                            pos++;
+                        word.append(data + kBegin, pos - kBegin);
+                        col += pos - kBegin;
+                    }
                 }
 
             } while(d.type == no_delimiter);
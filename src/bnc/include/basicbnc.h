@@ -39,6 +39,14 @@ namespace bnc {
         manager->recursive_destroy(n);
     }
 
+    inline void add_root(manager_t *manager, node *n){
+        manager->add_root(n);
+    }
+
+    inline size_t collect_garbage(manager_t *manager, bool force = false){
+        return manager->collect_garbage(force);
+    }
+
     inline void destroy_support(manager_t *manager, node *n){
         manager->destroy_support(n);
     }
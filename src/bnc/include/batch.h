@@ -0,0 +1,49 @@
+#ifndef BNC_BATCH_H
+#define BNC_BATCH_H
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "memory.h"
+#include "timer.h"
+
+struct batch_job_t {
+    std::string line;
+    std::vector<std::string> arguments;
+    unsigned int workers;   // cores reserved while running
+    byte_t memory;          // bytes reserved while running, and the limit of the job
+    pid_t pid;
+    int status;
+    Timer timer;
+};
+
+typedef int (*batch_function_t)(batch_job_t&);
+
+/**
+ * Compiles the networks of a manifest, one job per line given as bnc
+ * arguments. Since options and files are process wide, every job is compiled
+ * in a process of its own, with its output in a log file. Jobs start in
+ * manifest order as soon as their workers and memory fit in what the other
+ * running jobs left of the batch budget, so smaller jobs further down fill
+ * cores that would otherwise idle. A job exceeding the budget runs alone.
+ * A job without a memory limit reserves the share of the budget of its
+ * workers, and is compiled under that share as its limit.
+ */
+class batch_t {
+    public:
+        batch_t(batch_function_t prepare, batch_function_t compile);
+
+        void read(std::string manifest);
+        int run(unsigned int workers, byte_t memory);
+
+        size_t size() const;
+    private:
+        void start(batch_job_t&, size_t);
+
+        batch_function_t prepare;
+        batch_function_t compile;
+        std::string manifest;
+        std::vector<batch_job_t> jobs;
+};
+
+#endif
@@ -13,7 +13,9 @@ namespace bnc {
     template <bool COLLAPSE = true> node* constraints(manager_t*, domain_closure_t&, support_t&, ordering_t&);
     template <bool COLLAPSE = true> node* complete(manager_t*, node*, domain_closure_t&, support_t&, ordering_t&);
     template <bool COLLAPSE = true, bool DETERMINISM = false> node* solve(manager_t*, sat_t&, const ordering_t&);
+    template <bool COLLAPSE = true, bool DETERMINISM = false> node* solve_parallel(manager_t*, sat_t&, const ordering_t&, unsigned int, unsigned int);
     template <bool COLLAPSE = true> void bayesnode_to_wpbdds(bnc::manager_t*, std::queue<bnc::node*>&, BayesNode*, bnc::domain_closure_t&, support_t&, ordering_t&);
+    template <bool COLLAPSE = true> node* sift(manager_t*, node*, ordering_t&, double, unsigned int);
     void write_dot(manager_t*, node*, std::string aux = "", unsigned int id = 0, node *current = NULL);
     void write_dot(manager_t*, std::vector< node*>&, node *current = NULL);
     void write_pdf(std::string aux);
@@ -3,6 +3,7 @@
 
 #include <bn-to-cnf/bayesnet.h>
 #include <vector>
+#include <limits>
 #include <gmpxx.h>
 #include "ordering.h"
 #include "oldbound.h"
@@ -51,6 +52,7 @@ class Bound {
 
         static inline bool IsOverflow(const BoundSize kSize){ return kSize == std::numeric_limits<BoundSize>::max(); };
     private:
+        friend class IncrementalBound;
 
         BoundSize Condition(std::set<Variable> &spanning, const Variable kVariable,unsigned int *, unsigned int *) const;
 
@@ -61,5 +63,61 @@ class Bound {
         size_t size_;
 };
 
+/**
+ * Evaluates Compute<kWeights,double> of a chain ordering incrementally under
+ * swaps of two positions. A variable spans the levels after its position up
+ * to the last position at which one of its constraints is satisfied, so the
+ * spanning set of a level only depends on the set of variables before it.
+ * Swapping positions x1 < x2 thus only changes the levels x1..x2, which are
+ * recomputed from the cached width of level x1. The level bounds are the
+ * leaves of a sum tree, so the total is updated without accumulating rounding
+ * errors. A proposed swap is either accepted or rejected, in which case the
+ * changed entries are restored.
+ */
+class IncrementalBound {
+    public:
+        IncrementalBound(const Bound&);
+
+        void Reset(const ordering_t::value_type*);
+        double Propose(unsigned int x1, unsigned int x2);
+        void Accept();
+        void Reject();
+
+        inline double Get() const { return bound_; }
+        inline double GetRatio() const { return bound_ / (double) bound_ref_.bn_->get_nr_probabilities(); }
+        inline const std::vector<ordering_t::value_type>& GetOrdering() const { return ordering_; }
+    private:
+        static const unsigned int kNone = std::numeric_limits<unsigned int>::max();
+
+        void ComputeLevels(unsigned int begin, unsigned int end);
+        void SumLevels(unsigned int begin, unsigned int end);
+        void UpdateLast(const Variable);
+        void UpdateEnd(const Variable);
+        double ComputeWidth(unsigned int) const;
+
+        const Bound &bound_ref_;
+        const uint32_t *dimension_;
+
+        std::vector<ordering_t::value_type> ordering_;
+        std::vector<unsigned int> position_;    // position of each variable
+        std::vector<unsigned int> last_;        // position at which a constraint is satisfied
+        std::vector<unsigned int> end_;         // last level a variable spans
+        std::vector<unsigned int> satisfied_;   // nr of constraints satisfied per position
+        std::vector<double> width_;             // product of spanning dimensions per position
+        std::vector<double> level_;             // sum tree over the bound per position
+        double bound_;
+
+        // undo log of the proposed swap
+        unsigned int x1_, x2_;
+        std::vector< std::pair<Variable, unsigned int> > old_last_;
+        std::vector< std::pair<Variable, unsigned int> > old_end_;
+        std::vector<unsigned int> old_satisfied_;
+        std::vector<double> old_width_;
+        std::vector<double> old_level_;
+
+        std::vector<size_t> stamp_;
+        size_t tick_;
+};
+
 #endif
 
@@ -9,12 +9,13 @@
 #include "ordering.h"
 #include <bn-to-cnf/bayesnet.h>
 #include <queue>
+#include <atomic>
+#include <pthread.h>
 
 struct bbnode {
     unsigned int variable;
-    unsigned int children;
+    std::atomic<unsigned int> children;
     bbnode *parent;
-    std::vector<bbnode*> child;
     size_t upper_bound;
 };
 
@@ -26,6 +27,27 @@ struct bbnode_ascending {
 
 typedef std::priority_queue< bbnode*, std::vector<bbnode*>, bbnode_ascending > bbqueue;
 
+// per thread node allocator, nodes may be released to the pool of another thread
+class bbpool {
+    public:
+        ~bbpool();
+        bbnode* allocate();
+        void release(bbnode*);
+    private:
+        static const size_t CHUNK = 4096;
+        std::vector<bbnode*> chunks;
+        std::vector<bbnode*> available;
+};
+
+class branchnbound;
+struct bbworker {
+    branchnbound *bb;
+    unsigned int id;
+    bbqueue queue;
+    pthread_mutex_t lock;
+    bbpool pool;
+};
+
 class branchnbound {
     public:
         branchnbound();
@@ -37,6 +59,7 @@ class branchnbound {
         size_t get_treewidth(const unsigned int, const unsigned int);
         void init(bayesnet*,const partition_t &kPartition);
         void bestfirst();
+        static void* bestfirst(void*);
 
         void depthfirst(std::queue<bbnode*> &queue, std::set<unsigned int> variables, bbnode *root, bbstate &state, const unsigned int K);
         void depthfirst(std::queue<bbnode*> &queue, const unsigned int VARIABLES, const unsigned int K);
@@ -47,6 +70,22 @@ class branchnbound {
         void print();
         ordering_t get_ordering();
     private:
+        bbnode* pop(bbworker*);
+        void push(bbworker*, bbnode*);
+        void release(bbworker*, bbnode*);
+        void expand(bbworker*, bbnode*, bbstate&, std::vector<bool>&, std::vector<unsigned int>&);
+        void descend(bbstate&, std::vector<bool>&, std::vector<unsigned int>&, size_t, unsigned int);
+        void found(const std::vector<unsigned int>&, size_t);
+        size_t get_upper_bound(bbstate&);
+
+        std::vector<bbworker*> workers;
+        std::atomic<size_t> incumbent;
+        std::atomic<size_t> pending;
+        std::atomic<size_t> live;
+        pthread_mutex_t solution_lock;
+        ordering_t best_ordering;
+        ordering_t guess;
+
         unsigned int counter;
         bbqueue queue;
         bound_t<false> bound;
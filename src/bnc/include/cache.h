@@ -0,0 +1,59 @@
+#ifndef BNC_CACHE_H
+#define BNC_CACHE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include "files.h"
+
+class compiler;
+
+/**
+ * Store of compile artifacts, addressed by a hash over the contents of the
+ * network, the orderings and partitions read, and the options that determine
+ * the outcome of a compile. An entry is a directory of sets, each holding the
+ * orderings, partition, mapping and circuits of one earlier compile together
+ * with the key material they were compiled from. A set is only used when its
+ * key material equals that of the current compile, so hash collisions are
+ * misses. A compile takes its ordering from a set when present, and is
+ * skipped altogether when one set holds every requested file. Sets are
+ * written to a directory of their own and renamed into the entry as a whole,
+ * so concurrent compiles (e.g. in batch mode) can share the store and never
+ * mix each other's artifacts.
+ */
+class cache_t {
+    public:
+        cache_t();
+
+        void open(std::string directory);
+        bool is_open() const;
+        const std::string& get_key() const;
+
+        bool fetch();
+        bool redirect_ordering();
+        void restore();
+        void store(compiler&);
+
+    private:
+        static std::vector<file_t> get_requested(bool &complete);
+
+        std::string find(const std::vector<file_t>&);
+        bool has(const std::string &set, file_t);
+        bool matches(const std::string &set);
+        void fetch(const std::string &set, file_t);
+        void write(compiler&, const std::string &set, file_t);
+        void redirect(file_t, std::string);
+
+        static std::string get_filename(const std::string &set, file_t);
+        static std::string get_marker(const std::string &set, file_t);
+
+        std::string key;
+        std::string material;
+        std::string entry;
+        std::map<std::string,bool> matched;
+        std::map<file_t,std::string> redirected;
+        bool reading;
+        int order;
+};
+
+#endif
@@ -45,6 +45,9 @@ class compiler {
 
         void clear_stats();
         bnc::node* get_wpbdd();
+        std::vector<bnc::node*>& get_wpbdds();
+        std::vector<bnc::MultiGraphProbability>& get_pmultigraphs();
+        bnc::manager_t& get_manager();
         pthread_function_t get_compile(bool,bool,bool,compilation_t);
     private:
         bdd_t BDD_TYPE;
@@ -5,6 +5,41 @@
 #include <stdlib.h>     /* malloc, free, rand */
 #include <string.h>
 #include <cassert>
+#include <string>
+
+/**
+ * Allocation policy of large dynamic arrays, which otherwise live on the
+ * heap. Arrays of at least kMinBytes are mapped, at huge page boundaries,
+ * when any of the following is set:
+ *  - a directory: arrays are mapped from (unlinked) files in it, so the kernel
+ *    pages them out to disk instead of allocation failing when they exceed
+ *    RAM. Evicting an array writes it out and drops it from memory; it is
+ *    paged back in on access.
+ *  - huge pages: arrays are advised to be backed by transparent huge pages,
+ *    extending the TLB reach of the traversals streaming through them.
+ *  - a NUMA placement: pages are bound to the node of the thread touching
+ *    them first, or interleaved over all nodes.
+ * Report describes the placement the kernel actually provided.
+ */
+class DynamicArrayStorage {
+    public:
+        enum Placement { kDefault, kFirstTouch, kInterleave };
+
+        static const size_t kMinBytes = 1 << 20;
+        static const size_t kHugePageSize = 2 << 20;
+
+        static void SetDirectory(const std::string&);
+        static void SetHugePages(const bool);
+        static void SetPlacement(const Placement);
+        static bool IsEnabled();
+        static bool IsMapped(const size_t kBytes);
+
+        static void* Allocate(const size_t kBytes);
+        static void Release(void*, const size_t kBytes);
+        static void Evict(void*, const size_t kBytes);
+
+        static std::string Report();
+};
 
 template <class T>
 class DynamicArray {
@@ -34,11 +69,14 @@ class DynamicArray {
         }
 
         inline void Clear() {
-            size_ = 0;
             if(data_){
-                free(data_);
+                if(mapped_)
+                    DynamicArrayStorage::Release(data_, size_*sizeof(T));
+                else free(data_);
                 data_ = NULL;
             }
+            size_ = 0;
+            mapped_ = false;
         }
         inline size_t GetSize() const {
             return size_;
@@ -50,10 +88,23 @@ class DynamicArray {
 
         inline bool Resize(size_t size){
             if(size > 0){
-                T *data = (T*) realloc (data_, size * sizeof(T));
+                const bool kMapped = DynamicArrayStorage::IsMapped(size * sizeof(T));
+                T *data;
+                if(!kMapped && !mapped_)
+                    data = (T*) realloc (data_, size * sizeof(T));
+                else {
+                    // moving between heap and mapping (or mappings) copies
+                    data = (T*) (kMapped ? DynamicArrayStorage::Allocate(size * sizeof(T)) : malloc(size * sizeof(T)));
+                    if(data && data_){
+                        memcpy(data, data_, (size < size_ ? size : size_) * sizeof(T));
+                        Clear();
+                    }
+                }
+
                 if(data){
                     data_ = data;
                     size_ = size;
+                    mapped_ = kMapped;
                     return true;
                 }
                 assert(false && "allocation failed");
@@ -62,6 +113,16 @@ class DynamicArray {
             return true;
         }
 
+        // write a mapped array out to its file, it is read back on access
+        inline void Evict(){
+            if(mapped_)
+                DynamicArrayStorage::Evict(data_, size_*sizeof(T));
+        }
+
+        inline bool IsMapped() const {
+            return mapped_;
+        }
+
         inline T* GetRaw() {
             return &(data_[0]);
         }
@@ -79,10 +140,12 @@ class DynamicArray {
         inline void Init(){
             data_ = NULL;
             size_ = 0;
+            mapped_ = false;
         }
 
         T * data_;
         size_t size_;
+        bool mapped_;
 
 };
 
@@ -19,6 +19,7 @@ class filename {
         std::string get_extension(std::string);
         void set_basename(std::string);
         void set_filename(file_t,std::string);
+        void unset_filename(file_t);
         std::string get_filename(file_t,std::string aux = "",std::string postfix = "");
         const char * get_filename_c(file_t,std::string aux = "",std::string postfix = "");
         void store_filename(file_t,std::string&);
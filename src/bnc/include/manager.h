@@ -9,6 +9,7 @@
 #include <bn-to-cnf/bayesnet.h>
 #include "types.h"
 #include "partition.h"
+#include "memory.h"
 
 class manager {
     public:
@@ -40,6 +41,14 @@ class manager {
         void recursive_destroy(node*&);
         void deallocate(node*);
 
+        void set_garbage_collection(bool, byte_t, byte_t);
+        bool get_garbage_collection() const;
+        size_t get_gc_collections() const;
+        size_t get_gc_reclaimed() const;
+        void add_root(node*);
+        void remove_root(node*);
+        size_t collect_garbage(bool force = false);
+
         size_t get_nr_variables();
         const support_t create_variable_support(unsigned int);
         void add_support(node*, unsigned int);
@@ -81,6 +90,7 @@ class manager {
     private:
         //domain_closure_t domain_closure;
         node* allocate();
+        byte_t get_gc_footprint() const;
         node::weights* allocate_weights();
         bayesgraph g;
         bayesnet *bn;
@@ -98,6 +108,17 @@ class manager {
         size_t actual_total_weight_allocations;
         size_t total_node_allocations;
         size_t total_weight_allocations;
+        size_t live_weights;
+
+        // garbage collection
+        std::vector<node*> gc_nodes;
+        std::unordered_map<node*, unsigned int, node::ptr_hash, node::ptr_equal> gc_roots;
+        byte_t gc_threshold;
+        byte_t gc_base;
+        byte_t gc_limit;
+        double gc_weight_size;
+        size_t gc_collections;
+        size_t gc_reclaimed;
 
 };
 
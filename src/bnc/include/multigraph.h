@@ -45,11 +45,28 @@ class MultiGraph : public MultiGraphDef {
 
         Cache &GetCache(){ return cache_; };
 
+        // bytes allocated by the layers, at its peak and currently
+        size_t GetPeakMemory() const { return peak_memory_; };
+        size_t GetMemory() const { return memory_; };
+
     private:
         static void ParallelScheduler(std::vector<MultiGraph> &, const unsigned int);
 
         void AllocateCache(const bool kHasMap);
         void AllocateCacheLayer(const SpanningTreeNode* const kSpanningNode, const bool kHasMap);
+        void ReleaseMap(const SpanningTreeNode* const kSpanningNode);
+
+        // components may be compiled concurrently
+        inline void AddMemory(const size_t kBytes){
+            const size_t kMemory = __sync_add_and_fetch(&memory_, kBytes);
+            size_t peak = peak_memory_;
+            while(kMemory > peak && !__sync_bool_compare_and_swap(&peak_memory_, peak, kMemory))
+                peak = peak_memory_;
+        }
+
+        inline void RemoveMemory(const size_t kBytes){
+            __sync_sub_and_fetch(&memory_, kBytes);
+        }
 
         void DumpDotPrepare(
             std::map< Variable, std::vector<const MultiGraph::Node*>>&,
@@ -105,6 +122,18 @@ class MultiGraph : public MultiGraphDef {
             const unsigned int      kDimension,
             const bool              kExpand);
 
+        bool Live(
+            const SpanningTree      *kSpanningTree,
+            const SpanningTreeNode  *kSpanningNode,
+            const XAry              &xary,
+            const unsigned int      kValue);
+
+        void ComputeReachable(
+            const SpanningTree      *kSpanningTree,
+            const SpanningTreeNode  *kSpanningRoot);
+
+        const std::vector<size_t>* GetContexts(const SpanningTreeNode *kSpanningNode);
+
         template <bool STRUCTURE>
         MultiGraph::Node* Canonical(MultiGraph::Node *node);
 
@@ -117,6 +146,11 @@ class MultiGraph : public MultiGraphDef {
         template<bool STRUCTURE>
         void Compile(const bnc::SpanningTree&);
 
+        template<bool STRUCTURE>
+        static void* CompileComponents(void*);
+
+        Node* JoinComponents(const SpanningTreeNode *kSpanningRoot, Node **roots);
+
         bool initialized_;
 
         bnc::manager_t *manager_;
@@ -131,10 +165,13 @@ class MultiGraph : public MultiGraphDef {
         Cache cache_;
         Node *terminal_;
         Node *root_;
+        size_t memory_;
+        size_t peak_memory_;
         // compilation variables
         std::vector < DynamicArray<size_t> > node_map_;
         std::vector<const unsigned int *> cpt_weights_;
         std::vector<XAry> cpt_ctr_;
+        std::vector< std::vector<size_t> > reachable_; // per layer, empty if all contexts are enumerated
         MultiGraphComputedTable table_;
 };
 
@@ -2,6 +2,8 @@
 #define MULTGRAPHDEF_H
 
 #include "dynamicarray.h"
+#include <vector>
+#include <algorithm>
 
 namespace bnc {
 
@@ -156,6 +158,34 @@ class MultiGraphDef {
             public:
                 DynamicArray<Node*> map;
 
+                // a sparse layer only maps its reachable contexts, map[i] belongs to context ids[i]
+                std::vector<size_t> ids;
+                bool sparse;
+
+                inline Node* Lookup(const size_t kId){
+                    if(!sparse)
+                        return map[kId];
+
+                    auto it = std::lower_bound(ids.begin(), ids.end(), kId);
+                    return (it != ids.end() && *it == kId ? map[it - ids.begin()] : NULL);
+                }
+
+                // the map is only needed until the parent layer has linked to this layer
+                inline void ReleaseMap(){
+                    map.Clear();
+                    std::vector<size_t>().swap(ids);
+                }
+
+                // with out-of-core storage, a finished layer is written out
+                // and only paged back in when the circuit is traversed
+                inline void Evict(){
+                    nodes.Evict();
+                    edges.Evict();
+                    weights.Evict();
+                    and_nodes.Evict();
+                    and_edges.Evict();
+                }
+
             private:
                 DynamicArray<Node> nodes;
                 DynamicArray<Edge> edges;
@@ -173,7 +203,7 @@ class MultiGraphDef {
                 size_t weights_per_edge;
 
             public:
-                CacheLayer() : node_top(0), and_node_top(0), edge_top(0), weight_top(0), edges_per_or(0), edges_per_and(0), weights_per_edge(0) {};
+                CacheLayer() : sparse(false), node_top(0), and_node_top(0), edge_top(0), weight_top(0), edges_per_or(0), edges_per_and(0), weights_per_edge(0) {};
 
                 inline void SetNodeProperties(const size_t kOrEdges, const size_t kAndEdges, const size_t kWeightsPerEdge){
                     edges_per_or = kOrEdges;
@@ -310,6 +340,18 @@ class MultiGraphDef {
                     return node;
                 }
 
+                inline size_t GetBytes() const {
+                    size_t bytes = 0;
+                    bytes += map.GetSize() * sizeof(Node*);
+                    bytes += ids.capacity() * sizeof(size_t);
+                    bytes += nodes.GetSize() * sizeof(Node);
+                    bytes += edges.GetSize() * sizeof(Edge);
+                    bytes += weights.GetSize() * sizeof(unsigned int);
+                    bytes += and_nodes.GetSize() * sizeof(Node);
+                    bytes += and_edges.GetSize() * sizeof(Edge);
+                    return bytes;
+                }
+
                 inline size_t GetMaxNrOrNodes() const {
                     return nodes.GetSize();
                 }
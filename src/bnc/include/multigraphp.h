@@ -41,16 +41,34 @@ class MultiGraphProbability : public MultiGraphProbabilityDef {
         const SpanningTree& GetSpanningTree() const;
 
         const Node *GetRoot() const;
+        const Node *GetTerminal() const;
 
         static void ParallelCompile(std::vector<MultiGraphProbability> &, const unsigned int kNrThreads, Timer &);
 
         Cache &GetCache(){ return cache_; };
 
+        // bytes allocated by the layers, at its peak and currently
+        size_t GetPeakMemory() const { return peak_memory_; };
+        size_t GetMemory() const { return memory_; };
+
     private:
         static void ParallelScheduler(std::vector<MultiGraphProbability> &, const unsigned int);
 
         void AllocateCache(const bool kHasMap);
         void AllocateCacheLayer(const SpanningTreeNode* const kSpanningNode, const bool kHasMap);
+        void ReleaseMap(const SpanningTreeNode* const kSpanningNode);
+
+        // components may be compiled concurrently
+        inline void AddMemory(const size_t kBytes){
+            const size_t kMemory = __sync_add_and_fetch(&memory_, kBytes);
+            size_t peak = peak_memory_;
+            while(kMemory > peak && !__sync_bool_compare_and_swap(&peak_memory_, peak, kMemory))
+                peak = peak_memory_;
+        }
+
+        inline void RemoveMemory(const size_t kBytes){
+            __sync_sub_and_fetch(&memory_, kBytes);
+        }
 
         void DumpDotPrepare(
             std::map< Variable, std::vector<const MultiGraphProbability::Node*>>&,
@@ -106,6 +124,18 @@ class MultiGraphProbability : public MultiGraphProbabilityDef {
             const unsigned int      kDimension,
             const bool              kExpand);
 
+        bool Live(
+            const SpanningTree      *kSpanningTree,
+            const SpanningTreeNode  *kSpanningNode,
+            const XAry              &xary,
+            const unsigned int      kValue);
+
+        void ComputeReachable(
+            const SpanningTree      *kSpanningTree,
+            const SpanningTreeNode  *kSpanningRoot);
+
+        const std::vector<size_t>* GetContexts(const SpanningTreeNode *kSpanningNode);
+
         template <bool STRUCTURE>
         MultiGraphProbability::Node* Canonical(MultiGraphProbability::Node *node);
 
@@ -118,6 +148,11 @@ class MultiGraphProbability : public MultiGraphProbabilityDef {
         template<bool STRUCTURE>
         void Compile(const bnc::SpanningTree&);
 
+        template<bool STRUCTURE>
+        static void* CompileComponents(void*);
+
+        Node* JoinComponents(const SpanningTreeNode *kSpanningRoot, Node **roots);
+
         bool initialized_;
 
         bnc::manager_t *manager_;
@@ -132,10 +167,13 @@ class MultiGraphProbability : public MultiGraphProbabilityDef {
         Cache cache_;
         Node *terminal_;
         Node *root_;
+        size_t memory_;
+        size_t peak_memory_;
         // compilation variables
         std::vector < DynamicArray<size_t> > node_map_;
         std::vector<const Probability*> cpt_probabilities_;
         std::vector<XAry> cpt_ctr_;
+        std::vector< std::vector<size_t> > reachable_; // per layer, empty if all contexts are enumerated
         MultiGraphProbabilityComputedTable table_;
 };
 
@@ -23,6 +23,10 @@ struct weighted_node {
 
     weights *W;
 
+    // when set, reference counts are not maintained and unreachable nodes
+    // are reclaimed in bulk by manager::collect_garbage
+    static bool garbage_collection;
+
     #include "nodedecl.h"
 
     typedef weighted_node_map             map;
@@ -26,11 +26,12 @@ static inline bool is_positive_cofactor(const weighted_node *parent,const weight
 }
 
 static inline bool is_dead(const weighted_node *n){
-    return n->ref == 0;
+    return !garbage_collection && n->ref == 0;
 }
 
 static inline weighted_node* reference(weighted_node *n){
-    n->ref++;
+    if(!garbage_collection)
+        n->ref++;
     return n;
 }
 
@@ -59,6 +60,8 @@ static inline bool collapse_candidate(const weighted_node *n){
 }
 
 static inline void dereference(weighted_node *n){
+    if(garbage_collection)
+        return;
     #ifdef debug
     if(n->ref <= 0)
         fprintf(stderr, "dereferencing unreference node (ref count: %d)\n", n->ref);
@@ -48,6 +48,7 @@ extern bool
     OPT_COLLAPSE,
     OPT_INFO,
     OPT_SA_PARALLELISM,
+    OPT_SA_TEMPERING,
     OPT_PARALLELISM,
     OPT_PARALLEL_CONJOIN,
     OPT_PARALLEL_CUBE,
@@ -57,20 +58,35 @@ extern bool
     OPT_NO_ORDERING,
     OPT_SHOW_SCORE,
     OPT_SA_PRINT_ORDERING,
-    OPT_BEST_COMPOSITION_ORDERING;
+    OPT_BEST_COMPOSITION_ORDERING,
+    OPT_GARBAGE_COLLECTION,
+    OPT_COMPONENT_CACHE,
+    OPT_SPARSE_LAYERS,
+    OPT_HUGE_PAGES;
 
 extern unsigned int OPT_PARALLEL_LEVEL;
+extern unsigned int OPT_CUBE_DEPTH;
 extern int OPT_PARALLEL_CPT;
 extern float OPT_COMPUTED_TABLE_LOAD_FACTOR;
+extern double OPT_GC_THRESHOLD;
+extern unsigned int OPT_SIFT;
+extern double OPT_SIFT_GROWTH;
 extern size_t OPT_COMPUTED_TABLE_BUCKETS;
 extern int OPT_NR_PARTITIONS;
 extern unsigned int OPT_WORKERS;
+extern unsigned int OPT_BB_MEMORY;
+extern unsigned int OPT_MEMORY_LIMIT;
+extern int OPT_ADAPTIVE_PARTITIONS;
+extern std::string OPT_CACHE_DIR;
+extern std::string OPT_OUT_OF_CORE_DIR;
+extern unsigned int OPT_NUMA_PLACEMENT;
 extern int OPT_SA_ITERATIONS;
 extern unsigned int OPT_SA_RUNS;
 extern double OPT_SA_TEMPERATURE_INITIAL;
 extern double OPT_SA_TEMPERATURE_MIN;
 extern double OPT_SA_TEMPERATURE_DAMP_FACTOR;
 extern double OPT_SA_SCORE_RATIO;
+extern double OPT_SA_TIME;
 extern int OPT_SA_TRIES;
 }
 
@@ -14,6 +14,7 @@ typedef std::vector<std::string> string_ordering_t;
 class ordering_t : public std::vector<literal_t> {
     public:
         ordering_t();
+        ordering_t(const ordering_t&);
         ordering_t& operator=(const ordering_t&);
         ordering_t& operator=(ordering_t&);
         const char* get_filename();
@@ -11,7 +11,17 @@
 #include "basicbnc.h"
 #include "satisfy.h"
 
-typedef std::pair<literal_t,unsigned int> history_p;
+// key of a residual formula, see sat::residual
+typedef std::vector<uint64_t> residual_t;
+
+struct residual_hash {
+    size_t operator()(const residual_t &key) const {
+        uint64_t h = 14695981039346656037ULL;
+        for(auto it = key.begin(); it != key.end(); it++)
+            h = (h ^ *it) * 1099511628211ULL;
+        return h;
+    }
+};
 
 class sat {
     public:
@@ -24,13 +34,17 @@ class sat {
         bnc::node::weights* get_weights();
         void print(bool hist = false);
 
+        void track_residual();
+        void residual(unsigned int, residual_t&) const;
+
         void set_manager(manager*);
     private:
         template <bool DETERMINISM = false> void init(BayesNode*);
-        void undo(literal_t, unsigned int);
-        void release_constraint(literal_t);
-        satisfy_t impose_constraint(literal_t);
-        satisfy_t condition(literal_t, std::map<literal_t,unsigned int>&, unsigned int unit_clause = 0);
+        void assign(literal_t);
+        void set_value(literal_t, int8_t);
+        void set_state(literal_t, uint64_t);
+        void open_family(unsigned int);
+        void close_family(unsigned int);
 
         // limit variables
         unsigned int CLAUSES;
@@ -45,19 +59,24 @@ class sat {
         std::vector< unsigned int > variable_to_literal;
         std::map<literal_t, literal_t> literal_map;
         std::vector <weight_t> clause_to_weight;
-        std::vector< std::vector<literal_t> > literal_to_clause;
+        std::vector< unsigned int > clause_begin;
+        std::vector< literal_t > clause_literals;
+        std::vector< std::vector<unsigned int> > families;
+        std::vector< std::vector<unsigned int> > variable_to_families;
 
         // run time variables
-        std::vector< bool > literal_constraint;
-        std::vector< std::vector<literal_t> > history;
+        std::vector< int8_t > literal_value; // 1: positive, -1: negated, 0: free
+        std::vector< std::vector<unsigned int> > watches;
+        std::vector< literal_t > trail;
+        std::vector< size_t > trail_lim;
         std::vector<bool> sat_variable;
-        std::vector<uint8_t> unsat_literals;
-        std::vector<literal_t> sat_literal_clause;
-        unsigned int total_unsat_clauses;
+        std::vector< unsigned int > family_unsat_variables;
         unsigned int total_unsat_variables;
 
-        std::vector< std::multiset<literal_t> > clauses;
-        std::map< literal_t, unsigned int> unit_clauses;
+        // residual key state, see sat::track_residual
+        bool tracking;
+        std::vector< unsigned int > variable_open_families;
+        std::vector< uint64_t > residual_state;
 
         bool mapped;
 
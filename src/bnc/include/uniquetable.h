@@ -0,0 +1,225 @@
+#ifndef UNIQUE_TABLE_H
+#define UNIQUE_TABLE_H
+
+#include "hash.h"
+#include <atomic>
+#include <cassert>
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+
+namespace bnc {
+
+/**
+ * Open addressing unique table with linear probing. Each slot stores the hash
+ * of a node next to its pointer, so probes only compare nodes of which the
+ * hash matches and growing the table does not rehash nodes. The table doubles
+ * once it is half full.
+ *
+ * When concurrent, find_or_insert may be called by multiple threads. A slot
+ * is claimed by swapping its hash in, after which the node is published.
+ * Growing takes the write side of a read-write lock, while lookups and
+ * insertions take the read side. Inserters that find the table half full
+ * grow it after releasing the read side, and new readers wait while a grow
+ * is pending so a grower is not starved.
+ */
+template <class Node, Hash (*HASH)(const Node*)>
+class UniqueTable {
+    public:
+        UniqueTable() : slots_(NULL), capacity_(0), size_(0), concurrent_(false), growing_(0) {
+            pthread_rwlock_init(&lock_, NULL);
+            Allocate(kMinCapacity);
+        }
+
+        ~UniqueTable(){
+            delete[] slots_;
+            pthread_rwlock_destroy(&lock_);
+        }
+
+        UniqueTable(const UniqueTable &other) : slots_(NULL), capacity_(0), size_(0), concurrent_(other.concurrent_), growing_(0) {
+            pthread_rwlock_init(&lock_, NULL);
+            Copy(other);
+        }
+
+        UniqueTable& operator=(const UniqueTable &other){
+            if(this != &other){
+                delete[] slots_;
+                concurrent_ = other.concurrent_;
+                Copy(other);
+            }
+            return *this;
+        }
+
+        inline void set_concurrent(bool concurrent){
+            concurrent_ = concurrent;
+        }
+
+        // reserve room for n nodes, the table still grows when needed
+        void reserve(size_t n){
+            if(n > kMaxReserve)
+                n = kMaxReserve;
+
+            size_t capacity = kMinCapacity;
+            while(capacity < 2*n)
+                capacity <<= 1;
+            if(capacity > capacity_)
+                Grow(capacity);
+        }
+
+        // returns the equal node in the table, or NULL if n was inserted
+        inline Node* find_or_insert(Node *n){
+            Hash hash = HASH(n);
+            if(hash == kEmpty)
+                hash = 1;
+
+            if(concurrent_)
+                LockShared();
+
+            Node *canonical = NULL;
+            size_t size = 0;
+            size_t i = hash & (capacity_-1);
+            while(true){
+                Slot &slot = slots_[i];
+                Hash slot_hash = slot.hash.load(std::memory_order_acquire);
+                if(slot_hash == kEmpty){
+                    if(slot.hash.compare_exchange_strong(slot_hash, hash, std::memory_order_acq_rel)){
+                        slot.node.store(n, std::memory_order_release);
+                        size = size_.fetch_add(1, std::memory_order_relaxed) + 1;
+                        break;
+                    }
+                }
+
+                if(slot_hash == hash){
+                    Node *m;
+                    while(!(m = slot.node.load(std::memory_order_acquire))); // being published
+                    if(*m == *n){
+                        canonical = m;
+                        break;
+                    }
+                }
+                i = (i+1) & (capacity_-1);
+            }
+
+            const size_t kCapacity = capacity_;
+            if(concurrent_)
+                pthread_rwlock_unlock(&lock_);
+
+            // concurrent inserters may all pass the limit, at most one of
+            // them grows the table
+            if(size >= kCapacity/2)
+                Grow(2*kCapacity);
+            return canonical;
+        }
+
+        inline size_t size() const {
+            return size_.load(std::memory_order_relaxed);
+        }
+
+        inline size_t capacity() const {
+            return capacity_;
+        }
+
+        inline void stats() const {
+            size_t probes = 0;
+            size_t max_probes = 0;
+            for(size_t i = 0; i < capacity_; i++){
+                const Hash kHash = slots_[i].hash.load(std::memory_order_relaxed);
+                if(kHash == kEmpty)
+                    continue;
+
+                const size_t kDistance = (i - (kHash & (capacity_-1))) & (capacity_-1);
+                probes += kDistance + 1;
+                if(kDistance + 1 > max_probes)
+                    max_probes = kDistance + 1;
+            }
+
+            printf("Entries         : %lu\n", size());
+            printf("Slots           : %lu\n", capacity_);
+            printf("Load factor     : %lf\n", (double)size()/(double)capacity_);
+            printf("Average probes  : %lf\n", (size() > 0 ? (double)probes/(double)size() : 0.0));
+            printf("Maximal probes  : %lu\n", max_probes);
+            printf("\n");
+        }
+
+    private:
+        struct Slot {
+            std::atomic<Hash> hash;
+            std::atomic<Node*> node;
+        };
+
+        static const Hash kEmpty = 0;
+        static const size_t kMinCapacity = 1024;
+        static const size_t kMaxReserve = 1 << 24;
+
+        // the read side, held back while a grow is pending
+        void LockShared(){
+            while(true){
+                while(growing_.load(std::memory_order_acquire) > 0)
+                    sched_yield();
+                pthread_rwlock_rdlock(&lock_);
+                if(growing_.load(std::memory_order_acquire) == 0)
+                    return;
+                pthread_rwlock_unlock(&lock_);
+            }
+        }
+
+        void Allocate(size_t capacity){
+            slots_ = new Slot[capacity];
+            capacity_ = capacity;
+            for(size_t i = 0; i < capacity; i++){
+                slots_[i].hash.store(kEmpty, std::memory_order_relaxed);
+                slots_[i].node.store(NULL, std::memory_order_relaxed);
+            }
+        }
+
+        void Copy(const UniqueTable &other){
+            Allocate(other.capacity_);
+            for(size_t i = 0; i < capacity_; i++){
+                slots_[i].hash.store(other.slots_[i].hash.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                slots_[i].node.store(other.slots_[i].node.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            size_.store(other.size(), std::memory_order_relaxed);
+        }
+
+        void Grow(size_t capacity){
+            if(concurrent_){
+                growing_.fetch_add(1, std::memory_order_acq_rel);
+                pthread_rwlock_wrlock(&lock_);
+            }
+
+            // another thread may have grown the table already
+            if(capacity > capacity_){
+                Slot *old_slots = slots_;
+                const size_t kOldCapacity = capacity_;
+                Allocate(capacity);
+                for(size_t i = 0; i < kOldCapacity; i++){
+                    const Hash kHash = old_slots[i].hash.load(std::memory_order_relaxed);
+                    if(kHash == kEmpty)
+                        continue;
+
+                    size_t j = kHash & (capacity_-1);
+                    while(slots_[j].hash.load(std::memory_order_relaxed) != kEmpty)
+                        j = (j+1) & (capacity_-1);
+                    slots_[j].hash.store(kHash, std::memory_order_relaxed);
+                    slots_[j].node.store(old_slots[i].node.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                }
+                delete[] old_slots;
+            }
+
+            if(concurrent_){
+                pthread_rwlock_unlock(&lock_);
+                growing_.fetch_sub(1, std::memory_order_acq_rel);
+            }
+        }
+
+        Slot *slots_;
+        size_t capacity_;
+        std::atomic<size_t> size_;
+        bool concurrent_;
+        std::atomic<unsigned int> growing_;
+        pthread_rwlock_t lock_;
+};
+
+}
+
+#endif
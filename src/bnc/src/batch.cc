@@ -0,0 +1,149 @@
+#include "batch.h"
+#include "exceptions.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <wordexp.h>
+#include <sys/wait.h>
+#include <fstream>
+#include <algorithm>
+#include <cerrno>
+
+batch_t::batch_t(batch_function_t prepare, batch_function_t compile){
+    this->prepare = prepare;
+    this->compile = compile;
+}
+
+size_t batch_t::size() const {
+    return jobs.size();
+}
+
+void batch_t::read(std::string manifest){
+    std::ifstream file(manifest.c_str());
+    if(!file)
+        throw compiler_io_exception("Could not open manifest '%s'", manifest.c_str());
+
+    this->manifest = manifest;
+    jobs.clear();
+
+    std::string line;
+    for(unsigned int nr = 1; std::getline(file, line); nr++){
+        size_t begin = line.find_first_not_of(" \t\r");
+        if(begin == std::string::npos || line[begin] == '#')
+            continue;
+
+        wordexp_t p;
+        if(wordexp(line.c_str(), &p, WRDE_NOCMD) != 0)
+            throw compiler_parse_exception("Could not split line %u of manifest '%s'", nr, manifest.c_str());
+
+        batch_job_t job;
+        job.line = line.substr(begin);
+        job.arguments.push_back("bnc");
+        for(size_t i = 0; i < p.we_wordc; i++)
+            job.arguments.push_back(p.we_wordv[i]);
+        wordfree(&p);
+
+        job.workers = 1;
+        job.memory = 0;
+        job.pid = 0;
+        job.status = -1;
+
+        // validate every job before compiling any
+        if(prepare(job) != 0)
+            throw compiler_parse_exception("Invalid job at line %u of manifest '%s': %s", nr, manifest.c_str(), job.line.c_str());
+
+        jobs.push_back(job);
+    }
+}
+
+void batch_t::start(batch_job_t &job, size_t id){
+    std::string log = manifest + "." + std::to_string(id) + ".log";
+
+    fflush(stdout);
+    fflush(stderr);
+    job.timer.Start();
+    job.pid = fork();
+    if(job.pid == 0){
+        int fd = open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd >= 0){
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+        }
+
+        int status = prepare(job);
+        if(status == 0)
+            status = compile(job);
+        fflush(stdout);
+        fflush(stderr);
+        _exit(status);
+    } else if(job.pid < 0)
+        throw compiler_exception("Could not start job '%s': %s", job.line.c_str(), strerror(errno));
+
+    printf("[%lu/%lu] started  : %s (workers: %u, memory: %luMb, log: %s)\n",
+        id+1, jobs.size(), job.line.c_str(), job.workers, job.memory >> 20, log.c_str());
+}
+
+int batch_t::run(const unsigned int kWorkers, const byte_t kMemory){
+    unsigned int free_workers = kWorkers;
+    byte_t free_memory = kMemory;
+    size_t running = 0;
+    size_t failed = 0;
+    std::vector<bool> started(jobs.size(), false);
+
+    // an unbounded job would always fit, so it gets the memory of its workers
+    if(kMemory > 0 && kWorkers > 0){
+        for(auto it = jobs.begin(); it != jobs.end(); it++)
+            if(it->memory == 0)
+                it->memory = std::min(kMemory / kWorkers * it->workers, kMemory);
+    }
+
+    while(true){
+        for(size_t i = 0; i < jobs.size(); i++){
+            batch_job_t &job = jobs[i];
+            if(started[i])
+                continue;
+
+            const bool kFits = job.workers <= free_workers && (kMemory == 0 || job.memory <= free_memory);
+            if(kFits || running == 0){
+                start(job, i);
+                started[i] = true;
+                running++;
+                free_workers -= std::min(job.workers, free_workers);
+                free_memory -= std::min(job.memory, free_memory);
+            }
+        }
+
+        if(running == 0)
+            break;
+
+        int status;
+        pid_t pid = wait(&status);
+        if(pid < 0)
+            throw compiler_exception("Lost track of running jobs: %s", strerror(errno));
+
+        for(size_t i = 0; i < jobs.size(); i++){
+            batch_job_t &job = jobs[i];
+            if(job.pid != pid)
+                continue;
+
+            job.timer.Stop();
+            job.status = (WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status));
+            running--;
+            free_workers = std::min(free_workers + job.workers, kWorkers);
+            free_memory = std::min(free_memory + job.memory, kMemory);
+
+            if(job.status != 0)
+                failed++;
+
+            printf("[%lu/%lu] %s : %s (%.3fs, exit status %d)\n",
+                i+1, jobs.size(), (job.status == 0 ? "done    " : "failed  "),
+                job.line.c_str(), job.timer.GetDuration<Timer::Seconds>(), job.status);
+            break;
+        }
+    }
+
+    printf("Compiled %lu of %lu jobs\n", jobs.size()-failed, jobs.size());
+    return (failed == 0 ? 0 : 1);
+}
@@ -189,6 +189,15 @@ int bayesgraph::encode(bayesnet *bn){
         l += dimension[i];
     }
 
+    // name the literals like read does, so that the mapping can be used
+    // without a round trip through the mapping file
+    variable_value_name_to_literal.clear();
+    for(unsigned int i = 0; i < VARIABLES; i++){
+        auto &values = variable_value_name_to_literal[bn->get_node_name(i)];
+        for (unsigned int v = 0; v < dimension[i]; v++)
+            values[bn->get_node_value_name(i,v)] = variable_to_literal[i] + v;
+    }
+
     // encode equal probabilities per CPT
     for(unsigned int v = 0; v < VARIABLES; v++){
 
@@ -5,6 +5,9 @@
 #include "options.h"
 #include "misc.h"
 #include <algorithm>
+#include <atomic>
+#include <limits>
+#include <pthread.h>
 
 namespace bnc {
 
@@ -181,7 +184,7 @@ inline bool collapse(manager_t *manager, node::table &table, node *&n, ite_t *it
         node *collapsed = n->e;
         n->e = node::reference(n->e->e);
         node::dereference(collapsed);
-        if(collapsed->ref == 0){
+        if(node::is_dead(collapsed)){
             table.erase(collapsed);
             if(ite)
                 ite->remove_cache(collapsed);
@@ -1000,8 +1003,20 @@ bool equal(node *m, node *n){
     return true;
 }
 
+// cube-and-conquer state shared by the splitting and the stitching pass of
+// solve_parallel. Subproblems at level depth are the cubes.
+struct cubes_t {
+    unsigned int depth;
+    std::vector<sat_t> sat;          // theory conditioned on each cube
+    std::vector<unsigned int> level; // level at which each cube continues
+    std::vector<node*> root;         // sub-diagram compiled per cube
+    std::vector<unsigned int> visit; // cube per frontier visit, in dfs order
+    std::unordered_map<residual_t, unsigned int, residual_hash> index;
+    size_t next;
+};
+
 template <const bool COLLAPSE,const bool DETERMINISM>
-node* solve(manager_t *manager, sat_t &sat, const ordering_t &ordering){
+node* solve(manager_t *manager, sat_t &sat, const ordering_t &ordering, unsigned int level, cubes_t *cubes){
     node::table table;
     node *f_0 = create_terminal(manager, false); // contradiction
     node *f_1 = create_terminal(manager, true);  // tautology;
@@ -1016,11 +1031,19 @@ node* solve(manager_t *manager, sat_t &sat, const ordering_t &ordering){
         #define write_td_intermediate_dot
     #endif
 
+    // component cache, maps the residual formula of a subproblem to the
+    // sub-diagram that was compiled for it. keys runs parallel to s.
+    const bool kComponentCache = OPT_COMPONENT_CACHE;
+    std::unordered_map<residual_t, node*, residual_hash> cache;
+    std::stack<residual_t> keys;
+    if(kComponentCache)
+        sat.track_residual();
+
     node::reference_stack s;
     node *root = NULL;
     s.push(&root);
     s.push(&root);
-    unsigned int level = 0;
+    keys.push(residual_t()); // root is not cached
     while(s.size() > 1){
 
         #ifdef DEBUG
@@ -1041,7 +1064,7 @@ node* solve(manager_t *manager, sat_t &sat, const ordering_t &ordering){
                     n->W = sat.get_weights();
                     s.push(&n->t);
                     level++;
-                    break;
+                    goto subproblem;
                 case satisfiable:
                     n = node::reference(create(manager));
                     n->l = l;
@@ -1081,7 +1104,7 @@ node* solve(manager_t *manager, sat_t &sat, const ordering_t &ordering){
                 #endif
                 s.push(&n->e);
                 level++;
-                continue;
+                goto subproblem;
             }
         }
 
@@ -1092,11 +1115,60 @@ node* solve(manager_t *manager, sat_t &sat, const ordering_t &ordering){
         merge(manager, table, n);
         write_td_intermediate_dot;
 
+        if(!keys.top().empty())
+            cache.emplace(std::move(keys.top()), node::reference(n));
+        keys.pop();
+        goto pop;
+
+        subproblem:
+        keys.push(residual_t());
+        if(cubes && level == cubes->depth){
+            if(cubes->root.empty()){
+                // splitting pass, record the cube and continue with a placeholder
+                unsigned int cube = cubes->sat.size();
+                if(kComponentCache){
+                    sat.residual(level, keys.top());
+                    cube = cubes->index.emplace(std::move(keys.top()), cube).first->second;
+                }
+                if(cube == cubes->sat.size()){
+                    cubes->sat.push_back(sat);
+                    cubes->level.push_back(level);
+                }
+                cubes->visit.push_back(cube);
+                *s.top() = node::reference(f_1);
+            } else *s.top() = node::reference(cubes->root[cubes->visit[cubes->next++]]);
+            keys.pop();
+            goto pop;
+        }
+
+        // reuse the sub-diagram of an identical residual formula
+        if(!kComponentCache)
+            continue;
+        sat.residual(level, keys.top());
+        {
+            auto hit = cache.find(keys.top());
+            if(hit == cache.end())
+                continue;
+            *s.top() = node::reference(hit->second);
+            keys.pop();
+        }
+
+        pop:
         sat.undo();
         s.pop();
-        node *m = *s.top();
-        while(m && m->l != ordering[level]) level--;
+        while(*s.top() && (*s.top())->l != ordering[level]) level--;
+    }
+
+    // release the references held by the cache, shielding the terminals
+    node::reference(f_0);
+    node::reference(f_1);
+    for(auto it = cache.begin(); it != cache.end(); it++){
+        node *n = it->second;
+        node::dereference(n);
+        recursive_destroy(manager, n);
     }
+    node::dereference(f_0);
+    node::dereference(f_1);
 
     destroy(manager, f_0); // iff bdd does not have the f_0 node
     destroy(manager, f_1); // iff bdd does not have the f_1 node
@@ -1104,6 +1176,515 @@ node* solve(manager_t *manager, sat_t &sat, const ordering_t &ordering){
     return root;
 }
 
+template <const bool COLLAPSE,const bool DETERMINISM>
+node* solve(manager_t *manager, sat_t &sat, const ordering_t &ordering){
+    return solve<COLLAPSE,DETERMINISM>(manager, sat, ordering, 0, NULL);
+}
+
+// merges (and collapses) all nodes of a diagram of which sub-diagrams were
+// compiled with separate unique tables
+template <bool COLLAPSE>
+void canonicalize(manager_t *manager, node *&root){
+    node::table table;
+    node::reference_stack stack;
+    node::set done;
+    stack.push(&root);
+    while(!stack.empty()){
+        node *&n = *stack.top();
+        if(!done.contains(n)){
+            done.insert(n);
+            if(!node::is_terminal(n)){
+                stack.push(&(n->e));
+                stack.push(&(n->t));
+                continue;
+            }
+        }
+
+        if(COLLAPSE && !node::is_terminal(n))
+            collapse(manager, table, n);
+
+        merge(manager, table, n);
+        stack.pop();
+    }
+}
+
+template <const bool COLLAPSE,const bool DETERMINISM>
+struct cube_worker_t {
+    manager_t *manager;
+    const ordering_t *ordering;
+    cubes_t *cubes;
+    std::atomic<size_t> *next;
+};
+
+template <const bool COLLAPSE,const bool DETERMINISM>
+void* conquer(void *v){
+    cube_worker_t<COLLAPSE,DETERMINISM> &w = *((cube_worker_t<COLLAPSE,DETERMINISM>*) v);
+    cubes_t &cubes = *(w.cubes);
+    for(size_t i = (*w.next)++; i < cubes.sat.size(); i = (*w.next)++)
+        cubes.root[i] = solve<COLLAPSE,DETERMINISM>(w.manager, cubes.sat[i], *(w.ordering), cubes.level[i], NULL);
+    return NULL;
+}
+
+/**
+ * Cube-and-conquer topdown compilation. The search is split on the first depth
+ * literals of the ordering, each cube is compiled by one of the threads on a
+ * private copy of the theory, and the sub-diagrams are stitched under the top
+ * by a second pass over the first depth levels. Identical cubes are compiled
+ * once if the component cache is enabled.
+ */
+template <const bool COLLAPSE,const bool DETERMINISM>
+node* solve_parallel(manager_t *manager, sat_t &sat, const ordering_t &ordering, unsigned int depth, unsigned int threads){
+    cubes_t cubes;
+    cubes.depth = depth;
+    cubes.next = 0;
+
+    node *top = solve<COLLAPSE,DETERMINISM>(manager, sat, ordering, 0, &cubes);
+    if(cubes.visit.empty())
+        return top; // solved before the frontier was reached
+
+    node::dereference(top);
+    recursive_destroy(manager, top);
+
+    // conquer
+    cubes.root.resize(cubes.sat.size(), NULL);
+    if(threads > cubes.sat.size())
+        threads = cubes.sat.size();
+
+    std::atomic<size_t> next(0);
+    cube_worker_t<COLLAPSE,DETERMINISM> worker = { manager, &ordering, &cubes, &next };
+    std::vector<pthread_t> thread(threads);
+    for(unsigned int i = 0; i < threads; i++){
+        if(pthread_create(&(thread[i]), NULL, conquer<COLLAPSE,DETERMINISM>, (void*) &worker))
+            throw compiler_exception("Error creating thread %u of %u", i+1, threads);
+    }
+    for(unsigned int i = 0; i < threads; i++){
+        if(pthread_join(thread[i], NULL))
+            throw compiler_exception("Error joining thread %u of %u", i+1, threads);
+    }
+    cubes.sat.clear();
+
+    // stitch
+    node *root = solve<COLLAPSE,DETERMINISM>(manager, sat, ordering, 0, &cubes);
+    for(auto it = cubes.root.begin(); it != cubes.root.end(); it++){
+        node::dereference(*it);
+        recursive_destroy(manager, *it);
+    }
+    canonicalize<COLLAPSE>(manager, root);
+
+    return root;
+}
+
+// ==== sifting ================================================================
+
+// variable blocks of a literal ordering, the literals of a variable are kept
+// together when variables are moved
+struct sift_ordering_t {
+    std::vector<unsigned int> variables;                // variable per position
+    std::vector<unsigned int> position;                 // position per variable
+    std::vector< std::vector<literal_t> > literals;     // literals per variable
+    std::unordered_map<literal_t, unsigned int> index;  // index of a literal in its block
+    const std::vector<unsigned int> *literal_to_variable;
+
+    inline unsigned int get_position(const node *n) const {
+        return position[(*literal_to_variable)[n->l]];
+    }
+};
+
+static bool sift_init(sift_ordering_t &o, const std::vector<unsigned int> &l2v, const ordering_t &ordering){
+    const unsigned int kNone = std::numeric_limits<unsigned int>::max();
+    o.literal_to_variable = &l2v;
+    o.position.assign(l2v.size(), kNone);
+    o.literals.resize(l2v.size());
+    for(auto it = ordering.begin(); it != ordering.end(); it++){
+        const literal_t l = *it;
+        if(l <= 0 || (unsigned int) l >= l2v.size())
+            return false;
+
+        const unsigned int v = l2v[l];
+        if(o.position[v] == kNone){
+            o.position[v] = o.variables.size();
+            o.variables.push_back(v);
+        } else if(o.variables.back() != v)
+            return false; // literals of a variable are not grouped
+
+        o.index[l] = o.literals[v].size();
+        o.literals[v].push_back(l);
+    }
+    return !o.variables.empty();
+}
+
+/**
+ * Verifies that every path decides the variables in the order of the blocks:
+ * a positive edge leads to the first literal of the next variable (or a
+ * terminal) and a negative edge to a later literal of the same variable (or
+ * f_0). This is the form produced by topdown compilation.
+ */
+static bool sift_validate(const sift_ordering_t &o, node *root, node *&f_0){
+    const unsigned int kLast = o.variables.size() - 1;
+    node::stack s;
+    node::set done;
+    f_0 = NULL;
+    s.push(root);
+    if(!node::is_terminal(root) && (o.index.find(root->l) == o.index.end() || o.get_position(root) != 0 || o.index.at(root->l) != 0))
+        return false;
+
+    while(!s.empty()){
+        node *n = s.top();
+        s.pop();
+        if(done.contains(n))
+            continue;
+        done.insert(n);
+
+        if(node::is_terminal(n)){
+            if(!node::is_satisfiable(n))
+                f_0 = n;
+            continue;
+        }
+
+        const unsigned int kPosition = o.get_position(n);
+        if(node::is_terminal(n->t)){
+            if(node::is_satisfiable(n->t) && kPosition != kLast)
+                return false;
+        } else {
+            auto it = o.index.find(n->t->l);
+            if(it == o.index.end() || it->second != 0 || o.get_position(n->t) != kPosition+1)
+                return false;
+        }
+
+        if(node::is_terminal(n->e)){
+            if(node::is_satisfiable(n->e))
+                return false;
+        } else {
+            auto it = o.index.find(n->e->l);
+            if(it == o.index.end() || o.get_position(n->e) != kPosition || it->second <= o.index.at(n->l))
+                return false;
+        }
+
+        s.push(n->e);
+        s.push(n->t);
+    }
+    return true;
+}
+
+// reads the weights and child per value of the variable that starts at n,
+// values that were collapsed share the weights and child of their predecessor
+static void sift_cofactors(const sift_ordering_t &o, node *n, node *f_0, std::vector< std::pair<node::weights*,node*> > &cofactors, unsigned int values){
+    cofactors.assign(values, std::make_pair((node::weights*) NULL, f_0));
+    while(!node::is_terminal(n)){
+        unsigned int i = o.index.at(n->l);
+        const unsigned int kNext = node::is_terminal(n->e) ? values : o.index.at(n->e->l);
+        for(; i < kNext; i++)
+            cofactors[i] = std::make_pair(n->W, n->t);
+        n = n->e;
+    }
+}
+
+// creates a canonical node, takes over the reference to e
+template <bool COLLAPSE>
+static node* sift_node(manager_t *manager, node::table &table, literal_t l, const node::weights *W, node *t, node *e){
+    node *n = node::reference(create(manager));
+    n->l = l;
+    if(W && !W->empty()){
+        n->W = create_weights(manager);
+        *(n->W) = *W;
+    }
+    n->t = node::reference(t);
+    n->e = e;
+
+    if(COLLAPSE)
+        collapse(manager, table, n);
+    merge(manager, table, n);
+    return n;
+}
+
+// creates the chain of literals of a variable, returns a referenced node
+template <bool COLLAPSE>
+static node* sift_chain(manager_t *manager, node::table &table, const std::vector<literal_t> &literals, const std::vector<node::weights> &W, const std::vector<node*> &child, node *f_0){
+    if(std::all_of(child.begin(), child.end(), [f_0](node *n){ return n == f_0; }))
+        return node::reference(f_0);
+
+    node *e = node::reference(f_0);
+    for(unsigned int i = literals.size(); i-- > 0;)
+        e = sift_node<COLLAPSE>(manager, table, literals[i], &W[i], child[i], e);
+    return e;
+}
+
+// unique subtables per variable, a swap only touches the subtables of the two
+// variables involved
+struct sift_tables_t {
+    std::vector<node::table> table; // nodes per variable
+    size_t nodes;                   // nodes in all subtables
+
+    inline node::table& get(const sift_ordering_t &o, const node *n){
+        return table[(*o.literal_to_variable)[n->l]];
+    }
+};
+
+// releases a reference to n, and the nodes that become unreferenced
+static void sift_release(manager_t *manager, sift_tables_t &tables, const sift_ordering_t &o, node *n){
+    node::dereference(n);
+    node::stack s;
+    if(node::is_dead(n))
+        s.push(n);
+
+    while(!s.empty()){
+        node *n = s.top();
+        s.pop();
+
+        if(!node::is_terminal(n)){
+            tables.get(o, n).erase(n);
+            node *t = n->t;
+            node *e = n->e;
+            destroy(manager, n);
+            if(node::is_dead(t))
+                s.push(t);
+            if(node::is_dead(e))
+                s.push(e);
+        } else destroy(manager, n);
+    }
+}
+
+/**
+ * Splits the diagram that starts at a node of variable u at position p into
+ * the weights per value of v and the children per value of v and u, for
+ * variable v at p+1. The weights of a path through u and v are moved to u,
+ * except those that are shared by all values of u (C). Returns false if a
+ * weight occurs on both u and v of a path, as weights are sets.
+ */
+static bool sift_split(const sift_ordering_t &o, unsigned int p, node *n, node *f_0, std::vector<node::weights> &C, std::vector< std::vector<node::weights> > &S, std::vector< std::vector<node*> > &h){
+    const unsigned int kU = o.variables[p];
+    const unsigned int kV = o.variables[p+1];
+    const unsigned int kValuesU = o.literals[kU].size();
+    const unsigned int kValuesV = o.literals[kV].size();
+
+    std::vector< std::pair<node::weights*,node*> > cu;
+    std::vector< std::vector< std::pair<node::weights*,node*> > > cv(kValuesU);
+    sift_cofactors(o, n, f_0, cu, kValuesU);
+    for(unsigned int i = 0; i < kValuesU; i++)
+        sift_cofactors(o, cu[i].second, f_0, cv[i], kValuesV);
+
+    C.assign(kValuesV, node::weights());
+    S.assign(kValuesV, std::vector<node::weights>(kValuesU));
+    h.assign(kValuesV, std::vector<node*>(kValuesU));
+    for(unsigned int j = 0; j < kValuesV; j++){
+        bool first = true;
+        for(unsigned int i = 0; i < kValuesU; i++){
+            h[j][i] = cv[i][j].second;
+            if(h[j][i] == f_0)
+                continue;
+
+            if(cu[i].first)
+                S[j][i] = *(cu[i].first);
+            if(cv[i][j].first){
+                for(auto it = cv[i][j].first->begin(); it != cv[i][j].first->end(); it++){
+                    if(!S[j][i].insert(*it).second)
+                        return false;
+                }
+            }
+
+            // common weights of all values of u
+            if(first){
+                C[j] = S[j][i];
+                first = false;
+            } else {
+                for(auto it = C[j].begin(); it != C[j].end();){
+                    if(S[j][i].find(*it) == S[j][i].end())
+                        it = C[j].erase(it);
+                    else it++;
+                }
+            }
+        }
+
+        for(unsigned int i = 0; i < kValuesU; i++){
+            for(auto it = C[j].begin(); it != C[j].end(); it++)
+                S[j][i].erase(*it);
+        }
+    }
+    return true;
+}
+
+/**
+ * Swaps the variables u at position p and v at p+1 in place. The nodes that
+ * start a chain of u are the only nodes referenced from above p, they are
+ * rewritten to start the new chain of v so that their parents are untouched.
+ * Returns false, without changing the diagram, if a weight would occur twice
+ * on a path.
+ */
+template <bool COLLAPSE>
+static bool sift_swap(manager_t *manager, sift_tables_t &tables, const sift_ordering_t &o, unsigned int p, node *f_0){
+    const unsigned int kU = o.variables[p];
+    const unsigned int kV = o.variables[p+1];
+    const std::vector<literal_t> &kLiteralsV = o.literals[kV];
+    node::table &table_u = tables.table[kU];
+    node::table &table_v = tables.table[kV];
+
+    std::vector<node*> heads;
+    for(auto it = table_u.begin(); it != table_u.end(); it++){
+        if((*it)->l == o.literals[kU][0])
+            heads.push_back(*it);
+    }
+
+    std::vector<node::weights> C;
+    std::vector< std::vector<node::weights> > S;
+    std::vector< std::vector<node*> > h;
+    for(auto it = heads.begin(); it != heads.end(); it++){
+        if(!sift_split(o, p, *it, f_0, C, S, h))
+            return false;
+    }
+
+    const size_t kBefore = table_u.size() + table_v.size();
+
+    // the heads are keyed by their old content
+    for(auto it = heads.begin(); it != heads.end(); it++)
+        table_u.erase(*it);
+
+    for(auto it = heads.begin(); it != heads.end(); it++){
+        node *n = *it;
+        sift_split(o, p, n, f_0, C, S, h);
+
+        std::vector<node*> U(kLiteralsV.size());
+        for(unsigned int j = 0; j < kLiteralsV.size(); j++)
+            U[j] = sift_chain<COLLAPSE>(manager, table_u, o.literals[kU], S[j], h[j], f_0);
+
+        node *e = node::reference(f_0);
+        for(unsigned int j = kLiteralsV.size(); j-- > 1;)
+            e = sift_node<COLLAPSE>(manager, table_v, kLiteralsV[j], &C[j], U[j], e);
+
+        // rewrite the head, its old children are released after the new
+        // ones are referenced
+        node *t = n->t;
+        node::weights *W = n->W;
+        node *old_e = n->e;
+        n->l = kLiteralsV[0];
+        n->W = NULL;
+        if(!C[0].empty()){
+            n->W = create_weights(manager);
+            *(n->W) = C[0];
+        }
+        n->t = node::reference(U[0]);
+        n->e = e;
+        if(COLLAPSE)
+            collapse(manager, table_v, n);
+
+        #ifdef DEBUG
+        if(table_v.find_or_insert(n))
+            throw compiler_debug_exception("swapped node is not canonical");
+        #else
+        table_v.insert(n);
+        #endif
+
+        for(unsigned int j = 0; j < kLiteralsV.size(); j++)
+            sift_release(manager, tables, o, U[j]);
+        sift_release(manager, tables, o, t);
+        sift_release(manager, tables, o, old_e);
+        destroy_weights(manager, W);
+    }
+
+    tables.nodes += table_u.size() + table_v.size();
+    tables.nodes -= kBefore;
+    return true;
+}
+
+/**
+ * Sifting of the variables of a compiled diagram. Each variable is moved
+ * through all positions of the ordering by swapping adjacent variables, while
+ * the diagram does not grow beyond max_growth times the smallest size seen,
+ * and is then moved back to the position of the smallest diagram. The literals
+ * of a variable stay together. Swaps rewrite the diagram in place, so root
+ * remains the root, and the ordering is updated.
+ */
+template <bool COLLAPSE>
+node* sift(manager_t *manager, node *root, ordering_t &ordering, double max_growth, unsigned int passes){
+    if(manager->get_garbage_collection()){
+        fprintf(stderr, "Warning: sifting requires reference counting, skipping sifting\n");
+        return root;
+    }
+
+    sift_ordering_t o;
+    node *f_0;
+    const std::vector<unsigned int> &l2v = manager->get_bayesgraph().get_literal_to_variable();
+    if(node::is_terminal(root) || !sift_init(o, l2v, ordering) || !sift_validate(o, root, f_0)){
+        fprintf(stderr, "Warning: diagram is not in topdown form, skipping sifting\n");
+        return root;
+    }
+
+    if(!f_0)
+        f_0 = create_terminal(manager, false);
+    node::reference(f_0);
+
+    // the nodes of the diagram per variable
+    sift_tables_t tables;
+    tables.table.resize(o.literals.size());
+    tables.nodes = 0;
+    node::stack s;
+    s.push(root);
+    while(!s.empty()){
+        node *n = s.top();
+        s.pop();
+        if(node::is_terminal(n) || !tables.get(o, n).insert(n).second)
+            continue;
+        tables.nodes++;
+        s.push(n->e);
+        s.push(n->t);
+    }
+
+    const unsigned int kVariables = o.variables.size();
+    const size_t kTerminals = size(root) - tables.nodes;
+    size_t current = size(root);
+    auto move = [&](unsigned int p) -> bool {
+        if(!sift_swap<COLLAPSE>(manager, tables, o, p, f_0))
+            return false;
+
+        std::swap(o.variables[p], o.variables[p+1]);
+        o.position[o.variables[p]] = p;
+        o.position[o.variables[p+1]] = p+1;
+        current = tables.nodes + kTerminals;
+        return true;
+    };
+
+    for(unsigned int pass = 0; pass < passes; pass++){
+        const size_t kBefore = current;
+        const std::vector<unsigned int> kVariableOrdering = o.variables;
+        for(auto it = kVariableOrdering.begin(); it != kVariableOrdering.end(); it++){
+            const unsigned int v = *it;
+            size_t best = current;
+            unsigned int best_position = o.position[v];
+
+            // down
+            while(o.position[v]+1 < kVariables && current <= max_growth * best && move(o.position[v])){
+                if(current < best){
+                    best = current;
+                    best_position = o.position[v];
+                }
+            }
+
+            // up
+            while(o.position[v] > 0 && current <= max_growth * best && move(o.position[v]-1)){
+                if(current < best){
+                    best = current;
+                    best_position = o.position[v];
+                }
+            }
+
+            // back to best position
+            while(o.position[v] < best_position && move(o.position[v]));
+            while(o.position[v] > best_position && move(o.position[v]-1));
+        }
+
+        if(current >= kBefore)
+            break;
+    }
+
+    node::dereference(f_0);
+    destroy(manager, f_0); // iff the diagram does not have the f_0 node
+
+    ordering.clear();
+    for(auto it = o.variables.begin(); it != o.variables.end(); it++)
+        ordering.insert(ordering.end(), o.literals[*it].begin(), o.literals[*it].end());
+
+    return root;
+}
+
 void write_bdd(manager *m, std::vector<node*> &n){
     if(n.size() == 1)
         write_bdd(m, n[0]);
@@ -1292,5 +1873,11 @@ template node* solve<true,true>(manager_t*, sat_t&, const ordering_t&);
 template node* solve<true,false>(manager_t*, sat_t&, const ordering_t&);
 template node* solve<false,true>(manager_t*, sat_t&, const ordering_t&);
 template node* solve<false,false>(manager_t*, sat_t&, const ordering_t&);
+template node* sift<true>(manager_t*, node*, ordering_t&, double, unsigned int);
+template node* sift<false>(manager_t*, node*, ordering_t&, double, unsigned int);
+template node* solve_parallel<true,true>(manager_t*, sat_t&, const ordering_t&, unsigned int, unsigned int);
+template node* solve_parallel<true,false>(manager_t*, sat_t&, const ordering_t&, unsigned int, unsigned int);
+template node* solve_parallel<false,true>(manager_t*, sat_t&, const ordering_t&, unsigned int, unsigned int);
+template node* solve_parallel<false,false>(manager_t*, sat_t&, const ordering_t&, unsigned int, unsigned int);
 
 } // namespace bnc
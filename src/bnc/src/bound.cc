@@ -414,6 +414,221 @@ Bound::BoundSize Bound::ComputeTree(bayesnet *bn, const partition_t &kPartition,
     return bound.ComputeTree<Bound::kNodes, Bound::BoundSize>(kOrdering);
 }
 
+const unsigned int IncrementalBound::kNone;
+
+IncrementalBound::IncrementalBound(const Bound &kBound) : bound_ref_(kBound) {
+    assert(kBound.bn_ != NULL && "Bayesnet must be set first");
+    dimension_ = kBound.bn_->get_states();
+    stamp_.resize(kBound.bn_->get_nr_variables(), 0);
+    tick_ = 0;
+    bound_ = 0;
+}
+
+void IncrementalBound::Reset(const ordering_t::value_type *kOrdering){
+    const unsigned int kNrVariables = bound_ref_.bn_->get_nr_variables();
+    const unsigned int kSize = bound_ref_.size_;
+    const auto &kVariableToConstraint = bound_ref_.variable_to_constraint_;
+    const auto &kConstraintToVariable = bound_ref_.constraint_to_variable_;
+    assert(kConstraintToVariable.size() == kNrVariables && "Likely not initialized");
+
+    ordering_.assign(kOrdering, kOrdering + kSize);
+    position_.assign(kNrVariables, kNone);
+    for(unsigned int i = 0; i < kSize; i++)
+        position_[ordering_[i]] = i;
+
+    // position at which each constraint is satisfied
+    last_.assign(kNrVariables, 0);
+    satisfied_.assign(kSize, 0);
+    for(unsigned int c = 0; c < kNrVariables; c++){
+        const auto &kConstraint = kConstraintToVariable[c];
+        if(kConstraint.empty())
+            continue;
+
+        unsigned int last = 0;
+        for(auto it = kConstraint.begin(); it != kConstraint.end(); it++){
+            assert(position_[*it] != kNone && "Constraint variable not in ordering");
+            last = std::max(last, position_[*it]);
+        }
+        last_[c] = last;
+        satisfied_[last]++;
+    }
+
+    // a variable spans the levels after its position up to end_
+    end_.assign(kNrVariables, 0);
+    for(unsigned int i = 0; i < kSize; i++){
+        const Variable kVariable = ordering_[i];
+        unsigned int end = i;
+        const auto &kConstraints = kVariableToConstraint[kVariable];
+        for(auto it = kConstraints.begin(); it != kConstraints.end(); it++)
+            end = std::max(end, last_[*it]);
+        end_[kVariable] = end;
+    }
+
+    width_.resize(kSize);
+    level_.resize(2*kSize);
+    width_[0] = 1;
+    ComputeLevels(0, kSize-1);
+    SumLevels(0, kSize-1);
+
+    old_last_.clear();
+    old_end_.clear();
+}
+
+double IncrementalBound::ComputeWidth(unsigned int level) const {
+    double width = 1;
+    for(unsigned int i = 0; i < level; i++){
+        const Variable kVariable = ordering_[i];
+        if(end_[kVariable] >= level)
+            width *= dimension_[kVariable];
+    }
+    return width;
+}
+
+void IncrementalBound::ComputeLevels(unsigned int begin, unsigned int end){
+    const auto &kVariableToConstraint = bound_ref_.variable_to_constraint_;
+    const auto &kConstraintToVariable = bound_ref_.constraint_to_variable_;
+
+    for(unsigned int i = begin+1; i <= end; i++){
+        // spanning set of level i from the one of level i-1
+        const unsigned int kPrevious = i-1;
+        const Variable kVariable = ordering_[kPrevious];
+        double width = width_[kPrevious];
+        ++tick_;
+        const auto &kConstraints = kVariableToConstraint[kVariable];
+        for(auto it = kConstraints.begin(); it != kConstraints.end(); it++){
+            if(last_[*it] != kPrevious)
+                continue;
+
+            const auto &kConstraint = kConstraintToVariable[*it];
+            for(auto vit = kConstraint.begin(); vit != kConstraint.end(); vit++){
+                const Variable kSpanningVariable = *vit;
+                if(kSpanningVariable != kVariable && end_[kSpanningVariable] == kPrevious && stamp_[kSpanningVariable] != tick_){
+                    stamp_[kSpanningVariable] = tick_;
+                    width /= dimension_[kSpanningVariable];
+                }
+            }
+        }
+        if(end_[kVariable] > kPrevious)
+            width *= dimension_[kVariable];
+
+        // an overflown width cannot be divided back
+        if(!std::isfinite(width))
+            width = ComputeWidth(i);
+        width_[i] = width;
+    }
+
+    const unsigned int kSize = ordering_.size();
+    for(unsigned int i = begin; i <= end; i++){
+        if(satisfied_[i] == 0)
+            level_[kSize+i] = 0;
+        else
+            level_[kSize+i] = width_[i] * dimension_[ordering_[i]] * satisfied_[i];
+    }
+}
+
+void IncrementalBound::SumLevels(unsigned int begin, unsigned int end){
+    const unsigned int kSize = ordering_.size();
+    begin = (kSize+begin)/2;
+    end = (kSize+end)/2;
+    while(end > 0){
+        // a range may span two depths, thus children go first
+        for(unsigned int i = end+1; i-- > std::max(begin, 1u);)
+            level_[i] = level_[2*i] + level_[2*i+1];
+        begin /= 2;
+        end /= 2;
+    }
+    bound_ = (kSize > 1 ? level_[1] : level_[kSize]);
+}
+
+void IncrementalBound::UpdateEnd(const Variable kVariable){
+    unsigned int end = position_[kVariable];
+    const auto &kConstraints = bound_ref_.variable_to_constraint_[kVariable];
+    for(auto it = kConstraints.begin(); it != kConstraints.end(); it++)
+        end = std::max(end, last_[*it]);
+
+    if(end != end_[kVariable]){
+        old_end_.emplace_back(kVariable, end_[kVariable]);
+        end_[kVariable] = end;
+    }
+}
+
+void IncrementalBound::UpdateLast(const Variable kVariable){
+    const auto &kConstraints = bound_ref_.variable_to_constraint_[kVariable];
+    for(auto it = kConstraints.begin(); it != kConstraints.end(); it++){
+        const Variable kConstraintId = *it;
+        const auto &kConstraint = bound_ref_.constraint_to_variable_[kConstraintId];
+        unsigned int last = 0;
+        for(auto vit = kConstraint.begin(); vit != kConstraint.end(); vit++)
+            last = std::max(last, position_[*vit]);
+
+        if(last != last_[kConstraintId]){
+            old_last_.emplace_back(kConstraintId, last_[kConstraintId]);
+            satisfied_[last_[kConstraintId]]--;
+            satisfied_[last]++;
+            last_[kConstraintId] = last;
+            for(auto vit = kConstraint.begin(); vit != kConstraint.end(); vit++)
+                UpdateEnd(*vit);
+        }
+    }
+}
+
+double IncrementalBound::Propose(unsigned int x1, unsigned int x2){
+    if(x1 > x2)
+        std::swap(x1, x2);
+    x1_ = x1;
+    x2_ = x2;
+    old_last_.clear();
+    old_end_.clear();
+
+    // all changes are confined to the levels x1..x2
+    old_satisfied_.assign(satisfied_.begin() + x1, satisfied_.begin() + x2 + 1);
+    old_width_.assign(width_.begin() + x1, width_.begin() + x2 + 1);
+    const unsigned int kSize = ordering_.size();
+    old_level_.assign(level_.begin() + kSize + x1, level_.begin() + kSize + x2 + 1);
+
+    const Variable kVariable1 = ordering_[x1];
+    const Variable kVariable2 = ordering_[x2];
+    std::swap(ordering_[x1], ordering_[x2]);
+    position_[kVariable1] = x2;
+    position_[kVariable2] = x1;
+
+    UpdateLast(kVariable1);
+    UpdateLast(kVariable2);
+    UpdateEnd(kVariable1);
+    UpdateEnd(kVariable2);
+
+    ComputeLevels(x1, x2);
+    SumLevels(x1, x2);
+
+    return bound_;
+}
+
+void IncrementalBound::Accept(){
+    old_last_.clear();
+    old_end_.clear();
+}
+
+void IncrementalBound::Reject(){
+    const Variable kVariable1 = ordering_[x1_];
+    const Variable kVariable2 = ordering_[x2_];
+    std::swap(ordering_[x1_], ordering_[x2_]);
+    position_[kVariable1] = x2_;
+    position_[kVariable2] = x1_;
+
+    for(auto it = old_last_.rbegin(); it != old_last_.rend(); it++)
+        last_[it->first] = it->second;
+    for(auto it = old_end_.rbegin(); it != old_end_.rend(); it++)
+        end_[it->first] = it->second;
+
+    std::copy(old_satisfied_.begin(), old_satisfied_.end(), satisfied_.begin() + x1_);
+    std::copy(old_width_.begin(), old_width_.end(), width_.begin() + x1_);
+    std::copy(old_level_.begin(), old_level_.end(), level_.begin() + ordering_.size() + x1_);
+    SumLevels(x1_, x2_);
+
+    old_last_.clear();
+    old_end_.clear();
+}
+
 template const Bound::BoundSize Bound::ComputeTree<Bound::kNodes,     Bound::BoundSize>(const ordering_t& ordering) const;
 template const double Bound::ComputeTree<Bound::kNodes,  double>(const ordering_t& ordering) const;
 template const double Bound::ComputeTree<Bound::kScore, double>(const ordering_t& ordering) const;
@@ -1,18 +1,46 @@
 #include "branchnbound.h"
 #include <algorithm>
 #include <limits>
+#include <array>
 #include "bnc.h"
 #include "options.h"
 #include "assert.h"
+#include <thread>
+#include <sched.h>
+
+bbpool::~bbpool(){
+    for(auto it = chunks.begin(); it != chunks.end(); it++)
+        delete[] *it;
+}
+
+bbnode* bbpool::allocate(){
+    if(available.empty()){
+        bbnode *chunk = new bbnode[CHUNK];
+        chunks.push_back(chunk);
+        for(size_t i = CHUNK; i > 0; i--)
+            available.push_back(&(chunk[i-1]));
+    }
+
+    bbnode *node = available.back();
+    available.pop_back();
+    return node;
+}
+
+void bbpool::release(bbnode *node){
+    available.push_back(node);
+}
 
 branchnbound::branchnbound(){
     bn = NULL;
+    root = NULL;
     MAX_UPPER_BOUND = std::numeric_limits<std::size_t>::max();
+    pthread_mutex_init(&solution_lock, NULL);
 }
 
 branchnbound::~branchnbound(){
     for(unsigned int i = 0; i < solutions.size(); i++)
         destroy(solutions[i]);
+    pthread_mutex_destroy(&solution_lock);
 }
 
 void branchnbound::init(bayesnet *bn,const partition_t &kPartition){
@@ -30,6 +58,7 @@ void branchnbound::init(bayesnet *bn,const partition_t &kPartition){
 void branchnbound::bestguess(){
     ordering_t ordering;
     ordering.generate_variable_ordering(bn,*kPartition);
+    guess = ordering;
 
     // TODO: check for overflow
     MAX_UPPER_BOUND = bnc::get_upper_bound(bn, ordering).get_ui();
@@ -53,6 +82,9 @@ void branchnbound::print(){
 }
 
 ordering_t branchnbound::get_ordering(){
+    if(!best_ordering.empty())
+        return best_ordering;
+
     ordering_t ordering;
 
     for(auto it = solutions.begin(); it != solutions.end(); it++){
@@ -67,6 +99,10 @@ ordering_t branchnbound::get_ordering(){
         // TODO select best???
         break;
     }
+
+    // no ordering improved on the initial guess
+    if(ordering.empty())
+        return guess;
     return std::move(ordering);
 }
 
@@ -129,7 +165,6 @@ void branchnbound::depthfirst(std::queue<bbnode*> &queue, const unsigned int VAR
     for(unsigned int variable = 0; variable < VARIABLES; variable++){
         root->children++;
         bbnode *node = new bbnode;
-        root->child.push_back(node);
         counter++;
 
         bound.set_value(state, 0);
@@ -179,7 +214,6 @@ void branchnbound::depthfirst(std::queue<bbnode*> &queue, std::set<unsigned int>
 
         root->children++;
         bbnode *node = new bbnode;
-        root->child.push_back(node);
         counter++;
 
         node->parent = root;
@@ -292,7 +326,6 @@ void branchnbound::lookahead(
 
                         descendant->children++;
                         bbnode *node = new bbnode;
-                        descendant->child.push_back(node);
                         counter++;
 
                         node->upper_bound = upper_bound;
@@ -487,65 +520,237 @@ void branchnbound::lookahead(const unsigned int K){
     }
 }
 
-void branchnbound::bestfirst(){
-    const unsigned int VARIABLES = bn->get_nr_variables();
-    queue.push(root);
-    bbstate state;
-    bound.init(state);
+bbnode* branchnbound::pop(bbworker *worker){
+    const unsigned int THREADS = workers.size();
+    bbnode *node = NULL;
+
+    // own queue first, then steal the best node of another thread
+    for(unsigned int i = 0; i < THREADS && node == NULL; i++){
+        bbworker *victim = workers[(worker->id + i) % THREADS];
+        pthread_mutex_lock(&(victim->lock));
+        if(!victim->queue.empty()){
+            node = victim->queue.top();
+            victim->queue.pop();
+        }
+        pthread_mutex_unlock(&(victim->lock));
+    }
+    return node;
+}
 
-    while(!queue.empty()){
-        bbnode *current_node = queue.top();
-        queue.pop();
+void branchnbound::push(bbworker *worker, bbnode *node){
+    pthread_mutex_lock(&(worker->lock));
+    worker->queue.push(node);
+    pthread_mutex_unlock(&(worker->lock));
+}
 
-        // determine participating variables by ancestors
-        std::vector<unsigned int> history;
-        std::set<unsigned int> variables;
-        for (unsigned int i = 0; i < VARIABLES; i++)
-            variables.insert(variables.end(), i);
-
-        bbnode *ancestor = current_node;
-        while(ancestor->parent != NULL){
-            history.push_back(ancestor->variable);
-            variables.erase(ancestor->variable);
-            ancestor = ancestor->parent;
+// drops a reference to node, releasing it and its ancestors without children
+void branchnbound::release(bbworker *worker, bbnode *node){
+    while(node != NULL && --(node->children) == 0){
+        bbnode *parent = node->parent;
+        worker->pool.release(node);
+        --live;
+        node = parent;
+    }
+}
+
+void branchnbound::found(const std::vector<unsigned int> &history, size_t upper_bound){
+    pthread_mutex_lock(&solution_lock);
+    if(upper_bound < incumbent || (best_ordering.empty() && upper_bound <= incumbent)){
+        best_ordering.assign(history.begin(), history.end());
+        incumbent = upper_bound;
+    }
+    pthread_mutex_unlock(&solution_lock);
+}
+
+// depth-first search below the conditioned state, without allocating nodes
+// a bound beyond size_t is clamped rather than truncated, as a truncated
+// bound would prune against the incumbent shared by all workers
+size_t branchnbound::get_upper_bound(bbstate &state){
+    const mpz_class kValue = bound.get_value(state);
+    return (kValue.fits_ulong_p() ? kValue.get_ui() : MAX_UPPER_BOUND);
+}
+
+void branchnbound::descend(bbstate &state, std::vector<bool> &used, std::vector<unsigned int> &history, size_t value, unsigned int remaining){
+    const unsigned int VARIABLES = used.size();
+    std::vector< std::pair<size_t, unsigned int> > candidates;
+    for(unsigned int variable = 0; variable < VARIABLES; variable++){
+        if(used[variable])
+            continue;
+
+        bound.set_value(state, value);
+        bound.condition(state, variable);
+        size_t upper_bound = get_upper_bound(state);
+        bound.undo(state, variable);
+        if(upper_bound <= incumbent)
+            candidates.emplace_back(upper_bound, variable);
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for(auto it = candidates.begin(); it != candidates.end(); it++){
+        const size_t upper_bound = it->first;
+        const unsigned int variable = it->second;
+        if(upper_bound > incumbent)
+            break;
+
+        history.push_back(variable);
+        if(remaining == 1){
+            found(history, upper_bound);
+        } else {
+            bound.set_value(state, value);
+            bound.condition(state, variable);
+            used[variable] = true;
+            descend(state, used, history, upper_bound, remaining-1);
+            used[variable] = false;
+            bound.undo(state, variable);
         }
+        history.pop_back();
+    }
+}
 
-        // restore correct state
-        bound.reset(state);
-        for(auto back_it = history.rbegin(); back_it != history.rend(); back_it++)
-            bound.condition(state, *back_it);
+void branchnbound::expand(bbworker *worker, bbnode *node, bbstate &state, std::vector<bool> &used, std::vector<unsigned int> &history){
+    const unsigned int VARIABLES = bn->get_nr_variables();
 
-        for(auto it = variables.begin(); it != variables.end(); it++){
-            unsigned int variable = *it;
-            bound.set_value(state, current_node->upper_bound);
+    // hold a reference while expanding, children may be released by other threads
+    node->children = 1;
+    if(node->upper_bound > incumbent){
+        release(worker, node);
+        return;
+    }
+
+    // determine participating variables by ancestors
+    history.clear();
+    for(bbnode *ancestor = node; ancestor->parent != NULL; ancestor = ancestor->parent)
+        history.push_back(ancestor->variable);
+    std::reverse(history.begin(), history.end());
+
+    std::fill(used.begin(), used.end(), false);
+    for(auto it = history.begin(); it != history.end(); it++)
+        used[*it] = true;
+
+    // restore correct state
+    bound.reset(state);
+    for(auto it = history.begin(); it != history.end(); it++)
+        bound.condition(state, *it);
+
+    const unsigned int REMAINING = VARIABLES - history.size();
+    if(live * sizeof(bbnode) > ((size_t) bnc::OPT_BB_MEMORY << 20)){
+        descend(state, used, history, node->upper_bound, REMAINING);
+    } else {
+        for(unsigned int variable = 0; variable < VARIABLES; variable++){
+            if(used[variable])
+                continue;
+
+            bound.set_value(state, node->upper_bound);
             bound.condition(state, variable);
-            // TODO: check for overflow
-            size_t upper_bound = bound.get_value(state).get_ui();
+            size_t upper_bound = get_upper_bound(state);
             bound.undo(state, variable);
+            if(upper_bound > incumbent)
+                continue;
 
-            if(upper_bound <= MAX_UPPER_BOUND){
-                current_node->children++;
-
-                bbnode *node = new bbnode;
-                counter++;
-                current_node->child.push_back(node);
-                node->upper_bound = upper_bound;
-                node->parent = current_node;
-                node->variable = variable;
-                node->children = 0;
-
-                if(variables.size() == 1){
-                    if(upper_bound < MAX_UPPER_BOUND)
-                        solutions.clear();
-
-                    solutions.push_back(node);
-                    MAX_UPPER_BOUND = upper_bound;
-                } else
-                    queue.push(node);
+            if(REMAINING == 1){
+                history.push_back(variable);
+                found(history, upper_bound);
+                history.pop_back();
+            } else {
+                bbnode *child = worker->pool.allocate();
+                child->variable = variable;
+                child->children = 0;
+                child->parent = node;
+                child->upper_bound = upper_bound;
+                ++(node->children);
+                ++pending;
+                ++live;
+                push(worker, child);
             }
+        }
+    }
+    release(worker, node);
+}
 
+void* branchnbound::bestfirst(void *data){
+    bbworker *worker = (bbworker*) data;
+    branchnbound *bb = worker->bb;
+
+    bbstate state;
+    bb->bound.init(state);
+    std::vector<bool> used(bb->bn->get_nr_variables(), false);
+    std::vector<unsigned int> history;
+    while(true){
+        bbnode *node = bb->pop(worker);
+        if(node == NULL){
+            if(bb->pending == 0)
+                break;
+
+            sched_yield();
+            continue;
         }
-        destroy(current_node);
+
+        bb->expand(worker, node, state, used, history);
+        --(bb->pending);
     }
+    return NULL;
 }
 
+/**
+ * Best-first branch and bound over the threads of OPT_WORKERS. Every thread
+ * expands nodes from its own queue and steals the best node of another queue
+ * when its own is empty. The incumbent bound is shared. Once the nodes exceed
+ * OPT_BB_MEMORY Mb, expanded nodes are searched depth-first instead of
+ * queueing their children.
+ */
+void branchnbound::bestfirst(){
+    const unsigned int VARIABLES = bn->get_nr_variables();
+    unsigned int threads = (bnc::OPT_WORKERS > 0 ? bnc::OPT_WORKERS : std::thread::hardware_concurrency());
+    if(threads == 0)
+        threads = 1;
+
+    incumbent = MAX_UPPER_BOUND;
+    pending = 1;
+    live = 1;
+    best_ordering.clear();
+
+    workers.resize(threads);
+    for(unsigned int i = 0; i < threads; i++){
+        workers[i] = new bbworker;
+        workers[i]->bb = this;
+        workers[i]->id = i;
+        pthread_mutex_init(&(workers[i]->lock), NULL);
+    }
+
+    bbnode *start = workers[0]->pool.allocate();
+    start->variable = VARIABLES;
+    start->children = 0;
+    start->parent = NULL;
+    start->upper_bound = 0;
+    workers[0]->queue.push(start);
+
+    if(threads == 1){
+        bestfirst((void*) workers[0]);
+    } else {
+        pthread_t pthreads[threads];
+        for(unsigned int i = 0; i < threads; i++){
+            if(pthread_create(&(pthreads[i]), NULL, branchnbound::bestfirst, (void*) workers[i])){
+                fprintf(stderr, "Error creating thread %u of %u\n", i+1, threads);
+                exit(1);
+            }
+        }
+
+        for(unsigned int i = 0; i < threads; i++){
+            if(pthread_join(pthreads[i], NULL)){
+                fprintf(stderr, "Error joining thread %u of %u\n", i+1, threads);
+                exit(1);
+            }
+        }
+    }
+    MAX_UPPER_BOUND = incumbent;
+
+    for(unsigned int i = 0; i < threads; i++){
+        pthread_mutex_destroy(&(workers[i]->lock));
+        delete workers[i];
+    }
+    workers.clear();
+
+    // the search started from a pooled node
+    destroy(root);
+    root = NULL;
+}
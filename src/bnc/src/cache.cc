@@ -0,0 +1,379 @@
+#include "cache.h"
+#include "compiler.h"
+#include "options.h"
+#include "exceptions.h"
+#include "hash.h"
+#include <exception/stringf.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <glob.h>
+#include <sys/stat.h>
+#include <fstream>
+#include <sstream>
+#include <cerrno>
+
+using namespace bnc;
+
+namespace {
+
+// bump when the layout of entries or the meaning of the key changes
+const char *kCacheVersion = "bnc-cache 2";
+
+// every component is prefixed with its length, so that no two different
+// sequences of components produce the same material
+void add_component(std::string &material, const std::string &bytes){
+    material += stringf("%lu:", (unsigned long) bytes.size());
+    material += bytes;
+}
+
+bool read_file(const std::string &filename, std::string &content){
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if(!file)
+        return false;
+
+    std::ostringstream stream;
+    stream << file.rdbuf();
+    content = stream.str();
+    return true;
+}
+
+void copy_file(const std::string &from, const std::string &to){
+    std::ifstream in(from.c_str(), std::ios::binary);
+    std::ofstream out(to.c_str(), std::ios::binary | std::ios::trunc);
+    if(in && out && in.peek() != EOF)
+        out << in.rdbuf();
+
+    if(!in || !out)
+        throw compiler_io_exception("Could not copy '%s' to '%s'", from.c_str(), to.c_str());
+}
+
+void write_file(const std::string &filename, const std::string &content){
+    std::ofstream out(filename.c_str(), std::ios::binary | std::ios::trunc);
+    out << content;
+    out.close();
+    if(!out)
+        throw compiler_io_exception("Could not write '%s'", filename.c_str());
+}
+
+void make_directory(const std::string &directory){
+    if(mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST)
+        throw compiler_io_exception("Could not create directory '%s': %s", directory.c_str(), strerror(errno));
+}
+
+std::vector<std::string> list(const std::string &pattern, int flags = 0){
+    std::vector<std::string> found;
+    glob_t matches;
+    if(glob(pattern.c_str(), flags, NULL, &matches) == 0){
+        for(size_t i = 0; i < matches.gl_pathc; i++)
+            found.push_back(matches.gl_pathv[i]);
+    }
+    globfree(&matches);
+    return found;
+}
+
+// sets hold plain files only
+void remove_directory(const std::string &directory){
+    std::vector<std::string> found = list(directory + "/*");
+    std::vector<std::string> hidden = list(directory + "/.[!.]*");
+    found.insert(found.end(), hidden.begin(), hidden.end());
+    for(auto it = found.begin(); it != found.end(); it++)
+        unlink(it->c_str());
+    rmdir(directory.c_str());
+}
+
+// an artifact is one file, or one file per partition with the partition id
+// inserted before the extension
+std::vector<std::string> find_artifact(const std::string &filename){
+    const size_t kExtension = filename.find_last_of('.');
+    const std::string kPatterns[2] = {
+        filename,
+        filename.substr(0,kExtension) + ".[0-9]*" + filename.substr(kExtension)
+    };
+
+    std::vector<std::string> found = list(kPatterns[0]);
+    std::vector<std::string> partitioned = list(kPatterns[1]);
+    found.insert(found.end(), partitioned.begin(), partitioned.end());
+    return found;
+}
+
+// orderings and partitions given with -r, of one or more partitions
+void add_read(std::string &material, file_t type){
+    add_component(material, stringf("read %d", (int) type));
+
+    std::string content;
+    if(read_file(files.get_filename(type), content)){
+        add_component(material, "");
+        add_component(material, content);
+    }
+
+    for(unsigned int i = 0; read_file(files.get_filename(type, stringf("%u",i)), content); i++){
+        add_component(material, stringf("%u",i));
+        add_component(material, content);
+    }
+}
+
+// every option that changes the ordering, partition or circuit, but not the
+// ones that only affect resources, reporting or output files
+std::string get_options(){
+    std::string options;
+    options += stringf("type %d %d ", (int) OPT_BDD_TYPE, (int) OPT_COMPILATION_TYPE);
+    options += stringf("encoding %d %d %d %d %d ", OPT_USE_PROBABILITY, OPT_DETERMINISM, OPT_ENCODE_STRUCTURE, OPT_WRITE_BINARY, OPT_ORDER_POST_WEIGHT);
+    options += stringf("partition %d %d %d ", OPT_PARTITION, OPT_NR_PARTITIONS, OPT_BEST_COMPOSITION_ORDERING);
+    options += stringf("compile %d %d %d %d %d %u %.17g ", OPT_NODE_LEVEL_COMPILATION, OPT_COLLAPSE, OPT_TOPDOWN_COMPILATION, OPT_COMPONENT_CACHE, OPT_SPARSE_LAYERS, OPT_SIFT, OPT_SIFT_GROWTH);
+    options += stringf("parallel %d %d %d %d %u %u %d ", OPT_PARALLELISM, OPT_PARALLEL_CONJOIN, OPT_PARALLEL_CUBE, OPT_PARALLEL_PARTITION, OPT_PARALLEL_LEVEL, OPT_CUBE_DEPTH, OPT_PARALLEL_CPT);
+    options += stringf("order %d %d %d %u ", OPT_ORDER, OPT_NO_ORDERING, OPT_LOOKAHEAD, OPT_BB_MEMORY);
+    options += stringf("sa %d %d %u %d %d %d ", OPT_SA_ITERATIONS, OPT_SA_TRIES, OPT_SA_RUNS, OPT_SA_PARALLELISM, OPT_SA_TEMPERING, OPT_SA_READ_ELIM_ORDERING);
+    options += stringf("%.17g %.17g %.17g %.17g %.17g", OPT_SA_TEMPERATURE_INITIAL, OPT_SA_TEMPERATURE_MIN, OPT_SA_TEMPERATURE_DAMP_FACTOR, OPT_SA_SCORE_RATIO, OPT_SA_TIME);
+    return options;
+}
+
+}
+
+cache_t::cache_t(){
+    reading = false;
+    order = -1;
+}
+
+void cache_t::open(std::string directory){
+    std::string network;
+    if(!read_file(files.get_filename(BN), network))
+        throw compiler_io_exception("Could not read network '%s'", files.get_filename_c(BN));
+
+    material.clear();
+    add_component(material, kCacheVersion);
+    add_component(material, network);
+    add_component(material, get_options());
+
+    if(OPT_READ_PARTITION)
+        add_read(material, PARTITION);
+    if(OPT_READ_ORDERING)
+        add_read(material, ORDERING);
+    if(OPT_READ_PSEUDO_ORDERING)
+        add_read(material, PSEUDO_ORDERING);
+    if(OPT_READ_VARIABLE_ORDERING)
+        add_read(material, VARIABLE_ORDERING);
+    if(OPT_READ_ELIM_ORDERING || OPT_SA_READ_ELIM_ORDERING)
+        add_read(material, ELIM_ORDERING);
+
+    Hasher hasher;
+    hasher.Seed(14695981039346656037ULL);
+    for(auto it = material.begin(); it != material.end(); it++)
+        hasher.AddHash((unsigned char) *it);
+
+    key = stringf("%016llx", (unsigned long long) hasher.GetHash());
+    make_directory(directory);
+    entry = directory + "/" + key;
+    make_directory(entry);
+}
+
+bool cache_t::is_open() const {
+    return !entry.empty();
+}
+
+const std::string& cache_t::get_key() const {
+    return key;
+}
+
+std::vector<file_t> cache_t::get_requested(bool &complete){
+    std::vector<file_t> requested;
+    if(OPT_WRITE_PARTITION)
+        requested.push_back(PARTITION);
+    if(OPT_WRITE_ORDERING)
+        requested.push_back(ORDERING);
+    if(OPT_WRITE_ELIM_ORDERING)
+        requested.push_back(ELIM_ORDERING);
+    if(OPT_WRITE_VARIABLE_ORDERING)
+        requested.push_back(VARIABLE_ORDERING);
+    if(OPT_WRITE_COMPOSITION_ORDERING)
+        requested.push_back(COMPOSITION_ORDERING);
+    if(OPT_WRITE_MAPPING)
+        requested.push_back(MAPPING);
+    if(OPT_WRITE_AC)
+        requested.push_back(AC);
+
+    // dot files, pseudo trees and spanning trees are not cached
+    complete = !(OPT_WRITE_DOT || OPT_WRITE_PSEUDO_ORDERING || OPT_WRITE_SPANNING);
+    return requested;
+}
+
+std::string cache_t::get_filename(const std::string &set, file_t type){
+    filename_t filename;
+    filename.set_basename(set + "/artifact.net");
+    return filename.create_filename(type);
+}
+
+std::string cache_t::get_marker(const std::string &set, file_t type){
+    return get_filename(set, type) + ".done";
+}
+
+bool cache_t::has(const std::string &set, file_t type){
+    return files.exists(get_marker(set, type));
+}
+
+// sets are never modified once renamed into the entry
+bool cache_t::matches(const std::string &set){
+    auto it = matched.find(set);
+    if(it != matched.end())
+        return it->second;
+
+    std::string content;
+    const bool kMatches = read_file(set + "/key", content) && content == material;
+    matched[set] = kMatches;
+    return kMatches;
+}
+
+// the first set compiled from the same key material that holds all types
+std::string cache_t::find(const std::vector<file_t> &types){
+    std::vector<std::string> sets = list(entry + "/[0-9]*", GLOB_ONLYDIR);
+    for(auto set = sets.begin(); set != sets.end(); set++){
+        if(!matches(*set))
+            continue;
+
+        bool complete = true;
+        for(auto it = types.begin(); complete && it != types.end(); it++)
+            complete = has(*set, *it);
+        if(complete)
+            return *set;
+    }
+    return "";
+}
+
+void cache_t::fetch(const std::string &set, file_t type){
+    const std::string kFilename = get_filename(set, type);
+    const size_t kExtension = kFilename.find_last_of('.');
+
+    std::vector<std::string> cached = find_artifact(kFilename);
+    for(auto it = cached.begin(); it != cached.end(); it++){
+        std::string aux;
+        if(it->size() != kFilename.size())
+            aux = it->substr(kExtension+1, it->size()-kFilename.size()-1);
+
+        std::string filename = files.get_filename(type, aux);
+        printf("Copying cached %s to %s...\n", it->c_str(), filename.c_str());
+        copy_file(*it, filename);
+    }
+}
+
+bool cache_t::fetch(){
+    bool complete;
+    std::vector<file_t> requested = get_requested(complete);
+    if(!complete || requested.empty())
+        return false;
+
+    const std::string kSet = find(requested);
+    if(kSet.empty())
+        return false;
+
+    printf("Found compiled artifacts in cache (key %s)\n", key.c_str());
+    for(auto it = requested.begin(); it != requested.end(); it++)
+        fetch(kSet, *it);
+    return true;
+}
+
+void cache_t::redirect(file_t type, std::string filename){
+    if(redirected.find(type) == redirected.end())
+        redirected[type] = (files.is_set(type) ? files.get_filename(type) : "");
+    files.set_filename(type, filename);
+}
+
+bool cache_t::redirect_ordering(){
+    if(OPT_NO_ORDERING
+        || OPT_READ_PARTITION
+        || OPT_READ_ORDERING
+        || OPT_READ_PSEUDO_ORDERING
+        || OPT_READ_VARIABLE_ORDERING
+        || OPT_READ_ELIM_ORDERING)
+        return false;
+
+    // the ordering and partition are taken from the same set
+    std::vector<file_t> types(1, VARIABLE_ORDERING);
+    if(OPT_PARTITION)
+        types.push_back(PARTITION);
+
+    const std::string kSet = find(types);
+    if(kSet.empty())
+        return false;
+
+    printf("Reading ordering from cache (key %s)\n", key.c_str());
+    redirect(VARIABLE_ORDERING, get_filename(kSet, VARIABLE_ORDERING));
+    OPT_READ_VARIABLE_ORDERING = true;
+    if(OPT_PARTITION){
+        redirect(PARTITION, get_filename(kSet, PARTITION));
+        OPT_READ_PARTITION = true;
+    }
+
+    // orderings are only read without an ordering strategy
+    order = OPT_ORDER;
+    OPT_ORDER = -1;
+    reading = true;
+    return true;
+}
+
+void cache_t::restore(){
+    for(auto it = redirected.begin(); it != redirected.end(); it++){
+        if(it->second.empty())
+            files.unset_filename(it->first);
+        else files.set_filename(it->first, it->second);
+    }
+    redirected.clear();
+
+    if(reading){
+        OPT_READ_VARIABLE_ORDERING = false;
+        OPT_READ_PARTITION = false;
+        OPT_ORDER = order;
+        reading = false;
+    }
+}
+
+void cache_t::write(compiler &comp, const std::string &set, file_t type){
+    redirect(type, get_filename(set, type));
+    try {
+        comp.write(type);
+    } catch(compiler_exception &e){
+        restore();
+        throw;
+    }
+    restore();
+
+    FILE *file = fopen(get_marker(set, type).c_str(), "w");
+    if(!file)
+        throw compiler_io_exception("Could not mark '%s' in cache", get_filename(set, type).c_str());
+    fclose(file);
+}
+
+void cache_t::store(compiler &comp){
+    bool complete;
+    std::vector<file_t> artifacts = get_requested(complete);
+
+    // the ordering (and partition) let later compiles skip ordering
+    if(!OPT_NO_ORDERING && (!OPT_PARTITION || comp.get_nr_partitions() > 1)){
+        artifacts.push_back(VARIABLE_ORDERING);
+        if(OPT_PARTITION)
+            artifacts.push_back(PARTITION);
+    }
+
+    if(artifacts.empty() || !find(artifacts).empty())
+        return;
+
+    // the set is written in full before it becomes visible in the entry
+    const std::string kDirectory = stringf("%s/.tmp.%d", entry.c_str(), (int) getpid());
+    try {
+        remove_directory(kDirectory);
+        make_directory(kDirectory);
+        write_file(kDirectory + "/key", material);
+        for(auto it = artifacts.begin(); it != artifacts.end(); it++)
+            write(comp, kDirectory, *it);
+
+        for(unsigned int i = 0;; i++){
+            const std::string kSet = stringf("%s/%u", entry.c_str(), i);
+            if(rename(kDirectory.c_str(), kSet.c_str()) == 0)
+                break;
+            if(errno != EEXIST && errno != ENOTEMPTY)
+                throw compiler_io_exception("Could not move '%s' into cache: %s", kDirectory.c_str(), strerror(errno));
+        }
+    } catch(compiler_exception &e){
+        remove_directory(kDirectory);
+        fprintf(stderr, "Warning: could not cache artifacts: %s\n", e.what());
+    }
+}
@@ -298,6 +298,8 @@ void compiler::print_result(){
     } else {
         printf("    Compiled CPTs in  : %.3fs\n", manager.cpt_compile_time);
         printf("    Conjoined CPTs in : %.3fs\n", manager.join_compile_time);
+        if(manager.get_garbage_collection())
+            printf("    Collections       : %lu (%lu nodes reclaimed)\n", manager.get_gc_collections(), manager.get_gc_reclaimed());
     }
     printf("    Total time        : %.3fs\n", manager.total_compile_time);
     printf("    Total time        : %.3fms\n", manager.total_compile_time_ms);
@@ -312,3 +314,15 @@ bnc::node* compiler::get_wpbdd(){
     return wpbdd[0];
 }
 
+std::vector<bnc::node*>& compiler::get_wpbdds(){
+    return wpbdd;
+}
+
+std::vector<bnc::MultiGraphProbability>& compiler::get_pmultigraphs(){
+    return pmultigraphs;
+}
+
+bnc::manager_t& compiler::get_manager(){
+    return manager;
+}
+
@@ -71,6 +71,7 @@ int compiler::compile_multigraph(){
         if(kBnPartitions.size() > 1)
             printf("[Partition %u] ", partition_id);
         printf("Traversed in: %.3lfms\n", traverse_timer.GetDuration<Timer::Milliseconds>());
+        printf("Layer memory: %.3lfMb peak, %.3lfMb final\n", (double) kGraph.GetPeakMemory() / (double) 1000000, (double) kGraph.GetMemory() / (double) 1000000);
 
         manager.total_nodes += size.nodes;
         manager.total_edges += size.edges;
@@ -149,6 +150,7 @@ int compiler::compile_pmultigraph(){
         if(kBnPartitions.size() > 1)
             printf("[Partition %u] ", partition_id);
         printf("Traversed in: %.3lfms\n", traverse_timer.GetDuration<Timer::Milliseconds>());
+        printf("Layer memory: %.3lfMb peak, %.3lfMb final\n", (double) kGraph.GetPeakMemory() / (double) 1000000, (double) kGraph.GetMemory() / (double) 1000000);
 
         manager.total_nodes += size.nodes;
         manager.total_edges += size.edges;
@@ -7,6 +7,7 @@
 #include "threading.h"
 #include <thread>
 #include "mutex.h"
+#include "memory.h"
 #include "misc.h"
 #include <algorithm>
 #include "bnc.h"
@@ -74,6 +75,8 @@ void* compiler::compile_async(void *v){
                 throw compiler_debug_exception("topdown compiler did not create WPBDD for CPT %u\n", variable);
             #endif
             bnc::add_support(&manager,cpt,variable);
+            bnc::add_root(&manager,cpt);
+            bnc::collect_garbage(&manager);
 
             cpts[variable] = cpt;
             data.q_bu.push_async(cpt);
@@ -108,6 +111,13 @@ void* compiler::compile_async(void *v){
             std::queue<bnc::node*> cpt_clauses;
             BayesNode *n = g.get_node(variable);
             bnc::bayesnode_to_wpbdds<false>(&c.manager, cpt_clauses, n, closure, data.support[variable], data.ordering[variable]);
+            if(manager.get_garbage_collection()){
+                for(unsigned int i = 0; i < cpt_clauses.size(); i++){
+                    bnc::add_root(&manager, cpt_clauses.front());
+                    cpt_clauses.push(cpt_clauses.front());
+                    cpt_clauses.pop();
+                }
+            }
             while(cpt_clauses.size() >= 2){
                 bnc::node *bdd1 = cpt_clauses.front();
                 cpt_clauses.pop();
@@ -117,12 +127,15 @@ void* compiler::compile_async(void *v){
                 //bnc::node *bdd = bnc::conjoin<false,true>(&c.manager, partition_id, bdd1, bdd2, data.ordering[variable]);
                 bnc::node *bdd = bnc::conjoin<COLLAPSE,DETERMINISM>(&c.manager, partition_id, bdd1, bdd2, data.ordering[variable]);
                 cpt_clauses.push(bdd);
+                bnc::add_root(&manager, bdd);
 
                 bnc::node::dereference(bdd1);
                 bnc::recursive_destroy(&manager, bdd1);
 
                 bnc::node::dereference(bdd2);
                 bnc::recursive_destroy(&manager, bdd2);
+
+                bnc::collect_garbage(&manager);
             }
             if(cpt_clauses.size() != 1)
                 throw compiler_debug_exception("CPT clauses not generated");
@@ -222,6 +235,7 @@ void* compiler::compile_async(void *v){
             printf("Conjoining with CPT %2u/%u in %6.3fs\n", TOTAL-(data.counter[2]), TOTAL, t.GetDuration<Timer::Seconds>());
             #endif
             data.q_bu.push_async(bdd);
+            bnc::add_root(&manager, bdd);
 
             bnc::node::dereference(bdd1);
             bnc::destroy_support(&manager, bdd1);
@@ -230,6 +244,8 @@ void* compiler::compile_async(void *v){
             bnc::node::dereference(bdd2);
             bnc::destroy_support(&manager, bdd1);
             bnc::recursive_destroy(&manager, bdd2);
+
+            bnc::collect_garbage(&manager);
         }
         data.bdds.push_back(data.q_bu.pop_async());
     }
@@ -325,6 +341,17 @@ int compiler::compile_wpbdd(){
     //manager.reserve_nodes(RESERVE);
     #endif
 
+    // garbage collection replaces reference counting
+    if(OPT_GARBAGE_COLLECTION){
+        if(OPT_PARALLELISM)
+            throw compiler_exception("Garbage collection is not thread safe (set option 'gc' to 0)");
+        if(OPT_SIFT > 0)
+            throw compiler_exception("Sifting is not supported with garbage collection (set option 'gc' to 0)");
+        // the threshold grows with the live set, up to three quarters of RAM
+        const byte_t kThreshold = get_ram_size(OPT_GC_THRESHOLD);
+        manager.set_garbage_collection(true, kThreshold, std::max(kThreshold, get_ram_size(0.75)));
+    }
+
     // hashmap settings
     bnc::computed_table_set_load_factor(&manager,OPT_COMPUTED_TABLE_LOAD_FACTOR);
     bnc::computed_table_rehash(&manager,OPT_COMPUTED_TABLE_BUCKETS);
@@ -369,7 +396,26 @@ int compiler::compile_wpbdd(){
 
         // =========================== compile topdown ===========================
         const ordering_t &ordering = manager.get_ordering(0);
-        if(OPT_COLLAPSE){
+        if(OPT_PARALLELISM && OPT_PARALLEL_CUBE){
+            unsigned int threads = OPT_WORKERS > 0 ? OPT_WORKERS : std::thread::hardware_concurrency();
+            if(threads == 0)
+                threads = 1;
+
+            // by default split into about four cubes per thread
+            unsigned int depth = OPT_CUBE_DEPTH;
+            if(depth == 0)
+                while((1u << depth) < 4*threads) depth++;
+
+            if(OPT_COLLAPSE){
+                if(OPT_DETERMINISM)
+                    wpbdd.push_back(bnc::solve_parallel<true,true>(&manager, sat, ordering, depth, threads));
+                else wpbdd.push_back(bnc::solve_parallel<true,false>(&manager, sat, ordering, depth, threads));
+            } else {
+                if(OPT_DETERMINISM)
+                    wpbdd.push_back(bnc::solve_parallel<false,true>(&manager, sat, ordering, depth, threads));
+                else wpbdd.push_back(bnc::solve_parallel<false,false>(&manager, sat, ordering, depth, threads));
+            }
+        } else if(OPT_COLLAPSE){
             if(OPT_DETERMINISM)
                 wpbdd.push_back(bnc::solve<true,true>(&manager, sat, ordering));
             else wpbdd.push_back(bnc::solve<true,false>(&manager, sat, ordering));
@@ -383,6 +429,25 @@ int compiler::compile_wpbdd(){
         data.total_timer.Add();
     }
 
+    // ============================== sifting ================================
+    if(OPT_SIFT > 0){
+        if(wpbdd.size() != 1 || partitions.size() != 1)
+            fprintf(stderr, "Warning: sifting requires a single partition, skipping sifting\n");
+        else {
+            Timer sift_timer;
+            sift_timer.Start();
+            ordering_t ordering = manager.get_ordering(0);
+            const size_t kBefore = bnc::size(wpbdd[0]);
+            if(OPT_COLLAPSE)
+                wpbdd[0] = bnc::sift<true>(&manager, wpbdd[0], ordering, OPT_SIFT_GROWTH, OPT_SIFT);
+            else wpbdd[0] = bnc::sift<false>(&manager, wpbdd[0], ordering, OPT_SIFT_GROWTH, OPT_SIFT);
+            manager.set_ordering(ordering);
+            partitions[0].variable_ordering = ordering.get_literal_to_variable_ordering(g);
+            sift_timer.Stop();
+            printf("Sifted WPBDD from %lu to %lu nodes in %.3fs\n", kBefore, bnc::size(wpbdd[0]), sift_timer.GetDuration<Timer::Seconds>());
+        }
+    }
+
     manager.total_compile_time = data.total_timer.GetTotal<Timer::Seconds>();
     manager.total_compile_time_ms = data.total_timer.GetTotal<Timer::Milliseconds>();
     manager.join_compile_time = data.join_timer.GetDuration<Timer::Seconds>();
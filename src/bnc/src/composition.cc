@@ -4,6 +4,10 @@
 #include <list>
 #include <limits>
 #include "xary.h"
+#include "options.h"
+#include <map>
+#include <thread>
+#include <pthread.h>
 
 Composition::Node::Node() : parent(NULL), id(0), partition_id(0) {
 }
@@ -65,39 +69,256 @@ void Composition::SetBayesnet(bayesnet *bn){
     this->bn_ = bn;
 }
 
+namespace {
+
+// largest number of partitions of which all subsets are searched
+const unsigned int kMaxExactPartitions = 18;
+
+/* The score of a partition in a composition ordering only depends on the set
+ * of partitions after it. The partition becomes the root of the partitions
+ * after it with which it is connected by shared variables, and its context
+ * holds the variables of that component that also occur before it. */
+struct CompositionGraph {
+    CompositionGraph(const std::vector< std::vector<variable_t> > &kShared, const uint32_t *kDimensions) : kShared(kShared), kDimensions(kDimensions) {
+        const unsigned int kNrPartitions = kShared.size();
+        std::map< variable_t, std::vector<unsigned int> > occurrences;
+        for(unsigned int p = 0; p < kNrPartitions; p++)
+            for(auto it = kShared[p].begin(); it != kShared[p].end(); it++)
+                occurrences[*it].push_back(p);
+
+        neighbours.resize(kNrPartitions);
+        for(auto it = occurrences.begin(); it != occurrences.end(); it++){
+            variable_to_partitions[it->first] = it->second;
+            for(auto pit = it->second.begin(); pit != it->second.end(); pit++)
+                neighbours[*pit].insert(neighbours[*pit].end(), it->second.begin(), it->second.end());
+        }
+
+        for(unsigned int p = 0; p < kNrPartitions; p++){
+            auto &n = neighbours[p];
+            std::sort(n.begin(), n.end());
+            n.erase(std::unique(n.begin(), n.end()), n.end());
+        }
+
+        if(kNrPartitions <= kMaxExactPartitions){
+            neighbour_mask.resize(kNrPartitions, 0);
+            for(unsigned int p = 0; p < kNrPartitions; p++)
+                for(auto it = neighbours[p].begin(); it != neighbours[p].end(); it++)
+                    neighbour_mask[p] |= 1u << *it;
+
+            shared_mask.resize(kNrPartitions);
+            for(unsigned int p = 0; p < kNrPartitions; p++){
+                for(auto it = kShared[p].begin(); it != kShared[p].end(); it++){
+                    const auto &kPartitions = variable_to_partitions[*it];
+                    uint32_t mask = 0;
+                    for(auto pit = kPartitions.begin(); pit != kPartitions.end(); pit++)
+                        mask |= 1u << *pit;
+                    shared_mask[p].push_back(mask);
+                }
+            }
+        }
+    }
+
+    // width of partition p when the partitions in after follow it
+    double ComputeWidth(const unsigned int p, const uint32_t after) const {
+        const uint32_t kProcessed = after | (1u << p);
+
+        uint32_t component = 1u << p;
+        uint32_t frontier = component;
+        while(frontier){
+            const unsigned int q = __builtin_ctz(frontier);
+            frontier &= frontier - 1;
+            const uint32_t kNew = neighbour_mask[q] & kProcessed & ~component;
+            component |= kNew;
+            frontier |= kNew;
+        }
+
+        double width = 1;
+        uint32_t members = component;
+        while(members){
+            const unsigned int q = __builtin_ctz(members);
+            members &= members - 1;
+            for(unsigned int i = 0; i < kShared[q].size(); i++){
+                const uint32_t kOccurrences = shared_mask[q][i];
+                const uint32_t kInComponent = kOccurrences & component;
+                // count each variable once, at its first partition in the component
+                if((kInComponent & -kInComponent) == (1u << q) && (kOccurrences & ~kProcessed))
+                    width *= kDimensions[kShared[q][i]];
+            }
+        }
+        return width;
+    }
+
+    // width of partition p when the partitions marked in processed follow it
+    double ComputeWidth(const unsigned int p, const std::vector<bool> &processed, std::vector<unsigned int> &component, std::vector<bool> &in_component) const {
+        component.clear();
+        component.push_back(p);
+        in_component[p] = true;
+        for(unsigned int i = 0; i < component.size(); i++){
+            const auto &kNeighbours = neighbours[component[i]];
+            for(auto it = kNeighbours.begin(); it != kNeighbours.end(); it++){
+                if(processed[*it] && !in_component[*it]){
+                    in_component[*it] = true;
+                    component.push_back(*it);
+                }
+            }
+        }
+
+        double width = 1;
+        std::set<variable_t> context;
+        for(auto it = component.begin(); it != component.end(); it++){
+            for(auto vit = kShared[*it].begin(); vit != kShared[*it].end(); vit++){
+                if(context.find(*vit) != context.end())
+                    continue;
+
+                const auto &kPartitions = variable_to_partitions.find(*vit)->second;
+                for(auto pit = kPartitions.begin(); pit != kPartitions.end(); pit++){
+                    if(*pit != p && !processed[*pit]){
+                        context.insert(*vit);
+                        width *= kDimensions[*vit];
+                        break;
+                    }
+                }
+            }
+        }
+
+        for(auto it = component.begin(); it != component.end(); it++)
+            in_component[*it] = false;
+        return width;
+    }
+
+    const std::vector< std::vector<variable_t> > &kShared;
+    const uint32_t *kDimensions;
+    std::vector< std::vector<unsigned int> > neighbours;
+    std::map< variable_t, std::vector<unsigned int> > variable_to_partitions;
+    std::vector<uint32_t> neighbour_mask;
+    std::vector< std::vector<uint32_t> > shared_mask;   // partitions of each shared variable
+};
+
+struct SubsetWorker {
+    const CompositionGraph *graph;
+    std::vector<double> *best;
+    std::vector<unsigned char> *choice;
+    unsigned int size;
+    uint32_t begin, end;
+};
+
+// best score of every set of partitions of the given size that ends an ordering
+void* ComputeSubsets(void *data){
+    SubsetWorker *worker = (SubsetWorker*) data;
+    const CompositionGraph &kGraph = *(worker->graph);
+    std::vector<double> &best = *(worker->best);
+    std::vector<unsigned char> &choice = *(worker->choice);
+
+    for(uint32_t set = worker->begin; set < worker->end; set++){
+        if((unsigned int) __builtin_popcount(set) != worker->size)
+            continue;
+
+        double best_score = std::numeric_limits<double>::max();
+        unsigned char best_choice = 0;
+        uint32_t members = set;
+        while(members){
+            const unsigned int p = __builtin_ctz(members);
+            members &= members - 1;
+
+            const uint32_t kAfter = set & ~(1u << p);
+            const double kScore = best[kAfter] + kGraph.ComputeWidth(p, kAfter);
+            if(kScore < best_score){
+                best_score = kScore;
+                best_choice = p;
+            }
+        }
+        best[set] = best_score;
+        choice[set] = best_choice;
+    }
+    return NULL;
+}
+
+}
+
+/**
+ * Finds the composition ordering with the lowest score. Since the score of a
+ * partition only depends on the set of partitions after it, the best ordering
+ * of every such set is computed from the best orderings of its subsets, one
+ * subset size at a time in parallel. Beyond kMaxExactPartitions partitions,
+ * the ordering is built greedily from the back.
+ */
 ordering_t Composition::FindOrdering() const{
     assert(bn_ != NULL && "Bayesian network not set for composition ordering");
     assert(variable_to_occurrences_.size() > 0 && "Composition must be initialized first");
-    assert(partition_to_shared_variables_.size() <= 12 && "Too many partitions to brute force good ordering");
 
-    // create initial ordering
     const unsigned int kNrPartitions = partition_to_shared_variables_.size();
+    const CompositionGraph kGraph(partition_to_shared_variables_, bn_->get_states());
     ordering_t ordering;
-    for(unsigned int i = 0; i < kNrPartitions; i++)
-        ordering.push_back(i);
-
-    // init
-    ordering_t found_ordering = ordering;
-    double best_score = ComputeScore(ordering);
-    unsigned int kMaxIterations = 10000000;
-    unsigned int iteration = 1;
-
-    // find a componosition ordering with brute force
-    while( std::next_permutation(ordering.begin(),ordering.end())){
-        double current_score = ComputeScore(ordering);
-        if(current_score < best_score){
-            best_score = current_score;
-            found_ordering = ordering;
+    if(kNrPartitions == 0)
+        return ordering;
+
+    if(kNrPartitions <= kMaxExactPartitions){
+        const uint32_t kNrSets = 1u << kNrPartitions;
+        std::vector<double> best(kNrSets, 0);
+        std::vector<unsigned char> choice(kNrSets, 0);
+
+        unsigned int threads = (bnc::OPT_WORKERS > 0 ? bnc::OPT_WORKERS : std::thread::hardware_concurrency());
+        if(threads == 0 || kNrPartitions < 10)
+            threads = 1;
+
+        std::vector<SubsetWorker> workers(threads);
+        for(unsigned int i = 0; i < threads; i++){
+            workers[i].graph = &kGraph;
+            workers[i].best = &best;
+            workers[i].choice = &choice;
+            workers[i].begin = (uint32_t) (((uint64_t) kNrSets * i) / threads);
+            workers[i].end = (uint32_t) (((uint64_t) kNrSets * (i+1)) / threads);
+        }
+
+        for(unsigned int size = 1; size <= kNrPartitions; size++){
+            for(unsigned int i = 0; i < threads; i++)
+                workers[i].size = size;
+
+            if(threads == 1){
+                ComputeSubsets(&(workers[0]));
+                continue;
+            }
+
+            pthread_t pthreads[threads];
+            for(unsigned int i = 0; i < threads; i++)
+                if(pthread_create(&(pthreads[i]), NULL, ComputeSubsets, (void*) &(workers[i])))
+                    throw CompositionException("Error creating thread %u of %u", i+1, threads);
+
+            for(unsigned int i = 0; i < threads; i++)
+                if(pthread_join(pthreads[i], NULL))
+                    throw CompositionException("Error joining thread %u of %u", i+1, threads);
         }
 
-        iteration++;
-        if(iteration >= kMaxIterations){
-            fprintf(stderr, "Warning: brute force limited to ~%u iterations\n", kMaxIterations);
-            break;
+        // the choice of a set is the first partition of its ordering
+        uint32_t set = kNrSets - 1;
+        while(set){
+            ordering.push_back(choice[set]);
+            set &= ~(1u << choice[set]);
+        }
+    } else {
+        std::vector<bool> processed(kNrPartitions, false);
+        std::vector<bool> in_component(kNrPartitions, false);
+        std::vector<unsigned int> component;
+        ordering.resize(kNrPartitions);
+        for(unsigned int i = kNrPartitions; i-- > 0;){
+            double best_width = std::numeric_limits<double>::max();
+            unsigned int best_partition = 0;
+            for(unsigned int p = 0; p < kNrPartitions; p++){
+                if(processed[p])
+                    continue;
+
+                const double kWidth = kGraph.ComputeWidth(p, processed, component, in_component);
+                if(kWidth < best_width){
+                    best_width = kWidth;
+                    best_partition = p;
+                }
+            }
+            processed[best_partition] = true;
+            ordering[i] = best_partition;
         }
     }
 
-    return found_ordering;
+    return ordering;
 }
 
 
@@ -0,0 +1,249 @@
+#include "dynamicarray.h"
+#include <exception/stringf.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <fstream>
+#include <algorithm>
+#include <mutex>
+#include <map>
+#include <vector>
+
+namespace {
+
+// memory policies of mbind(2), see numaif.h
+const int kMpolInterleave = 3;
+const int kMpolLocal = 4;
+
+std::string directory;
+bool huge_pages = false;
+DynamicArrayStorage::Placement placement = DynamicArrayStorage::kDefault;
+
+// mapped arrays by address, for reporting
+std::mutex regions_mutex;
+std::map<uintptr_t,size_t> regions;
+
+size_t GetMappedBytes(const size_t kBytes){
+    const size_t kAlign = DynamicArrayStorage::kHugePageSize;
+    return ((kBytes + kAlign - 1) / kAlign) * kAlign;
+}
+
+// reserves an anonymous mapping aligned at a huge page boundary
+void* MapAligned(const size_t kMappedBytes){
+    const size_t kAlign = DynamicArrayStorage::kHugePageSize;
+    void *reserved = mmap(NULL, kMappedBytes + kAlign, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(reserved == MAP_FAILED)
+        return NULL;
+
+    const uintptr_t kReserved = (uintptr_t) reserved;
+    const uintptr_t kAligned = ((kReserved + kAlign - 1) / kAlign) * kAlign;
+    if(kAligned > kReserved)
+        munmap(reserved, kAligned - kReserved);
+    munmap((void*) (kAligned + kMappedBytes), kReserved + kAlign - kAligned);
+    return (void*) kAligned;
+}
+
+// maps an unlinked file over the (aligned) reserved range
+void* MapFile(void *data, const size_t kMappedBytes){
+    std::string filename = directory + "/bnc-array.XXXXXX";
+    int fd = mkstemp(&filename[0]);
+    if(fd < 0)
+        return NULL;
+
+    // the mapping keeps the file alive. Its disk space is reserved up front,
+    // as writing back a page of a sparse file on a full disk raises SIGBUS
+    unlink(filename.c_str());
+    void *mapped = MAP_FAILED;
+    const int kError = posix_fallocate(fd, 0, kMappedBytes);
+    if(kError == 0)
+        mapped = mmap(data, kMappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    else fprintf(stderr, "Could not reserve %.1lfMb in out of core directory '%s': %s\n",
+        kMappedBytes / (double) (1 << 20), directory.c_str(), strerror(kError));
+    close(fd);
+
+    return (mapped == MAP_FAILED ? NULL : mapped);
+}
+
+// online NUMA nodes as a mask for mbind, e.g. "0-1,4"
+std::vector<unsigned long> GetNodeMask(){
+    std::vector<unsigned long> mask(1, 0);
+    std::ifstream file("/sys/devices/system/node/online");
+    std::string range;
+    while(std::getline(file, range, ',')){
+        unsigned int first, last;
+        int fields = sscanf(range.c_str(), "%u-%u", &first, &last);
+        if(fields < 1)
+            continue;
+        if(fields == 1)
+            last = first;
+
+        for(unsigned int node = first; node <= last; node++){
+            const size_t kBits = sizeof(unsigned long) * 8;
+            if(node / kBits >= mask.size())
+                mask.resize(node / kBits + 1, 0);
+            mask[node / kBits] |= 1UL << (node % kBits);
+        }
+    }
+    return mask;
+}
+
+void Bind(void *data, const size_t kMappedBytes){
+    #ifdef SYS_mbind
+    if(placement == DynamicArrayStorage::kInterleave){
+        static const std::vector<unsigned long> kMask = GetNodeMask();
+        syscall(SYS_mbind, data, kMappedBytes, kMpolInterleave, &kMask[0], kMask.size() * sizeof(unsigned long) * 8 + 1, 0);
+    } else if(placement == DynamicArrayStorage::kFirstTouch)
+        syscall(SYS_mbind, data, kMappedBytes, kMpolLocal, NULL, 0, 0);
+    #endif
+}
+
+}
+
+const size_t DynamicArrayStorage::kMinBytes;
+const size_t DynamicArrayStorage::kHugePageSize;
+
+void DynamicArrayStorage::SetDirectory(const std::string &kDirectory){
+    directory = kDirectory;
+}
+
+void DynamicArrayStorage::SetHugePages(const bool kHugePages){
+    huge_pages = kHugePages;
+}
+
+void DynamicArrayStorage::SetPlacement(const Placement kPlacement){
+    placement = kPlacement;
+}
+
+bool DynamicArrayStorage::IsEnabled(){
+    return !directory.empty() || huge_pages || placement != kDefault;
+}
+
+bool DynamicArrayStorage::IsMapped(const size_t kBytes){
+    return IsEnabled() && kBytes >= kMinBytes;
+}
+
+void* DynamicArrayStorage::Allocate(const size_t kBytes){
+    const size_t kMappedBytes = GetMappedBytes(kBytes);
+
+    void *data = MapAligned(kMappedBytes);
+    if(data && !directory.empty() && !MapFile(data, kMappedBytes)){
+        munmap(data, kMappedBytes);
+        data = NULL;
+    }
+    if(!data)
+        return NULL;
+
+    // advice and policy only apply to pages faulted in afterwards
+    #ifdef MADV_HUGEPAGE
+    if(huge_pages)
+        madvise(data, kMappedBytes, MADV_HUGEPAGE);
+    #endif
+    if(placement != kDefault)
+        Bind(data, kMappedBytes);
+
+    std::lock_guard<std::mutex> lock(regions_mutex);
+    regions[(uintptr_t) data] = kMappedBytes;
+    return data;
+}
+
+void DynamicArrayStorage::Release(void *data, const size_t kBytes){
+    munmap(data, GetMappedBytes(kBytes));
+
+    std::lock_guard<std::mutex> lock(regions_mutex);
+    regions.erase((uintptr_t) data);
+}
+
+void DynamicArrayStorage::Evict(void *data, const size_t kBytes){
+    if(directory.empty())
+        return;
+
+    const size_t kMappedBytes = GetMappedBytes(kBytes);
+
+    // clean pages are dropped, and only read again from the file on access
+    msync(data, kMappedBytes, MS_SYNC);
+    madvise(data, kMappedBytes, MADV_DONTNEED);
+}
+
+std::string DynamicArrayStorage::Report(){
+    std::map<uintptr_t,size_t> mapped;
+    {
+        std::lock_guard<std::mutex> lock(regions_mutex);
+        mapped = regions;
+    }
+
+    size_t total = 0;
+    for(auto it = mapped.begin(); it != mapped.end(); it++)
+        total += it->second;
+
+    // resident and huge page backed bytes of the mappings that overlap the
+    // arrays, attributed by overlap since the kernel may merge mappings
+    double resident = 0, huge = 0;
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    uintptr_t start = 0, end = 0;
+    double overlap = 0;
+    while(std::getline(smaps, line)){
+        unsigned long kb;
+        unsigned long long first, last;
+        if(sscanf(line.c_str(), "%llx-%llx ", &first, &last) == 2){
+            start = first;
+            end = last;
+            overlap = 0;
+            auto it = mapped.upper_bound(start);
+            if(it != mapped.begin())
+                --it;
+            for(; it != mapped.end() && it->first < end; it++){
+                const uintptr_t kFirst = std::max(start, it->first);
+                const uintptr_t kLast = std::min(end, it->first + it->second);
+                if(kLast > kFirst)
+                    overlap += kLast - kFirst;
+            }
+            overlap /= (end - start);
+        } else if(overlap > 0 && sscanf(line.c_str(), "Rss: %lu kB", &kb) == 1)
+            resident += overlap * kb * 1024;
+        else if(overlap > 0 && (sscanf(line.c_str(), "AnonHugePages: %lu kB", &kb) == 1
+                || sscanf(line.c_str(), "FilePmdMapped: %lu kB", &kb) == 1
+                || sscanf(line.c_str(), "ShmemPmdMapped: %lu kB", &kb) == 1))
+            huge += overlap * kb * 1024;
+    }
+
+    const double kMb = 1 << 20;
+    std::string report = stringf("Array storage    : %lu arrays, %.1lfMb mapped (%s%s%s)\n",
+        mapped.size(), total / kMb,
+        (directory.empty() ? "anonymous" : "files"),
+        (huge_pages ? ", huge pages" : ""),
+        (placement == kInterleave ? ", interleaved" : (placement == kFirstTouch ? ", first touch" : "")));
+    report += stringf("    Resident     : %.1lfMb\n", resident / kMb);
+    report += stringf("    Huge pages   : %.1lfMb (%.0lf%% of resident)\n", huge / kMb, (resident > 0 ? 100 * huge / resident : 0));
+
+    #ifdef SYS_move_pages
+    // sample the node of one page per huge page
+    std::vector<void*> pages;
+    for(auto it = mapped.begin(); it != mapped.end(); it++)
+        for(size_t offset = 0; offset < it->second; offset += kHugePageSize)
+            pages.push_back((void*) (it->first + offset));
+
+    std::vector<int> status(pages.size(), -1);
+    std::map<int,size_t> nodes;
+    size_t present = 0;
+    if(!pages.empty() && syscall(SYS_move_pages, 0, pages.size(), &pages[0], NULL, &status[0], 0) == 0){
+        for(auto it = status.begin(); it != status.end(); it++){
+            if(*it >= 0){
+                nodes[*it]++;
+                present++;
+            }
+        }
+    }
+
+    if(present > 0){
+        report += "    NUMA nodes   :";
+        for(auto it = nodes.begin(); it != nodes.end(); it++)
+            report += stringf(" %d (%.0lf%%)", it->first, 100.0 * it->second / present);
+        report += "\n";
+    }
+    #endif
+
+    return report;
+}
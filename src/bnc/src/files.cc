@@ -159,6 +159,10 @@ void filename::set_filename(file_t filetype, std::string filename){
     filenames[filetype] = filename;
 }
 
+void filename::unset_filename(file_t filetype){
+    filenames.erase(filetype);
+}
+
 const char * filename::get_filename_c(file_t filetype, std::string aux, std::string postfix){
     static std::string filename;
     filename = get_filename(filetype,aux,postfix);
@@ -13,9 +13,24 @@
 #include "memory.h"
 #include "threading.h"
 #include "stringsep.h"
+#include "batch.h"
+#include "cache.h"
+#include "dynamicarray.h"
+#include "timer.h"
+#include <exception/stringf.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <string.h>
+#include <cerrno>
+#include <algorithm>
 
 using namespace bnc;
 
+std::string batch_manifest;
+
+// exit status of a compilation exceeding its time or memory limit
+const int kLimitExceeded = 2;
+
 int isnumber (const char * s){
     if (s == NULL || *s == '\0' || isspace(*s))
         return 0;
@@ -25,13 +40,14 @@ int isnumber (const char * s){
 }
 
 void help(){
-    fprintf(stderr, "Usage:\n   ./bnc [options] <.net file>\n\n");
+    fprintf(stderr, "Usage:\n   ./bnc [options] <.net file>\n   ./bnc [-o workers=<n>] [-o memory=<Mb>] -j <manifest>\n\n");
     fprintf(stderr, "    Options:\n"); // pinvc:o:r:t:w:h
     fprintf(stderr, "        -c <bottomup|topdown|hybrid>      : compilation type (default: hybrid)\n");
     fprintf(stderr, "        -w <filetype>[=<filename>]        : write data to file, of filetype <part|map|dot|elim|var|order|circuit|comp|uai|pseudo|spanning>\n");
     fprintf(stderr, "        -t <wpbdd|mg|tdmg> : decision diagram type (default: tdmg)\n");
     fprintf(stderr, "        -r <part|lit|var|elim>[=<filename>] : read [partition|literal|variable|elimination] ordering\n");
     fprintf(stderr, "        -d <partitioned|monolithic>       : compile as [partitioned|monolithic] representation\n");
+    fprintf(stderr, "        -j <manifest>                     : compile every line of manifest (bnc options and a .net file) as a job, sharing workers and memory\n");
     fprintf(stderr, "        -o <option>=<value>               : set option\n");
     fprintf(stderr, "            option:\n");
     fprintf(stderr, "                determinism               (consider determinism, default: %s)\n",(OPT_DETERMINISM?"yes":"no"));
@@ -43,11 +59,25 @@ void help(){
     fprintf(stderr, "                reserve                   (reserve (pre-allocate) number of nodes before compilation)\n");
     fprintf(stderr, "                time                      (set compilation time limit in seconds)\n");
     fprintf(stderr, "                resources                 (set RAM usage limit by factor, example: 0.8 for 80\% RAM usage)\n");
+    fprintf(stderr, "                memory                    (set RAM usage limit in Mb, with -j the memory shared by all jobs)\n");
+    fprintf(stderr, "                adaptive                  (retry with one more partition, up to the given number, while the time or memory limit is exceeded)\n");
+    fprintf(stderr, "                cache                     (directory of compiled artifacts, reused when network, orderings and options are unchanged)\n");
+    fprintf(stderr, "                out_of_core               (directory of files backing the mg/tdmg layers, finished layers are written out, the memory limit is not enforced)\n");
+    fprintf(stderr, "                hugepages                 (back large mg/tdmg arrays by transparent huge pages, default: %s)\n",(OPT_HUGE_PAGES?"yes":"no"));
+    fprintf(stderr, "                numa                      (NUMA placement of large mg/tdmg arrays: default, local (first touch) or interleave)\n");
     fprintf(stderr, "                loadfactor                (set load factor of computed table (hashmap), a value > 0.0 and <= 1.0. Default: %lf)\n",OPT_COMPUTED_TABLE_LOAD_FACTOR);
     fprintf(stderr, "                buckets                   (reserve buckets in computed table (hashmap). Default: %lu)\n", OPT_COMPUTED_TABLE_BUCKETS);
+    fprintf(stderr, "                component_cache           (reuse sub-diagrams of identical residual formulas in topdown compilation, default: %s)\n",(OPT_COMPONENT_CACHE?"yes":"no"));
+    fprintf(stderr, "                sparse                    (only compile multigraph contexts that are reachable under determinism, default: %s)\n",(OPT_SPARSE_LAYERS?"yes":"no"));
+    fprintf(stderr, "                gc                        (mark-and-sweep garbage collection instead of reference counting with wpbdd, default: %s)\n",(OPT_GARBAGE_COLLECTION?"yes":"no"));
+    fprintf(stderr, "                gc_threshold              (collect garbage when node memory exceeds factor of RAM, default: %.2lf)\n",OPT_GC_THRESHOLD);
+    fprintf(stderr, "                sift                      (number of sifting passes over the compiled wpbdd, 0 to disable, default: %u)\n", OPT_SIFT);
+    fprintf(stderr, "                sift_growth               (maximal growth factor while moving a variable during sifting, default: %.2lf)\n", OPT_SIFT_GROWTH);
     fprintf(stderr, "                partitions                (number of partitions)\n");
     fprintf(stderr, "                parallel_conjoin          (parallel conjoin, when using parallelism)\n");
     fprintf(stderr, "                parallel_level            (level of parallelism (for multigraphs. Default: %u)\n", OPT_PARALLEL_LEVEL);
+    fprintf(stderr, "                parallel_cube             (cube-and-conquer topdown compilation, when using parallelism, default: %s)\n",(OPT_PARALLEL_CUBE?"yes":"no"));
+    fprintf(stderr, "                cube_depth                (number of ordering literals to split cubes on, 0 for automatic, default: %u)\n", OPT_CUBE_DEPTH);
     fprintf(stderr, "                order                     (method of determining ordering, default: %u)\n", OPT_ORDER);
     fprintf(stderr, "                    0: induced by topological sort of bn\n");
     fprintf(stderr, "                    1: induced by breath first search of bn\n");
@@ -60,6 +90,8 @@ void help(){
     fprintf(stderr, "                    8: induced by all possible topological sorts of bn\n");
     fprintf(stderr, "                    9: simulated annealing (tree)\n");
     fprintf(stderr, "                    10: minhill climbing\n");
+    fprintf(stderr, "                branch and bound options:\n");
+    fprintf(stderr, "                    bb_memory      : node memory in Mb after which branch and bound continues depth-first (default: %u)\n", OPT_BB_MEMORY);
     fprintf(stderr, "                simulated annealing options:\n");
     fprintf(stderr, "                    sa_read_elim   : read elim as initialization (default: %s)\n",(OPT_SA_READ_ELIM_ORDERING?"yes":"no") );;
     fprintf(stderr, "                    sa_iterations  : nr of iterations per temperature (default: %ld)\n",OPT_SA_ITERATIONS);
@@ -71,6 +103,8 @@ void help(){
     fprintf(stderr, "                    sa_print       : print current states (default: %s)\n",(OPT_SA_PRINT_ORDERING?"yes":"no") );
     fprintf(stderr, "                    sa_parallel    : run %lu executions in parallel (default: %s)\n", std::thread::hardware_concurrency(), (OPT_SA_PARALLELISM?"yes":"no") );
     fprintf(stderr, "                    sa_runs        : number of sa executions, using previous solution (default: %lu)\n", OPT_SA_RUNS);
+    fprintf(stderr, "                    sa_tempering   : parallel executions exchange temperatures (default: %s)\n", (OPT_SA_TEMPERING?"yes":"no") );
+    fprintf(stderr, "                    sa_time        : time budget of parallel tempering in seconds (default: %.1lf)\n", OPT_SA_TIME);
     fprintf(stderr, "        -p: parallel compilation\n");
     fprintf(stderr, "        -h: Help\n");
 }
@@ -79,6 +113,16 @@ void* run(void* data){
     bayesnet *bn = (bayesnet*) data;
 
     try {
+        // artifacts are only cached for compiled circuits
+        cache_t cache;
+        if(!OPT_CACHE_DIR.empty() && !OPT_NO_COMPILE && !OPT_WRITE_UAI){
+            cache.open(OPT_CACHE_DIR);
+            if(cache.fetch()){
+                printf("Done.\n\n");
+                return NULL;
+            }
+        }
+
         compiler comp;
         comp.set_compilation_type(OPT_COMPILATION_TYPE);
         comp.set_bdd_type(OPT_BDD_TYPE);
@@ -93,10 +137,16 @@ void* run(void* data){
             exit(0);
         }
 
+        if(cache.is_open())
+            cache.redirect_ordering();
         comp.load();
+        cache.restore();
         if(!OPT_NO_COMPILE)
             comp.compile();
 
+        if(DynamicArrayStorage::IsEnabled())
+            printf("\n%s", DynamicArrayStorage::Report().c_str());
+
         printf("\n");
         if(OPT_WRITE_DOT){
             if(comp.get_nr_partitions() > 1)
@@ -164,6 +214,12 @@ void* run(void* data){
             printf("Done.\n\n");
         }
 
+        if(cache.is_open()){
+            printf("Storing artifacts in cache (key %s)...\n", cache.get_key().c_str());
+            cache.store(comp);
+            printf("Done.\n\n");
+        }
+
 
        // comp.write(COMPOSITION_ORDERING);
         #ifndef DEBUG
@@ -171,17 +227,26 @@ void* run(void* data){
         #endif
     } catch(compiler_exception &e){
         printf("COMPILER ERROR: %s\n", e.what());
+        return (void*) 1;
+    } catch(std::bad_alloc &e){
+        printf("Memory limit exceeded\n");
+        return (void*) kLimitExceeded;
     } catch(std::exception &e){
         printf("ERROR: %s\n", e.what());
+        return (void*) 1;
     }
     return NULL;
 }
 
-int main(int argc, char **argv){
+// sets the options and files of one compilation, returns -1 if only help was asked for
+int parse(int argc, char **argv){
     init_options();
+    files.clear();
+    batch_manifest.clear();
+    optind = 1;
 
     int c;
-    while ((c = getopt(argc, argv, "pinvc:o:r:t:w:hd:")) != -1){
+    while ((c = getopt(argc, argv, "pinvc:o:r:t:w:hd:j:")) != -1){
         switch (c){
             case 'p': // read ordering file
                 OPT_PARALLELISM = true;
@@ -289,6 +354,13 @@ int main(int argc, char **argv){
                             fprintf(stderr, "Argument to option '%s' (%s) is not a number\n", assignment[0].c_str(), assignment[1].c_str());
                             return 1;
                         }
+                    } else if(assignment[0] == "cube_depth"){
+                        if(isnumber(assignment[1].c_str()))
+                            OPT_CUBE_DEPTH = std::stoi(assignment[1]);
+                        else {
+                            fprintf(stderr, "Argument to option '%s' (%s) is not a number\n", assignment[0].c_str(), assignment[1].c_str());
+                            return 1;
+                        }
                     } else if(assignment[0] == "parallel_cpt"){
                         if(isnumber(assignment[1].c_str()))
                             OPT_PARALLEL_CPT = std::stoi(assignment[1]);
@@ -345,6 +417,13 @@ int main(int argc, char **argv){
                             fprintf(stderr, "Argument to option '%s' (%s) is not a number\n", assignment[0].c_str(), assignment[1].c_str());
                             return 1;
                         }
+                    } else if(assignment[0] == "bb_memory"){
+                        if(isnumber(assignment[1].c_str()))
+                            OPT_BB_MEMORY = std::stoi(assignment[1]);
+                        else {
+                            fprintf(stderr, "Argument to option '%s' (%s) is not a number\n", assignment[0].c_str(), assignment[1].c_str());
+                            return 1;
+                        }
                     } else if(assignment[0] == "sa_runs"){
                         if(isnumber(assignment[1].c_str()))
                             OPT_SA_RUNS = std::stoi(assignment[1]);
@@ -359,6 +438,20 @@ int main(int argc, char **argv){
                             fprintf(stderr, "Argument to option '%s' (%s) is not a number\n", assignment[0].c_str(), assignment[1].c_str());
                             return 1;
                         }
+                    } else if(assignment[0] == "sa_tempering"){
+                        if(isnumber(assignment[1].c_str()))
+                            OPT_SA_TEMPERING = (bool) std::stoi(assignment[1]);
+                        else {
+                            fprintf(stderr, "Argument to option '%s' (%s) is not a number\n", assignment[0].c_str(), assignment[1].c_str());
+                            return 1;
+                        }
+                    } else if(assignment[0] == "sa_time"){
+                        if(isnumber(assignment[1].c_str()))
+                            OPT_SA_TIME = atof(assignment[1].c_str());
+                        else {
+                            fprintf(stderr, "Argument to option '%s' (%s) is not a number\n", assignment[0].c_str(), assignment[1].c_str());
+                            return 1;
+                        }
                     } else if(assignment[0] == "sa_print"){
                         if(isnumber(assignment[1].c_str()))
                             OPT_SA_PRINT_ORDERING = (bool) std::stoi(assignment[1]);
@@ -454,9 +547,83 @@ int main(int argc, char **argv){
                             fprintf(stderr, "Argument to option '%s' (%s) must be in range [0-1]\n", assignment[0].c_str(), assignment[1].c_str());
                             return 1;
                         }
-                        if(set_memory_limit(get_ram_size(percentage)) != 0)
-                            fprintf(stderr, "Unable to set memory limit\n");
-
+                        OPT_MEMORY_LIMIT = get_ram_size(percentage) >> 20;
+                    } else if(assignment[0] == "memory"){
+                        if(isnumber(assignment[1].c_str()) && std::stoi(assignment[1]) >= 0)
+                            OPT_MEMORY_LIMIT = std::stoi(assignment[1]);
+                        else {
+                            fprintf(stderr, "Argument to option '%s' (%s) is not a number\n", assignment[0].c_str(), assignment[1].c_str());
+                            return 1;
+                        }
+                    } else if(assignment[0] == "cache"){
+                        OPT_CACHE_DIR = assignment[1];
+                    } else if(assignment[0] == "out_of_core"){
+                        OPT_OUT_OF_CORE_DIR = assignment[1];
+                    } else if(assignment[0] == "adaptive"){
+                        if(isnumber(assignment[1].c_str()) && std::stoi(assignment[1]) >= 0)
+                            OPT_ADAPTIVE_PARTITIONS = std::stoi(assignment[1]);
+                        else {
+                            fprintf(stderr, "Argument to option '%s' (%s) is not a number\n", assignment[0].c_str(), assignment[1].c_str());
+                            return 1;
+                        }
+                    } else if(assignment[0] == "hugepages"){
+                        if(isnumber(assignment[1].c_str()))
+                            OPT_HUGE_PAGES = (bool) std::stoi(assignment[1]);
+                        else {
+                            fprintf(stderr, "Argument to option '%s' (%s) is not a number\n", assignment[0].c_str(), assignment[1].c_str());
+                            return 1;
+                        }
+                    } else if(assignment[0] == "numa"){
+                        if(assignment[1] == "default")
+                            OPT_NUMA_PLACEMENT = DynamicArrayStorage::kDefault;
+                        else if(assignment[1] == "local")
+                            OPT_NUMA_PLACEMENT = DynamicArrayStorage::kFirstTouch;
+                        else if(assignment[1] == "interleave")
+                            OPT_NUMA_PLACEMENT = DynamicArrayStorage::kInterleave;
+                        else {
+                            fprintf(stderr, "Argument to option '%s' (%s) is not one of default, local or interleave\n", assignment[0].c_str(), assignment[1].c_str());
+                            return 1;
+                        }
+                    } else if(assignment[0] == "component_cache"){
+                        if(isnumber(assignment[1].c_str()))
+                            OPT_COMPONENT_CACHE = (bool) std::stoi(assignment[1]);
+                        else {
+                            fprintf(stderr, "Argument to option '%s' (%s) is not a number\n", assignment[0].c_str(), assignment[1].c_str());
+                            return 1;
+                        }
+                    } else if(assignment[0] == "sparse"){
+                        if(isnumber(assignment[1].c_str()))
+                            OPT_SPARSE_LAYERS = (bool) std::stoi(assignment[1]);
+                        else {
+                            fprintf(stderr, "Argument to option '%s' (%s) is not a number\n", assignment[0].c_str(), assignment[1].c_str());
+                            return 1;
+                        }
+                    } else if(assignment[0] == "gc"){
+                        if(isnumber(assignment[1].c_str()))
+                            OPT_GARBAGE_COLLECTION = (bool) std::stoi(assignment[1]);
+                        else {
+                            fprintf(stderr, "Argument to option '%s' (%s) is not a number\n", assignment[0].c_str(), assignment[1].c_str());
+                            return 1;
+                        }
+                    } else if(assignment[0] == "gc_threshold"){
+                        OPT_GC_THRESHOLD = atof(assignment[1].c_str());
+                        if(!(OPT_GC_THRESHOLD > 0 && OPT_GC_THRESHOLD <= 1)){
+                            fprintf(stderr, "Argument to option '%s' (%s) must be in range [0-1]\n", assignment[0].c_str(), assignment[1].c_str());
+                            return 1;
+                        }
+                    } else if(assignment[0] == "sift"){
+                        if(isnumber(assignment[1].c_str()))
+                            OPT_SIFT = std::stoi(assignment[1]);
+                        else {
+                            fprintf(stderr, "Argument to option '%s' (%s) is not a number\n", assignment[0].c_str(), assignment[1].c_str());
+                            return 1;
+                        }
+                    } else if(assignment[0] == "sift_growth"){
+                        OPT_SIFT_GROWTH = atof(assignment[1].c_str());
+                        if(!(OPT_SIFT_GROWTH >= 1)){
+                            fprintf(stderr, "Argument to option '%s' (%s) must be at least 1\n", assignment[0].c_str(), assignment[1].c_str());
+                            return 1;
+                        }
                     } else if(assignment[0] == "loadfactor"){
                         float loadfactor = atof(assignment[1].c_str());
                         if(!(loadfactor > 0 && loadfactor <= 1.0)){
@@ -584,10 +751,13 @@ int main(int argc, char **argv){
                     }
                 }
                 break;
+            case 'j':
+                batch_manifest = optarg;
+                break;
             case 'h':
                 init_options();
                 help();
-                return 0;
+                return -1;
             case '?':
             default:
                 help();
@@ -612,7 +782,13 @@ int main(int argc, char **argv){
             else files.set_basename(filename);
          } else fprintf(stderr, "Warning: option '%s' ignored.\n",argv[index]);
     }
-    if(!have_bayesian_network){
+    if(!batch_manifest.empty()){
+        if(have_bayesian_network){
+            fprintf(stderr, "Hugin input files are provided by the manifest in batch mode.\n");
+            return 1;
+        }
+        return 0;
+    } else if(!have_bayesian_network){
         fprintf(stderr, "No Hugin input file provided.\n");
         return 1;
     }
@@ -625,7 +801,8 @@ int main(int argc, char **argv){
         OPT_DETERMINISM = false;
     }
 
-    if(OPT_PARALLELISM && OPT_ENCODE_STRUCTURE){
+    // parallel multigraph compilation canonicalizes through the unique table
+    if(OPT_PARALLELISM && OPT_ENCODE_STRUCTURE && OPT_BDD_TYPE == bdd_t::wpbdd){
         fprintf(stdout, "Warning: local structure not yet supported with parallelism. Disabling it.\n");
         OPT_ENCODE_STRUCTURE = false;
     }
@@ -637,6 +814,15 @@ int main(int argc, char **argv){
         return 1;
     }
 
+    if(OPT_ADAPTIVE_PARTITIONS > 0 && (OPT_READ_PARTITION
+        || OPT_READ_ORDERING
+        || OPT_READ_PSEUDO_ORDERING
+        || OPT_READ_VARIABLE_ORDERING
+        || OPT_READ_ELIM_ORDERING)){
+        fprintf(stderr, "Option 'adaptive' determines the partitions, which cannot be read with '-r'\n");
+        return 1;
+    }
+
     if(OPT_READ_PARTITION
         || OPT_WRITE_PARTITION)
         OPT_PARTITION = true;
@@ -652,6 +838,23 @@ int main(int argc, char **argv){
 
     }
 
+    return 0;
+}
+
+int compile_adaptive();
+
+int compile(){
+    if(OPT_ADAPTIVE_PARTITIONS > 0)
+        return compile_adaptive();
+
+    // file backed layers take address space without being held in memory,
+    // so the limit on the address space would stop out of core compiles
+    if(OPT_MEMORY_LIMIT > 0 && OPT_OUT_OF_CORE_DIR.empty() && set_memory_limit((byte_t) OPT_MEMORY_LIMIT << 20) != 0)
+        fprintf(stderr, "Unable to set memory limit\n");
+    DynamicArrayStorage::SetDirectory(OPT_OUT_OF_CORE_DIR);
+    DynamicArrayStorage::SetHugePages(OPT_HUGE_PAGES);
+    DynamicArrayStorage::SetPlacement((DynamicArrayStorage::Placement) OPT_NUMA_PLACEMENT);
+
     bayesnet *bn = NULL;
     try {
         bn = bayesnet::read(files.get_filename_c(BN));
@@ -668,16 +871,146 @@ int main(int argc, char **argv){
         return 1;
     }
 
+    int status = 0;
     if(OPT_TIME_LIMIT > 0){
         timed_thread_t thread;
         thread.run(run,(void*)bn,OPT_TIME_LIMIT);
-        if(thread.is_aborted())
+        if(thread.is_aborted()){
             fprintf(stderr, "Time limit exceeded (%d seconds)\n", OPT_TIME_LIMIT);
+            status = kLimitExceeded;
+        } else status = thread.get_returnvalue();
 
-    } else run((void*)bn);
+    } else status = (int) (long) run((void*)bn);
 
     delete bn;
 
+    return status;
+}
+
+std::string get_configuration(const int kPartitions){
+    if(kPartitions == 1)
+        return "monolithic";
+    return stringf("%d partitions", kPartitions);
+}
+
+// compiles in a process of its own per attempt, as an aborted compilation
+// leaves the process in an undefined state, and partitions finer after every
+// attempt that exceeds the time or memory limit
+int compile_adaptive(){
+    const int kMaxPartitions = OPT_ADAPTIVE_PARTITIONS;
+    const bool kWritePartition = OPT_WRITE_PARTITION;
+    int partitions = (OPT_PARTITION ? std::max(OPT_NR_PARTITIONS, 2) : 1);
+
+    Timer timer;
+    timer.Start();
+    while(true){
+        OPT_PARTITION = (partitions > 1);
+        OPT_NR_PARTITIONS = (partitions > 1 ? partitions : -1);
+        OPT_WRITE_PARTITION = kWritePartition || (OPT_PARTITION && (OPT_WRITE_AC || OPT_WRITE_ORDERING || OPT_WRITE_VARIABLE_ORDERING));
+
+        printf("Adaptive compilation: compiling %s\n", get_configuration(partitions).c_str());
+        fflush(stdout);
+        fflush(stderr);
+
+        pid_t pid = fork();
+        if(pid == 0){
+            OPT_ADAPTIVE_PARTITIONS = 0;
+            int status = compile();
+            fflush(stdout);
+            fflush(stderr);
+            _exit(status);
+        } else if(pid < 0){
+            fprintf(stderr, "Could not start compilation: %s\n", strerror(errno));
+            return 1;
+        }
+
+        int status;
+        if(waitpid(pid, &status, 0) != pid){
+            fprintf(stderr, "Lost track of compilation: %s\n", strerror(errno));
+            return 1;
+        }
+
+        // a limit is only exceeded when one is set: a failed allocation or
+        // timeout reports kLimitExceeded, and the kernel kills a process that
+        // runs out of memory. Any other signal is a crash, not a breach.
+        if(WIFSIGNALED(status)){
+            const int kSignal = WTERMSIG(status);
+            fprintf(stderr, "Compilation terminated by signal %d (%s)\n", kSignal, strsignal(kSignal));
+            if(kSignal == SIGKILL && OPT_MEMORY_LIMIT > 0)
+                status = kLimitExceeded;
+            else return 1;
+        } else {
+            status = WEXITSTATUS(status);
+            if(status == kLimitExceeded && OPT_MEMORY_LIMIT == 0 && OPT_TIME_LIMIT <= 0)
+                return status;
+        }
+
+        if(status == 0){
+            timer.Stop();
+            printf("Adaptive compilation: smallest configuration within limits is %s (%.3fs in total)\n",
+                get_configuration(partitions).c_str(), timer.GetDuration<Timer::Seconds>());
+            return 0;
+        } else if(status != kLimitExceeded)
+            return status;
+
+        if(partitions >= kMaxPartitions){
+            fprintf(stderr, "Adaptive compilation: no configuration of up to %d partitions within limits\n", kMaxPartitions);
+            return kLimitExceeded;
+        }
+        partitions++;
+    }
+}
+
+int prepare_job(batch_job_t &job){
+    std::vector<char*> argv;
+    for(auto it = job.arguments.begin(); it != job.arguments.end(); it++)
+        argv.push_back(&(*it)[0]);
+    argv.push_back(NULL);
+
+    int status = parse(argv.size()-1, &argv[0]);
+    if(status != 0 || !batch_manifest.empty())
+        return 1;
+
+    // a job without workers gets a single core, instead of all of them
+    if(OPT_WORKERS == 0)
+        OPT_WORKERS = 1;
+    job.workers = OPT_WORKERS;
+
+    // a job without memory is limited to what the batch reserved for it
+    if(OPT_MEMORY_LIMIT == 0 && job.memory > 0)
+        OPT_MEMORY_LIMIT = job.memory >> 20;
+    job.memory = (byte_t) OPT_MEMORY_LIMIT << 20;
     return 0;
 }
 
+int compile_job(batch_job_t&){
+    return compile();
+}
+
+int batch(){
+    const unsigned int kWorkers = (OPT_WORKERS > 0 ? OPT_WORKERS : std::thread::hardware_concurrency());
+    const byte_t kMemory = (OPT_MEMORY_LIMIT > 0 ? (byte_t) OPT_MEMORY_LIMIT << 20 : get_ram_size());
+
+    try {
+        batch_t jobs(prepare_job, compile_job);
+        jobs.read(batch_manifest);
+
+        printf("Compiling %lu jobs with %u workers and %luMb memory\n", jobs.size(), kWorkers, kMemory >> 20);
+        return jobs.run(kWorkers, kMemory);
+    } catch(compiler_exception &e){
+        fprintf(stderr, "BATCH ERROR: %s\n", e.what());
+        return 1;
+    }
+}
+
+int main(int argc, char **argv){
+    int status = parse(argc, argv);
+    if(status != 0)
+        return (status < 0 ? 0 : status);
+
+    if(!batch_manifest.empty())
+        return batch();
+
+    return compile();
+}
+
@@ -16,11 +16,20 @@
 
 using namespace bnc;
 
+bool weighted_node::garbage_collection = false;
+
 manager::manager(){
     actual_total_node_allocations = 0;
     actual_total_weight_allocations = 0;
     total_node_allocations = 0;
     total_weight_allocations = 0;
+    live_weights = 0;
+    gc_threshold = 0;
+    gc_base = 0;
+    gc_limit = 0;
+    gc_weight_size = 1;
+    gc_collections = 0;
+    gc_reclaimed = 0;
     bn = NULL;
 
     init();
@@ -404,6 +413,9 @@ manager::node* manager::create(const bool initialize){
     if(initialize)
         node::init(n);
 
+    if(node::garbage_collection)
+        gc_nodes.push_back(n);
+
     return n;
 }
 
@@ -422,6 +434,7 @@ manager::node::weights* manager::create_weights(){
     #endif
         w = allocate_weights();
 
+    live_weights++;
     return w;
 }
 
@@ -545,6 +558,7 @@ manager::node* manager::create_terminal(const bool satisfiable){
 
 void manager::destroy_weights(node::weights *&w){
     if(w){
+        live_weights--;
         #ifndef SIMPLE_ALLOCATION
         free_weights.push(w);
         #else
@@ -557,6 +571,9 @@ void manager::destroy_weights(node::weights *&w){
 }
 
 void manager::force_destroy(node *&n){
+    if(node::garbage_collection)
+        return;
+
     if(!node::is_terminal(n)){
         node::dereference(n->t);
         node::dereference(n->e);
@@ -620,6 +637,12 @@ void manager::destroy_support(node *n){
 }
 
 void manager::recursive_destroy(node *&n){
+    if(node::garbage_collection){
+        // nodes are reclaimed by collect_garbage, only release the root
+        remove_root(n);
+        return;
+    }
+
     node::stack s;
     if(n && node::is_dead(n))
         s.push(n);
@@ -669,6 +692,125 @@ void manager::deallocate(node *n){
     }
 }
 
+// collections start once the footprint of the nodes exceeds threshold, which
+// grows with the live set but never beyond limit
+void manager::set_garbage_collection(bool enabled, byte_t threshold, byte_t limit){
+    #ifdef DEBUG
+    if(enabled != node::garbage_collection && total_node_allocations > 0)
+        throw compiler_debug_exception("garbage collection must be set before nodes are created");
+    #endif
+    node::garbage_collection = enabled;
+    gc_base = threshold;
+    gc_limit = std::max(threshold, limit);
+    gc_threshold = gc_base;
+}
+
+bool manager::get_garbage_collection() const {
+    return node::garbage_collection;
+}
+
+size_t manager::get_gc_collections() const {
+    return gc_collections;
+}
+
+size_t manager::get_gc_reclaimed() const {
+    return gc_reclaimed;
+}
+
+// bytes of the nodes, their weight sets, and the computed table and support
+// entries, with weight sets sized as measured at the last collection
+byte_t manager::get_gc_footprint() const {
+    const size_t kTreeNode = 4 * sizeof(void*) + sizeof(weight_t);
+    const size_t kHashNode = sizeof(void*);
+    return gc_nodes.size() * sizeof(node)
+        + (byte_t) (live_weights * (sizeof(node::weights) + gc_weight_size * kTreeNode))
+        + ctable.size() * (sizeof(node::computed_table::value_type) + kHashNode)
+        + node_to_support.size() * (sizeof(decltype(node_to_support)::value_type) + kHashNode);
+}
+
+void manager::add_root(node *n){
+    if(node::garbage_collection && n)
+        gc_roots[n]++;
+}
+
+void manager::remove_root(node *n){
+    auto hit = gc_roots.find(n);
+    if(hit != gc_roots.end() && --(hit->second) == 0)
+        gc_roots.erase(hit);
+}
+
+size_t manager::collect_garbage(bool force){
+    if(!node::garbage_collection)
+        return 0;
+
+    if(!force && get_gc_footprint() < gc_threshold)
+        return 0;
+
+    // mark, reference counts are not maintained so ref serves as mark bit
+    node::stack s;
+    for(auto it = gc_roots.begin(); it != gc_roots.end(); it++)
+        s.push(it->first);
+
+    while(!s.empty()){
+        node *n = s.top();
+        s.pop();
+        if(n && !n->ref){
+            n->ref = 1;
+            if(!node::is_terminal(n)){
+                s.push(n->e);
+                s.push(n->t);
+            }
+        }
+    }
+
+    // purge computed table entries that refer to unreachable nodes
+    for(auto it = ctable.begin(); it != ctable.end();){
+        const node *a = it->first.first;
+        const node *b = it->first.second;
+        const node *v = it->second;
+        if((a && !a->ref) || (b && !b->ref) || (v && !v->ref))
+            it = ctable.erase(it);
+        else it++;
+    }
+
+    // sweep
+    size_t alive = 0;
+    size_t weights = 0, weight_sets = 0;
+    const size_t kAllocated = gc_nodes.size();
+    for(size_t i = 0; i < kAllocated; i++){
+        node *n = gc_nodes[i];
+        if(n->ref){
+            n->ref = 0;
+            gc_nodes[alive++] = n;
+            if(n->W){
+                weights += n->W->size();
+                weight_sets++;
+            }
+        } else {
+            node_to_support.erase(n);
+            destroy_node(n);
+        }
+    }
+    gc_nodes.resize(alive);
+    if(weight_sets > 0)
+        gc_weight_size = (double) weights / weight_sets;
+
+    // collect again only once the live set has doubled, otherwise a live set
+    // above the threshold is marked and swept at every conjoin step. Close to
+    // the limit collections become frequent rather than stopping altogether.
+    gc_threshold = std::min(std::max(gc_base, 2 * get_gc_footprint()), gc_limit);
+
+    const size_t kReclaimed = kAllocated - alive;
+    gc_collections++;
+    gc_reclaimed += kReclaimed;
+
+    #ifdef VERBOSE
+    printf("Garbage collection %lu: reclaimed %lu nodes, %lu nodes alive\n", gc_collections, kReclaimed, alive);
+    #endif
+
+    return kReclaimed;
+}
+
 std::string manager::get_literal_name(const literal_t &l) {
     const unsigned int LITERALS = g.get_nr_literals();
 
@@ -2,11 +2,14 @@
 
 #include <pthread.h>
 #include <thread>
+#include <array>
 #include "options.h"
 #include "exceptions.h"
 #include "timer.h"
 #include "bayesgraph.h"
 #include <unistd.h>
+#include <sched.h>
+#include <atomic>
 
 #undef likely
 #undef unlikely
@@ -27,22 +30,28 @@ namespace bnc {
 
 #define MAX_THREADS 64
 #define MAX_PARTITIONS 12
+#define MIN_RANGE 256       // minimal number of nodes per task
+#define RANGES_PER_THREAD 4 // number of tasks per thread per layer
 
 MultiGraph::Cache* g_cache[MAX_PARTITIONS];
 const SpanningTree* g_kSpanningTree[MAX_PARTITIONS];
+std::atomic<size_t>* g_pending[MAX_PARTITIONS];
 const uint32_t *g_kDimensions;
 bayesgraph const * g_kBayesgraph;
 unsigned int g_kThreadPoolSize;
 
 struct Task {
-    enum Type { kCompileOrNode = 0, kCompileOrNodes = 1, kCompilePartition = 2, kFinished = 3 };
+    enum Type { kCompileOrRange = 0, kCompileOrNodes = 1, kCompilePartition = 2, kFinished = 3, kCompileAndRange = 4, kCompileAndNodes = 5 };
 
     Type type;
     const SpanningTree * kSpanningTree;
     const SpanningTreeNode * kSpanningNode;
     const SpanningTreeNode * kChildSpanningNode;
     MultiGraph::Cache *cache;
-    unsigned int id;
+    MultiGraphComputedTable *table;
+    std::atomic<size_t> *pending; // unfinished tasks per layer
+    size_t begin; // range of parent ids
+    size_t end;
 };
 
 unsigned int thread_id;
@@ -60,23 +69,6 @@ concurrent_queue<Task> task_queue;
 
 pthread_barrier_t start_barrier;
 
-void compile_layer_and(const SpanningTree *kSpanningTree, const SpanningTreeNode *kSpanningNode, MultiGraph::Cache &cache){
-    assert(false && "not implemented");
-}
-
-void scheduler_compile_layer_and(const SpanningTree *kSpanningTree, const SpanningTreeNode *kSpanningNode, MultiGraph::Cache &cache){
-    assert(false && "not implemented");
-    if(OPT_PARALLEL_LEVEL == 3){
-        // create tasks that compute nodes in each layer in parallel
-        //XAry::Dimension dimension;
-        //dimension.resize(kSpanningNode->spanning.size());
-        //XAry::SetDimension(dimension.begin(), kSpanningNode->spanning.begin(), kSpanningNode->spanning.end(), g_kDimensions);
-
-    } else {
-        printf("Compile layer %lu/%lu (AND)\n", kSpanningNode->index, kSpanningTree->GetSize());
-    }
-}
-
 void set_edges(
         MultiGraph::Node * const node,
         const XAry::Bit * const xary_parent_ctr,
@@ -91,7 +83,7 @@ void set_edges(
     // ============ set edges
     if(kChildSpanningNode->xary.expand){
         const auto kChildId = XAry::GetDecimal(xary_child_ctr, kChildDimension, kChildCtrSize);
-        auto * const kChildNode = cache[kChildSpanningNode->index].GetOrNode(kChildId);
+        auto * const kChildNode = cache[kChildSpanningNode->index].map[kChildId];
 
         auto *edge = &(node->edges[0]);
         const auto * kEdgeEnd = &(node->edges[node->size]);
@@ -106,7 +98,7 @@ void set_edges(
         const auto * kEdgeEnd = &(node->edges[node->size]);
         while(edge != kEdgeEnd){
             const auto kChildId = XAry::GetDecimal(xary_child_ctr, kChildDimension, kChildCtrSize);
-            auto * const kChildNode = cache[kChildSpanningNode->index].GetOrNode(kChildId);
+            auto * const kChildNode = cache[kChildSpanningNode->index].map[kChildId];
 
             edge->to = kChildNode;
             ++child_ctr_parent_value;
@@ -115,6 +107,34 @@ void set_edges(
     }
 }
 
+void set_and_edges(
+        MultiGraph::Node ** const to,
+        const unsigned int kDimension,
+        const XAry::Bit * const xary_parent_ctr,
+        const SpanningTreeNode * const kChildSpanningNode,
+        MultiGraph::Cache &cache){
+
+    const XAry::Dim * const kChildDimension = &(kChildSpanningNode->xary.dimension[0]);
+    const unsigned int kChildCtrSize = kChildSpanningNode->spanning.size();
+    XAry::Bit xary_child_ctr[kChildCtrSize];
+    XAry::Set(xary_child_ctr, &(xary_child_ctr[kChildCtrSize]), xary_parent_ctr, &(kChildSpanningNode->xary.map[0]));
+
+    // ============ set AND node targets of one child per value
+    if(kChildSpanningNode->xary.expand){
+        const auto kChildId = XAry::GetDecimal(xary_child_ctr, kChildDimension, kChildCtrSize);
+        auto * const kChildNode = cache[kChildSpanningNode->index].map[kChildId];
+        for(unsigned int dim = 0; dim < kDimension; dim++)
+            to[dim] = kChildNode;
+    } else {
+        auto &child_ctr_parent_value = xary_child_ctr[kChildSpanningNode->xary.pos];
+        for(unsigned int dim = 0; dim < kDimension; dim++){
+            const auto kChildId = XAry::GetDecimal(xary_child_ctr, kChildDimension, kChildCtrSize);
+            to[dim] = cache[kChildSpanningNode->index].map[kChildId];
+            ++child_ctr_parent_value;
+        }
+    }
+}
+
 void set_weights(
         MultiGraph::Node * const node,
         const XAry::Bit * const xary_parent_ctr,
@@ -166,11 +186,23 @@ void set_weights(
     }
 }
 
+// with local structure, a node equal to one of another range or layer is
+// replaced by it, as in the serial compilation
+inline MultiGraph::Node* canonical(MultiGraph::Node * const node, MultiGraphComputedTable * const table){
+    if(OPT_ENCODE_STRUCTURE){
+        auto * const kCanonical = table->find_or_insert(node);
+        if(kCanonical)
+            return kCanonical;
+    }
+    return node;
+}
+
 void create_node_or(
         const SpanningTree * const kSpanningTree,
         const SpanningTreeNode * const kSpanningNode,
         const SpanningTreeNode * const kChildSpanningNode,
         MultiGraph::Cache &cache,
+        MultiGraphComputedTable * const table,
         const unsigned int kParentId){
 
     //printf("create node %lu:%lu\n", kSpanningNode->variable, kParentId);
@@ -181,7 +213,8 @@ void create_node_or(
     XAry::SetDecimal(xary_parent_ctr, kParentDimension, kParentCtrSize, kParentId);
 
     // ============ create node
-    auto *node = cache[kSpanningNode->index].CreateOrNode(kParentId);
+    auto &layer = cache[kSpanningNode->index];
+    auto *node = layer.CreateOrNode(kParentId);
     node->variable = kSpanningNode->variable;
 
     // add edges
@@ -190,32 +223,114 @@ void create_node_or(
     // add weights
     set_weights(node, xary_parent_ctr, kSpanningTree, kSpanningNode, cache);
 
+    // the slot of the parent id is private to the range, the map points
+    // to the canonical node
+    layer.map[kParentId] = canonical(node, table);
 }
 
-void compile_layer_or(const SpanningTree * const kSpanningTree, const SpanningTreeNode * const kSpanningNode, MultiGraph::Cache &cache){
-    const SpanningTreeNode * const kChildSpanningNode = &(kSpanningNode->children[0]);
-    const auto kNrParents = kSpanningNode->GetOrUpperbound();
-    for(unsigned int parent_id = 0; parent_id < kNrParents; parent_id++)
-        create_node_or(kSpanningTree, kSpanningNode, kChildSpanningNode, cache, parent_id);
+void create_node_and(
+        const SpanningTree * const kSpanningTree,
+        const SpanningTreeNode * const kSpanningNode,
+        MultiGraph::Cache &cache,
+        MultiGraphComputedTable * const table,
+        const unsigned int kParentId){
+
+    const XAry::Dim * const kParentDimension = &(kSpanningNode->xary.dimension[0]);
+    const unsigned int kParentCtrSize = kSpanningNode->spanning.size();
+    XAry::Bit xary_parent_ctr[kParentCtrSize];
+    XAry::SetDecimal(xary_parent_ctr, kParentDimension, kParentCtrSize, kParentId);
+
+    const auto kVariable = kSpanningNode->variable;
+    const auto kDimension = kSpanningNode->dimension;
+    const auto kNrChildren = kSpanningNode->children.size();
+    auto &layer = cache[kSpanningNode->index];
+
+    // ============ determine AND node connections per child
+    MultiGraph::Node* and_to[kNrChildren][kDimension];
+    for(unsigned int child = 0; child < kNrChildren; child++)
+        set_and_edges(and_to[child], kDimension, xary_parent_ctr, &(kSpanningNode->children[child]), cache);
+
+    // ============ create OR node with one AND node per value
+    auto *node = layer.CreateOrNode(kParentId);
+    node->variable = kVariable;
+    for(unsigned int dim = 0; dim < kDimension; dim++){
+        auto *and_node = layer.CreateAndNode(kParentId * kDimension + dim);
+        and_node->variable = kVariable;
+        and_node->SetAnd();
+        for(unsigned int child = 0; child < kNrChildren; child++)
+            and_node->edges[child].to = and_to[child][dim];
+
+        node->edges[dim].to = canonical(and_node, table);
+    }
+
+    // add weights
+    set_weights(node, xary_parent_ctr, kSpanningTree, kSpanningNode, cache);
+
+    layer.map[kParentId] = canonical(node, table);
 }
 
-void scheduler_compile_layer_or(const SpanningTree * const kSpanningTree, const SpanningTreeNode * const kSpanningNode, MultiGraph::Cache &cache){
+// a layer links to the maps of its children, they are complete once all of
+// their tasks have finished
+void wait_children(const SpanningTreeNode * const kSpanningNode, std::atomic<size_t> * const pending){
+    for(auto it = kSpanningNode->children.begin(); it != kSpanningNode->children.end(); it++)
+        if(!it->IsTerminal())
+            while(pending[it->index].load(std::memory_order_acquire) > 0)
+                sched_yield();
+}
+
+void compile_layer_or(const SpanningTree * const kSpanningTree, const SpanningTreeNode * const kSpanningNode, MultiGraph::Cache &cache, MultiGraphComputedTable * const table, std::atomic<size_t> * const pending, const size_t kBegin, const size_t kEnd){
     const SpanningTreeNode * const kChildSpanningNode = &(kSpanningNode->children[0]);
+    wait_children(kSpanningNode, pending);
+    for(size_t parent_id = kBegin; parent_id < kEnd; parent_id++)
+        create_node_or(kSpanningTree, kSpanningNode, kChildSpanningNode, cache, table, parent_id);
+    pending[kSpanningNode->index].fetch_sub(1, std::memory_order_release);
+}
+
+void compile_layer_or(const SpanningTree * const kSpanningTree, const SpanningTreeNode * const kSpanningNode, MultiGraph::Cache &cache, MultiGraphComputedTable * const table, std::atomic<size_t> * const pending){
+    compile_layer_or(kSpanningTree, kSpanningNode, cache, table, pending, 0, kSpanningNode->GetOrUpperbound());
+}
+
+void compile_layer_and(const SpanningTree * const kSpanningTree, const SpanningTreeNode * const kSpanningNode, MultiGraph::Cache &cache, MultiGraphComputedTable * const table, std::atomic<size_t> * const pending, const size_t kBegin, const size_t kEnd){
+    wait_children(kSpanningNode, pending);
+    for(size_t parent_id = kBegin; parent_id < kEnd; parent_id++)
+        create_node_and(kSpanningTree, kSpanningNode, cache, table, parent_id);
+    pending[kSpanningNode->index].fetch_sub(1, std::memory_order_release);
+}
+
+void compile_layer_and(const SpanningTree * const kSpanningTree, const SpanningTreeNode * const kSpanningNode, MultiGraph::Cache &cache, MultiGraphComputedTable * const table, std::atomic<size_t> * const pending){
+    compile_layer_and(kSpanningTree, kSpanningNode, cache, table, pending, 0, kSpanningNode->GetOrUpperbound());
+}
+
+/**
+ * Splits the assignments of the spanning context of a layer into ranges that
+ * are compiled by the threads. Nodes are addressed by their parent id, so each
+ * range writes to its own segment of the layer and no locking is required.
+ * The ranges of a layer start once those of its children have finished,
+ * layers are therefore scheduled children first.
+ */
+void scheduler_compile_layer(const SpanningTree * const kSpanningTree, const SpanningTreeNode * const kSpanningNode, MultiGraph::Cache &cache, MultiGraphComputedTable * const table, std::atomic<size_t> * const pending){
+    const bool kAnd = kSpanningNode->IsAndLayer();
 
     if(OPT_PARALLEL_LEVEL == 3){
         Task task;
-        task.type = Task::Type::kCompileOrNode;
+        task.type = (kAnd ? Task::Type::kCompileAndRange : Task::Type::kCompileOrRange);
         task.kSpanningTree = kSpanningTree;
         task.kSpanningNode = kSpanningNode;
-        task.kChildSpanningNode = kChildSpanningNode;
+        task.kChildSpanningNode = &(kSpanningNode->children[0]);
         task.cache = &cache;
+        task.table = table;
+        task.pending = pending;
 
         const unsigned int kNrThreads = g_kThreadPoolSize;
-
-
-        const auto kNrParents = kSpanningNode->GetOrUpperbound();
-        for(unsigned int parent_id = 0; parent_id < kNrParents; parent_id++){
-            task.id = parent_id;
+        const size_t kNrParents = kSpanningNode->GetOrUpperbound();
+        size_t range = (kNrParents + kNrThreads * RANGES_PER_THREAD - 1) / (kNrThreads * RANGES_PER_THREAD);
+        if(range < MIN_RANGE)
+            range = MIN_RANGE;
+        pending[kSpanningNode->index].store((kNrParents + range - 1) / range, std::memory_order_release);
+
+        for(size_t begin = 0; begin < kNrParents; begin += range){
+            task.begin = begin;
+            task.end = (begin + range < kNrParents ? begin + range : kNrParents);
             #if OPTION == 4 || OPTION == 3
             task_queue.push(task);
             #else
@@ -229,30 +344,33 @@ void scheduler_compile_layer_or(const SpanningTree * const kSpanningTree, const
             #endif
         }
 
+    } else if(kAnd){
+        compile_layer_and(kSpanningTree, kSpanningNode, cache, table, pending);
     } else {
-        compile_layer_or(kSpanningTree, kSpanningNode, cache);
+        compile_layer_or(kSpanningTree, kSpanningNode, cache, table, pending);
     }
 }
 
-void compile_partition(const SpanningTree *kSpanningTree, MultiGraph::Cache &cache){
+void compile_partition(const SpanningTree *kSpanningTree, MultiGraph::Cache &cache, MultiGraphComputedTable * const table, std::atomic<size_t> * const pending){
     assert(kSpanningTree->GetSize() == cache.size());
 
+    // the spanning nodes are in pre-order, reversed the children come first
     const auto kSpanningNodes = kSpanningTree->GetSpanningNodes();
-    const auto kSpanningNodeEnd = kSpanningNodes.end();
-    auto kSpanningNode_it = kSpanningNodes.begin();
+    const auto kSpanningNodeEnd = kSpanningNodes.rend();
+    auto kSpanningNode_it = kSpanningNodes.rbegin();
     while(kSpanningNode_it != kSpanningNodeEnd){
         const SpanningTreeNode *kSpanningNode = *kSpanningNode_it;
         if(!kSpanningNode->IsRoot() && !kSpanningNode->IsTerminal()){
             if(kSpanningNode->IsAndLayer())
-                compile_layer_and(kSpanningTree, kSpanningNode, cache);
-            else compile_layer_or(kSpanningTree, kSpanningNode, cache);
+                compile_layer_and(kSpanningTree, kSpanningNode, cache, table, pending);
+            else compile_layer_or(kSpanningTree, kSpanningNode, cache, table, pending);
         }
         ++kSpanningNode_it;
     }
 }
 
 
-void scheduler_compile_partition(const SpanningTree *kSpanningTree, MultiGraph::Cache &cache){
+void scheduler_compile_partition(const SpanningTree *kSpanningTree, MultiGraph::Cache &cache, MultiGraphComputedTable * const table, std::atomic<size_t> * const pending){
     if(OPT_PARALLEL_LEVEL == 2){
         // create tasks that compute layers in parallel
 
@@ -260,19 +378,19 @@ void scheduler_compile_partition(const SpanningTree *kSpanningTree, MultiGraph::
         task.type = Task::Type::kCompileOrNodes;
         task.kSpanningTree = kSpanningTree;
         task.cache = &cache;
+        task.table = table;
+        task.pending = pending;
 
         const unsigned int kNrThreads = g_kThreadPoolSize;
 
         const auto kSpanningNodes = kSpanningTree->GetSpanningNodes();
-        const auto kSpanningNodeEnd = kSpanningNodes.end();
-        auto kSpanningNode_it = kSpanningNodes.begin();
+        const auto kSpanningNodeEnd = kSpanningNodes.rend();
+        auto kSpanningNode_it = kSpanningNodes.rbegin();
         while(kSpanningNode_it != kSpanningNodeEnd){
             const SpanningTreeNode *kSpanningNode = *kSpanningNode_it;
             if(!kSpanningNode->IsRoot() && !kSpanningNode->IsTerminal()){
-                if(kSpanningNode->IsAndLayer()){
-                    assert(false && "not implemented");
-                } else {
-                    task.type = Task::Type::kCompileOrNodes;
+                {
+                    task.type = (kSpanningNode->IsAndLayer() ? Task::Type::kCompileAndNodes : Task::Type::kCompileOrNodes);
                     task.kSpanningNode = kSpanningNode;
                     #if OPTION == 4 || OPTION == 3
                     task_queue.push(task);
@@ -294,15 +412,12 @@ void scheduler_compile_partition(const SpanningTree *kSpanningTree, MultiGraph::
         assert(kSpanningTree->GetSize() == cache.size());
 
         const auto kSpanningNodes = kSpanningTree->GetSpanningNodes();
-        const auto kSpanningNodeEnd = kSpanningNodes.end();
-        auto kSpanningNode_it = kSpanningNodes.begin();
+        const auto kSpanningNodeEnd = kSpanningNodes.rend();
+        auto kSpanningNode_it = kSpanningNodes.rbegin();
         while(kSpanningNode_it != kSpanningNodeEnd){
             const SpanningTreeNode *kSpanningNode = *kSpanningNode_it;
-            if(!kSpanningNode->IsRoot() && !kSpanningNode->IsTerminal()){
-                if(kSpanningNode->IsAndLayer())
-                    scheduler_compile_layer_and(kSpanningTree, kSpanningNode, cache);
-                else scheduler_compile_layer_or(kSpanningTree, kSpanningNode, cache);
-            }
+            if(!kSpanningNode->IsRoot() && !kSpanningNode->IsTerminal())
+                scheduler_compile_layer(kSpanningTree, kSpanningNode, cache, table, pending);
             ++kSpanningNode_it;
         }
     }
@@ -327,16 +442,24 @@ void* pthread_worker(void *in){
             case Task::Type::kFinished:
                 return 0;
 
-            case Task::Type::kCompileOrNode:
-                create_node_or(task.kSpanningTree, task.kSpanningNode, task.kChildSpanningNode, *task.cache, task.id);
+            case Task::Type::kCompileOrRange:
+                compile_layer_or(task.kSpanningTree, task.kSpanningNode, *task.cache, task.table, task.pending, task.begin, task.end);
+                break;
+
+            case Task::Type::kCompileAndRange:
+                compile_layer_and(task.kSpanningTree, task.kSpanningNode, *task.cache, task.table, task.pending, task.begin, task.end);
                 break;
 
             case Task::Type::kCompileOrNodes:
-                compile_layer_or(task.kSpanningTree, task.kSpanningNode, *task.cache);
+                compile_layer_or(task.kSpanningTree, task.kSpanningNode, *task.cache, task.table, task.pending);
+                break;
+
+            case Task::Type::kCompileAndNodes:
+                compile_layer_and(task.kSpanningTree, task.kSpanningNode, *task.cache, task.table, task.pending);
                 break;
 
             case Task::Type::kCompilePartition:
-                compile_partition(task.kSpanningTree, *task.cache);
+                compile_partition(task.kSpanningTree, *task.cache, task.table, task.pending);
                 break;
             default:
                 assert(false && "Unknown task option");
@@ -357,6 +480,8 @@ void MultiGraph::ParallelScheduler(std::vector<MultiGraph> &multigraphs, const u
         for(unsigned int i = 0; i < multigraphs.size(); i++){
             task.kSpanningTree = &(multigraphs[i].spanningtree_);
             task.cache = &(multigraphs[i].cache_);
+            task.table = &(multigraphs[i].table_);
+            task.pending = g_pending[i];
             #if OPTION == 4 || OPTION == 3
             task_queue.push(task);
             #else
@@ -371,17 +496,14 @@ void MultiGraph::ParallelScheduler(std::vector<MultiGraph> &multigraphs, const u
         }
     } else {
         for(unsigned int i = 0; i < multigraphs.size(); i++){
-            scheduler_compile_partition(&(multigraphs[i].spanningtree_), multigraphs[i].cache_);
+            scheduler_compile_partition(&(multigraphs[i].spanningtree_), multigraphs[i].cache_, &(multigraphs[i].table_), g_pending[i]);
         }
     }
 }
 
 void MultiGraph::ParallelCompile(std::vector<MultiGraph> &multigraphs, const unsigned int kNrThreads, Timer &timer){
-    assert(!OPT_ENCODE_STRUCTURE && "Parallel compilation with local structure is not supported");
     assert(multigraphs.size() > 0 && multigraphs.size() <= MAX_PARTITIONS);
     assert(OPT_PARALLEL_LEVEL >= 0 && OPT_PARALLEL_LEVEL <= 3 && "Unknown parallel level");
-    for(unsigned int i = 0; i < multigraphs.size(); i++)
-        assert(!multigraphs[i].GetSpanningTree().IsTree() && "trees not yet supported");
 
     const unsigned int kMaxThreads = std::thread::hardware_concurrency();
     const unsigned int kMaxThreadPoolSize = (kMaxThreads-1<MAX_THREADS?kMaxThreads-1:MAX_THREADS);
@@ -416,10 +538,21 @@ void MultiGraph::ParallelCompile(std::vector<MultiGraph> &multigraphs, const uns
         g_cache[i] = &(multigraphs[i].cache_);
         g_kSpanningTree[i] = &(multigraphs[i].spanningtree_);
     }
-    // allocate
+    // allocate, the maps hold the canonical node of every parent id
     timer.Start();
-    for(unsigned int i = 0; i < multigraphs.size(); i++)
-        multigraphs[i].AllocateCache(false);
+    for(unsigned int i = 0; i < multigraphs.size(); i++){
+        MultiGraph &graph = multigraphs[i];
+        graph.AllocateCache(true);
+        if(OPT_ENCODE_STRUCTURE){
+            graph.table_.reserve(graph.spanningtree_.GetUpperbound());
+            graph.table_.set_concurrent(true);
+        }
+
+        const unsigned int kNrLayers = graph.spanningtree_.GetSize();
+        g_pending[i] = new std::atomic<size_t>[kNrLayers];
+        for(unsigned int layer = 0; layer < kNrLayers; layer++)
+            g_pending[i][layer].store(1, std::memory_order_relaxed);
+    }
     timer.Stop();
     timer.Add();
 
@@ -461,9 +594,29 @@ void MultiGraph::ParallelCompile(std::vector<MultiGraph> &multigraphs, const uns
 
     printf("Threading time: %.3lfms\n", timer.GetDuration<Timer::Milliseconds>());
 
-    // store roots
-    for(unsigned int i = 0; i < multigraphs.size(); i++)
-        multigraphs[i].root_ = multigraphs[i].cache_.GetRoot();
+    // store roots, disconnected components are joined by an AND node
+    for(unsigned int i = 0; i < multigraphs.size(); i++){
+        MultiGraph &graph = multigraphs[i];
+        const SpanningTreeNode &kSpanningRoot = graph.spanningtree_.GetRoot();
+        const auto &kComponents = kSpanningRoot.children;
+        std::vector<MultiGraph::Node*> roots(kComponents.size());
+        for(unsigned int component = 0; component < kComponents.size(); component++)
+            roots[component] = graph.cache_[kComponents[component].index].map[0];
+        if(kComponents.size() > 1)
+            graph.root_ = graph.JoinComponents(&kSpanningRoot, &(roots[0]));
+        else if(kComponents.size() == 1)
+            graph.root_ = roots[0];
+
+        // all layers are linked, so the maps are not needed anymore
+        const auto &kSpanningNodes = graph.spanningtree_.GetSpanningNodes();
+        for(auto it = kSpanningNodes.begin(); it != kSpanningNodes.end(); it++)
+            if(!(*it)->IsRoot() && !(*it)->IsTerminal())
+                graph.ReleaseMap(*it);
+
+        graph.table_.set_concurrent(false);
+        delete[] g_pending[i];
+        g_pending[i] = NULL;
+    }
 
     pthread_barrier_destroy(&start_barrier);
 }
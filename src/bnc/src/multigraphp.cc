@@ -5,6 +5,9 @@
 #include <unordered_map>
 #include <limits>
 #include "timer.h"
+#include <pthread.h>
+#include <thread>
+#include <atomic>
 
 
 namespace bnc {
@@ -12,6 +15,9 @@ namespace bnc {
 #define MULT_ASSIGN(a, b) __builtin_umull_overflow (a, b, &a)
 #define ADD_ASSIGN(a, b)  __builtin_uaddl_overflow (a, b, &a)
 
+// a layer maps its contexts sparsely if at most 1/SPARSE_RATIO of them is reachable
+#define SPARSE_RATIO 4
+
 template <class T>
 inline bool add_assign_or_fail(Bound::BoundSize &a, const T b){
     return ADD_ASSIGN(a, b);
@@ -29,6 +35,8 @@ MultiGraphProbability::MultiGraphProbability(){
     g_ = NULL;
     terminal_ = NULL;
     root_ = NULL;
+    memory_ = 0;
+    peak_memory_ = 0;
     initialized_ = false;
 }
 
@@ -59,6 +67,15 @@ void MultiGraphProbability::Compile(){
 }
 
 namespace bncp {
+struct ComponentWorker {
+    MultiGraphProbability *graph;
+    const SpanningTree *kSpanningTree;
+    const SpanningTreeNode *kSpanningRoot;
+    bool *traversed;
+    MultiGraphProbability::Node **roots;
+    std::atomic<unsigned int> *next;
+};
+
 inline bool Expand(const SpanningTreeNode *kSpanningNode, const Variable kVariable, bool *expands){
     auto kFirst = kSpanningNode->children.begin();
     const auto kLast = kSpanningNode->children.end();
@@ -105,6 +122,102 @@ void MultiGraphProbability::AddProbabilities(MultiGraphProbability::Node *node,
     }
 }
 
+bool MultiGraphProbability::Live(const SpanningTree *kSpanningTree, const SpanningTreeNode *kSpanningNode, const XAry &xary, const unsigned int kValue){
+    const auto &kMessages = kSpanningNode->messages;
+    for(auto it = kMessages.begin(); it != kMessages.end(); it++){
+        const auto kCpt = *it;
+
+        XAry &ctr = cpt_ctr_[kCpt];
+        ctr.Set(xary,kSpanningTree->cpt_map_[kCpt]);
+        ctr[kSpanningTree->cpt_variable_pos_[kCpt]] = kValue;
+        if(cpt_probabilities_[kCpt][ctr.GetDecimal()] == 0)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Propagates reachability from the root layer downwards. A context of a child
+ * layer is reachable if it is induced by a reachable context of its parent
+ * and a value of the parent variable that has nonzero weight in all messages.
+ * Contexts that are not reachable would only be connected to by edges that
+ * AddProbabilities redirects to the terminal, so they need not be compiled.
+ */
+void MultiGraphProbability::ComputeReachable(const SpanningTree *kSpanningTree, const SpanningTreeNode *kSpanningRoot){
+    reachable_[kSpanningRoot->index].push_back(0);
+
+    std::stack<const SpanningTreeNode*> s;
+    s.push(kSpanningRoot);
+    while(!s.empty()){
+        const auto *kSpanningNode = s.top();
+        s.pop();
+
+        // all parents of this layer have been visited
+        auto &contexts = reachable_[kSpanningNode->index];
+        std::sort(contexts.begin(), contexts.end());
+        contexts.erase(std::unique(contexts.begin(), contexts.end()), contexts.end());
+        if(kSpanningNode->IsLeaf())
+            continue;
+
+        XAry xary;
+        xary.SetDimension(bn_,kSpanningNode->spanning);
+        XAry::StepsizeList steps;
+        xary.CreateStepsizeList(steps);
+
+        const auto kNrChildren = kSpanningNode->children.size();
+        std::vector<XAry> xary_child(kNrChildren);
+        for(unsigned int child = 0; child < kNrChildren; child++)
+            xary_child[child].SetDimension(bn_,kSpanningNode->children[child].spanning);
+
+        for(auto it = contexts.begin(); it != contexts.end(); it++){
+            xary.SetDecimal(steps, *it);
+            for(unsigned int value = 0; value < kSpanningNode->dimension; value++){
+                if(!Live(kSpanningTree, kSpanningNode, xary, value))
+                    continue;
+
+                for(unsigned int child = 0; child < kNrChildren; child++){
+                    const SpanningTreeNode &kChild = kSpanningNode->children[child];
+                    if(kChild.IsTerminal())
+                        continue;
+
+                    XAry &ctr = xary_child[child];
+                    ctr.Set(xary,kChild.xary.map);
+                    if(!kChild.xary.expand)
+                        ctr[kChild.xary.pos] = value;
+
+                    auto &child_contexts = reachable_[kChild.index];
+                    const size_t kId = ctr.GetDecimal();
+                    if(child_contexts.empty() || child_contexts.back() != kId)
+                        child_contexts.push_back(kId);
+                }
+            }
+        }
+
+        for(auto it = kSpanningNode->children.begin(); it != kSpanningNode->children.end(); it++)
+            s.push(&(*it));
+    }
+}
+
+// returns the sorted contexts to compile in a layer, or NULL to compile all of them
+const std::vector<size_t>* MultiGraphProbability::GetContexts(const SpanningTreeNode *kSpanningNode){
+    if(reachable_.empty())
+        return NULL;
+
+    const CacheLayer &kCache = cache_[kSpanningNode->index];
+    return (kCache.sparse ? &(kCache.ids) : &(reachable_[kSpanningNode->index]));
+}
+
+inline bool NextContext(XAry &xary, const XAry::StepsizeList &kSteps, const std::vector<size_t> *kContexts, const size_t kPosition){
+    if(!kContexts)
+        return xary.Increment();
+
+    if(kPosition == kContexts->size())
+        return false;
+
+    xary.SetDecimal(kSteps, (*kContexts)[kPosition]);
+    return true;
+}
+
 void MultiGraphProbability::AddEdges(MultiGraphProbability::Node **to, const XAry &xary, XAry &xary_child, const SpanningTreeNode *kChildSpanningNode, const unsigned int kDimension, const bool kExpand){
     #ifdef DEBUG
     assert((xary_child.Max(kChildSpanningNode->xary.restrict_dimension) == 1 || xary_child.Max(kChildSpanningNode->xary.restrict_dimension) == kDimension) && "Parent has too many children");
@@ -113,7 +226,7 @@ void MultiGraphProbability::AddEdges(MultiGraphProbability::Node **to, const XAr
     xary_child.Set(xary,kChildSpanningNode->xary.map);
     unsigned int value = 0; // kVariable is equal to 'value'
     do {
-        auto * const kChildNode = cache_[kChildSpanningNode->index].map[xary_child.GetDecimal()];
+        auto * const kChildNode = cache_[kChildSpanningNode->index].Lookup(xary_child.GetDecimal());
         // add edge(s) kParentId -> kChildId
 
         do {
@@ -131,7 +244,7 @@ void MultiGraphProbability::AddEdges(MultiGraphProbability::Node *node, const XA
     xary_child.Set(xary,kChildSpanningNode->xary.map);
     unsigned int value = 0; // kVariable is equal to 'value'
     do {
-        auto * const kChildNode = cache_[kChildSpanningNode->index].map[xary_child.GetDecimal()];
+        auto * const kChildNode = cache_[kChildSpanningNode->index].Lookup(xary_child.GetDecimal());
 
         // add edge(s) kParentId -> kChildId
         do {
@@ -159,14 +272,27 @@ void MultiGraphProbability::CreateOrNodes(const SpanningTree *kSpanningTree, con
     const auto kIndex = kSpanningNode->index;
     const bool kExpand = kChildSpanningNode->spanning.find(kVariable) == kChildSpanningNode->spanning.end();
 
+    // enumerate either all or only the reachable contexts
+    const std::vector<size_t> *kContexts = GetContexts(kSpanningNode);
+    XAry::StepsizeList steps;
+    if(kContexts){
+        if(kContexts->empty())
+            return;
+
+        xary.CreateStepsizeList(steps);
+        xary.SetDecimal(steps, (*kContexts)[0]);
+    }
+
     // layer caching
     CacheLayer &cache = cache_[kIndex];
     auto *map = &(cache.map[0]);
     auto *node = cache.CreateOrNode();
 
     // create level connections
-    unsigned int parent_id = 0;
+    size_t position = 0;
     do {
+        const size_t kParentId = (cache.sparse || !kContexts ? position : (*kContexts)[position]);
+
         // create OR node
         node->variable = kVariable;
         AddEdges(node, xary, xary_child, kChildSpanningNode, kDimension, kExpand);
@@ -175,15 +301,13 @@ void MultiGraphProbability::CreateOrNodes(const SpanningTree *kSpanningTree, con
         // canonical check and caching
         auto *canonical = Canonical<STRUCTURE>(node);
         if(canonical){
-            map[parent_id] = canonical;
+            map[kParentId] = canonical;
         } else {
             cache.StoreOrNode();
-            map[parent_id] = node;
+            map[kParentId] = node;
             node = cache.CreateOrNode();
         }
-
-        ++parent_id;
-    } while(xary.Increment());
+    } while(NextContext(xary, steps, kContexts, ++position));
 }
 
 template<bool STRUCTURE>
@@ -213,6 +337,17 @@ void MultiGraphProbability::CreateAndNodes(const SpanningTree *kSpanningTree, co
     const bool kExpand = Expand(kSpanningNode, kVariable, expand_child);
     assert(kNrChildren * kDimension < 10000 && "requesting a lot of stack memory, adjust limit?");
 
+    // enumerate either all or only the reachable contexts
+    const std::vector<size_t> *kContexts = GetContexts(kSpanningNode);
+    XAry::StepsizeList steps;
+    if(kContexts){
+        if(kContexts->empty())
+            return;
+
+        xary.CreateStepsizeList(steps);
+        xary.SetDecimal(steps, (*kContexts)[0]);
+    }
+
     // layer caching
     CacheLayer &cache = cache_[kIndex];
     auto *map = &(cache.map[0]);
@@ -221,10 +356,12 @@ void MultiGraphProbability::CreateAndNodes(const SpanningTree *kSpanningTree, co
     Node* and_to[kNrChildren][kDimension];
     Node* or_to[kDimension];
 
-    unsigned int parent_id = 0;
+    size_t position = 0;
     Node *and_node = NULL;
     Node *node = cache.CreateOrNode();
     do {
+        const size_t kParentId = (cache.sparse || !kContexts ? position : (*kContexts)[position]);
+
         // determine connections for AND nodes
         child = 0;
         kChildSpanningNode = kChildSpanningNodeBegin;
@@ -237,6 +374,13 @@ void MultiGraphProbability::CreateAndNodes(const SpanningTree *kSpanningTree, co
         // create #kDimension AND nodes
         unsigned int dim = 0;
         while(dim < kDimension){
+            // unreachable children, the edge is redirected to the terminal
+            if(kContexts && !Live(kSpanningTree, kSpanningNode, xary, dim)){
+                or_to[dim] = terminal_;
+                ++dim;
+                continue;
+            }
+
             if(and_node == NULL)
                 and_node = cache.CreateAndNode();
 
@@ -275,15 +419,13 @@ void MultiGraphProbability::CreateAndNodes(const SpanningTree *kSpanningTree, co
         // canonical check and caching
         auto *canonical = Canonical<STRUCTURE>(node);
         if(canonical){
-            map[parent_id] = canonical;
+            map[kParentId] = canonical;
         } else {
             cache.StoreOrNode();
-            map[parent_id] = node;
+            map[kParentId] = node;
             node = cache.CreateOrNode();
         }
-
-        ++parent_id;
-    } while(xary.Increment());
+    } while(NextContext(xary, steps, kContexts, ++position));
 }
 
 
@@ -295,6 +437,14 @@ void MultiGraphProbability::CreateNodes(const SpanningTree *kSpanningTree, const
     if(kSpanningNode->children.size() > 1)
         CreateAndNodes<STRUCTURE>(kSpanningTree, kSpanningNode);
     else CreateOrNodes<STRUCTURE>(kSpanningTree, kSpanningNode);
+
+    if(!reachable_.empty())
+        std::vector<size_t>().swap(reachable_[kSpanningNode->index]);
+
+    // every layer has a single parent, so the child maps are not needed anymore
+    for(auto it = kSpanningNode->children.begin(); it != kSpanningNode->children.end(); it++)
+        if(!it->IsTerminal())
+            ReleaseMap(&(*it));
 }
 
 template <bool STRUCTURE>
@@ -318,6 +468,10 @@ template<bool STRUCTURE>
 MultiGraphProbability::Node* MultiGraphProbability::Compile(const SpanningTree *kSpanningTree, const SpanningTreeNode *kSpanningRoot, bool traversed[]){
     assert(!kSpanningRoot->IsRoot());
 
+    // determinism makes contexts unreachable, only compile the others
+    if(!reachable_.empty())
+        ComputeReachable(kSpanningTree, kSpanningRoot);
+
     // compile given spanning tree (based on pseudo tree)
     std::stack<const SpanningTreeNode*> s;
     s.push(kSpanningRoot);
@@ -351,6 +505,7 @@ MultiGraphProbability::Node* MultiGraphProbability::Compile(const SpanningTree *
 
     assert(cache_[kSpanningRoot->index].map.GetSize() == 2);
     Node *kRoot = cache_[kSpanningRoot->index].map[0];
+    ReleaseMap(kSpanningRoot);
     return kRoot;
 }
 
@@ -362,19 +517,82 @@ void MultiGraphProbability::Compile(const SpanningTree &kSpanningTree){
     cache_.Resize(kNrLayers);
     terminal_ = cache_.GetTerminal();
 
-    // init computed table
+    // init unique table, it grows if the upper bound is exceeded
     table_.reserve(kSpanningTree.GetUpperbound());
-    table_.max_load_factor(INFINITY);
 
     bool traversed[kNrLayers] = {0};
 
     auto *kSpanningNode = &kSpanningTree.GetRoot();
     assert(kSpanningNode->IsRoot());
-    if(kSpanningNode->children.size() > 1){
-        assert(false && "disconnected components not yet supported");
-    } else if(kSpanningNode->children.size() == 1){
-        root_ = Compile<STRUCTURE>(&kSpanningTree, &(kSpanningNode->children[0]), traversed);
+    const auto &kComponents = kSpanningNode->children;
+    if(kComponents.empty())
+        return;
+
+    if(OPT_DETERMINISM && OPT_SPARSE_LAYERS)
+        reachable_.resize(kNrLayers);
+
+    if(kComponents.size() == 1){
+        root_ = Compile<STRUCTURE>(&kSpanningTree, &(kComponents[0]), traversed);
+    } else {
+        // components share no variables nor cpts, thus only the unique table is shared
+        const unsigned int kNrComponents = kComponents.size();
+        unsigned int threads = (OPT_WORKERS > 0 ? OPT_WORKERS : std::thread::hardware_concurrency());
+        if(threads > kNrComponents)
+            threads = kNrComponents;
+        if(threads == 0)
+            threads = 1;
+
+        std::vector<Node*> roots(kNrComponents, NULL);
+        std::atomic<unsigned int> next(0);
+        ComponentWorker worker = { this, &kSpanningTree, kSpanningNode, traversed, &(roots[0]), &next };
+
+        table_.set_concurrent(threads > 1);
+        std::vector<pthread_t> thread(threads);
+        for(unsigned int i = 0; i < threads; i++){
+            if(pthread_create(&(thread[i]), NULL, CompileComponents<STRUCTURE>, (void*) &worker))
+                throw compiler_exception("Error creating thread %u of %u", i+1, threads);
+        }
+        for(unsigned int i = 0; i < threads; i++){
+            if(pthread_join(thread[i], NULL))
+                throw compiler_exception("Error joining thread %u of %u", i+1, threads);
+        }
+        table_.set_concurrent(false);
+
+        root_ = JoinComponents(kSpanningNode, &(roots[0]));
     }
+    reachable_.clear();
+}
+
+template <bool STRUCTURE>
+void* MultiGraphProbability::CompileComponents(void *arg){
+    ComponentWorker *worker = (ComponentWorker*) arg;
+    MultiGraphProbability *graph = worker->graph;
+    const auto &kComponents = worker->kSpanningRoot->children;
+
+    unsigned int component;
+    while((component = (*(worker->next))++) < kComponents.size())
+        worker->roots[component] = graph->Compile<STRUCTURE>(worker->kSpanningTree, &(kComponents[component]), worker->traversed);
+
+    return NULL;
+}
+
+// joins the roots of the disconnected components by an AND node in the auxiliary root layer
+MultiGraphProbability::Node* MultiGraphProbability::JoinComponents(const SpanningTreeNode *kSpanningRoot, Node **roots){
+    const auto kNrComponents = kSpanningRoot->children.size();
+
+    auto &local_cache = cache_[kSpanningRoot->index];
+    local_cache.SetNodeProperties(0, kNrComponents);
+    local_cache.Resize(0, 0, 0, 1, kNrComponents);
+    AddMemory(local_cache.GetBytes());
+
+    Node *node = local_cache.CreateAndNode(0);
+    local_cache.StoreAndNode();
+    node->variable = kSpanningRoot->variable;
+    node->SetAnd();
+    for(unsigned int component = 0; component < kNrComponents; component++)
+        node->edges[component].to = roots[component];
+
+    return node;
 }
 
 void MultiGraphProbability::DumpDot(std::vector<MultiGraphProbability>& graphs){
@@ -894,13 +1112,49 @@ void MultiGraphProbability::AllocateCacheLayer(const SpanningTreeNode* const kSp
     assert(kSpanningNode->index < cache_.size());
 
     auto &local_cache = cache_[kSpanningNode->index];
+    RemoveMemory(local_cache.GetBytes());
     local_cache.SetNodeProperties(kSpanningNode->GetNrEdgesPerOr(), kSpanningNode->GetNrEdgesPerAnd());
+
+    if(kHasMap && !reachable_.empty()){
+        // at most one OR node per reachable context
+        auto &contexts = reachable_[kSpanningNode->index];
+        const size_t kOrAlloc = contexts.size()+1;
+        const size_t kAndAlloc = (kSpanningNode->IsAndLayer()?contexts.size()*kSpanningNode->GetNrEdgesPerOr()+1:0);
+
+        local_cache.sparse = contexts.size() * SPARSE_RATIO <= kSpanningNode->cardinality;
+        local_cache.Resize(
+            (local_cache.sparse?kOrAlloc:kSpanningNode->GetMapAllocUpperbound()),
+            kOrAlloc,
+            kOrAlloc * kSpanningNode->GetNrEdgesPerOr(),
+            kAndAlloc,
+            kAndAlloc * kSpanningNode->GetNrEdgesPerAnd());
+
+        if(local_cache.sparse)
+            local_cache.ids.swap(contexts);
+        else local_cache.map.SetZero(); // unreachable contexts map to NULL
+
+        AddMemory(local_cache.GetBytes());
+        return;
+    }
+
     local_cache.Resize(
         (kHasMap?kSpanningNode->GetMapAllocUpperbound():0),
         kSpanningNode->GetOrAllocUpperbound(),
         kSpanningNode->GetOrEdgeAllocUpperbound(),
         kSpanningNode->GetAndAllocUpperbound(),
         kSpanningNode->GetAndEdgeAllocUpperbound());
+
+    AddMemory(local_cache.GetBytes());
+}
+
+void MultiGraphProbability::ReleaseMap(const SpanningTreeNode* const kSpanningNode){
+    auto &local_cache = cache_[kSpanningNode->index];
+    const size_t kBytes = local_cache.GetBytes();
+    local_cache.ReleaseMap();
+    RemoveMemory(kBytes - local_cache.GetBytes());
+
+    // the parent has linked to the layer, so it is finished
+    local_cache.Evict();
 }
 
 void MultiGraphProbability::AllocateCache(const bool kHasMap){
@@ -931,6 +1185,10 @@ const MultiGraphProbability::Node* MultiGraphProbability::GetRoot() const {
     return root_;
 }
 
+const MultiGraphProbability::Node* MultiGraphProbability::GetTerminal() const {
+    return terminal_;
+}
+
 template void MultiGraphProbability::Compile<true>();
 template void MultiGraphProbability::Compile<false>();
 
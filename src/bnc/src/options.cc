@@ -4,6 +4,9 @@ namespace bnc {
 
 filename_t files;
 float OPT_COMPUTED_TABLE_LOAD_FACTOR;
+double OPT_GC_THRESHOLD;
+unsigned int OPT_SIFT;
+double OPT_SIFT_GROWTH;
 size_t OPT_COMPUTED_TABLE_BUCKETS;
 int OPT_LOOKAHEAD;
 int OPT_TIME_LIMIT;
@@ -35,6 +38,7 @@ bool
     OPT_WRITE_PS,
     OPT_WRITE_CNF,
     OPT_SA_PARALLELISM,
+    OPT_SA_TEMPERING,
     OPT_WRITE_AC,
     OPT_WRITE_UAI,
     OPT_ORDER_POST_WEIGHT,
@@ -51,9 +55,14 @@ bool
     OPT_SA_PRINT_ORDERING,
     OPT_TOPDOWN_COMPILATION,
     OPT_BEST_COMPOSITION_ORDERING,
-    OPT_SHOW_SCORE;
+    OPT_SHOW_SCORE,
+    OPT_GARBAGE_COLLECTION,
+    OPT_COMPONENT_CACHE,
+    OPT_SPARSE_LAYERS,
+    OPT_HUGE_PAGES;
 
 unsigned int OPT_PARALLEL_LEVEL;
+unsigned int OPT_CUBE_DEPTH;
 int OPT_PARALLEL_CPT;
 int OPT_NR_PARTITIONS;
 int OPT_SA_ITERATIONS;
@@ -63,7 +72,14 @@ double OPT_SA_TEMPERATURE_INITIAL;
 double OPT_SA_TEMPERATURE_MIN;
 double OPT_SA_TEMPERATURE_DAMP_FACTOR;
 double OPT_SA_SCORE_RATIO;
+double OPT_SA_TIME;
 unsigned int OPT_WORKERS;
+unsigned int OPT_BB_MEMORY;
+unsigned int OPT_MEMORY_LIMIT;
+int OPT_ADAPTIVE_PARTITIONS;
+std::string OPT_CACHE_DIR;
+std::string OPT_OUT_OF_CORE_DIR;
+unsigned int OPT_NUMA_PLACEMENT;
 
 void init_options(){
     OPT_PARTITION =
@@ -95,6 +111,8 @@ void init_options(){
     OPT_NO_COMPILE =
     OPT_NO_ORDERING =
     OPT_SA_PRINT_ORDERING =
+    OPT_GARBAGE_COLLECTION =
+    OPT_HUGE_PAGES =
     OPT_TOPDOWN_COMPILATION = false;
 
     OPT_USE_PROBABILITY =
@@ -106,6 +124,9 @@ void init_options(){
     OPT_PARALLEL_PARTITION =
     OPT_DETERMINISM =
     OPT_ENCODE_STRUCTURE =
+    OPT_COMPONENT_CACHE =
+    OPT_SPARSE_LAYERS =
+    OPT_SA_TEMPERING =
     OPT_BEST_COMPOSITION_ORDERING = true;
     OPT_PARALLEL_CPT = 1;
     OPT_TIME_LIMIT = -1;
@@ -113,19 +134,30 @@ void init_options(){
     OPT_RESERVE = 0;
     OPT_ORDER = -1;
     OPT_LOOKAHEAD = 3;
+    OPT_BB_MEMORY = 1024;
+    OPT_MEMORY_LIMIT = 0; // Mb, 0 = no limit
+    OPT_ADAPTIVE_PARTITIONS = 0; // max partitions, 0 = no retries
+    OPT_CACHE_DIR.clear(); // empty = no artifact cache
+    OPT_OUT_OF_CORE_DIR.clear(); // empty = layers on the heap
+    OPT_NUMA_PLACEMENT = 0; // 0 = default, 1 = first touch, 2 = interleave
     OPT_BDD_TYPE = bdd_t::tdmultigraph;
     OPT_COMPILATION_TYPE = compilation_t::topdown_bottomup;
     OPT_SA_ITERATIONS = 100;
     OPT_SA_TRIES = 100;
     OPT_SA_RUNS = 1;
     OPT_SA_SCORE_RATIO = 0.6;
+    OPT_SA_TIME = 10;
     OPT_SA_TEMPERATURE_INITIAL = 5000;
     OPT_SA_TEMPERATURE_MIN = 5.0e-1;
     OPT_SA_TEMPERATURE_DAMP_FACTOR = 1.01;
     OPT_COMPUTED_TABLE_BUCKETS = 1024;
     OPT_COMPUTED_TABLE_LOAD_FACTOR = 1.0;
+    OPT_GC_THRESHOLD = 0.5;
+    OPT_SIFT = 0;
+    OPT_SIFT_GROWTH = 1.2;
     OPT_WORKERS = 0; // 0 = auto determine, 1 = disable parallelism
     OPT_PARALLEL_LEVEL = 3;
+    OPT_CUBE_DEPTH = 0; // 0 = auto determine
 }
 
 }
@@ -22,6 +22,9 @@ using namespace bnc;
 ordering_t::ordering_t(){
 }
 
+ordering_t::ordering_t(const ordering_t &o) : std::vector<literal_t>(o){
+}
+
 ordering_t& ordering_t::operator=(const ordering_t &o){
     std::vector<literal_t>::operator=(o);
     return *this;
@@ -216,7 +216,10 @@ bool DaooptAPI::GenerateTree(bayesnet *bn, const partition_t &kPartition){
     // simulate argv argc
     wordexp_t p;
     p.we_offs = 1;
-    wordexp("-f foo.uai --cvo --adaptive --orderIter 500 --orderTime 60", &p, WRDE_DOOFFS);
+    std::string arguments = "-f foo.uai --adaptive --orderIter 500 --orderTime 60";
+    if(bnc::OPT_WORKERS > 0)
+        arguments += " --orderThreads " + std::to_string(bnc::OPT_WORKERS);
+    wordexp(arguments.c_str(), &p, WRDE_DOOFFS);
     p.we_wordv[0] = "foo";
 
     char **argv = p.we_wordv;
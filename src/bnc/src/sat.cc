@@ -13,6 +13,7 @@ using namespace std;
 
 sat::sat(){
     mapped = false;
+    tracking = false;
     W = NULL;
     manager = NULL;
 }
@@ -56,22 +57,31 @@ void sat::init(BayesNode *n){
             literals[i] = l;
     }
 
-    // determine which literal is present in which clauses
+    // register family
+    const unsigned int kFamily = families.size();
+    families.resize(kFamily+1);
+    variable_to_families.resize(VARIABLES);
+    for(unsigned int i = 0; i < kNrLiterals; i++){
+        unsigned int v = literal_to_variable[literals[i]];
+        families.back().push_back(v);
+        variable_to_families[v].push_back(kFamily);
+    }
+
+    // store clauses, each clause initially watches its first literal
     XAry xary;
     xary.SetDimension(n->GetDimensions());
     xary.SetZero();
     const auto &kWeights = n->GetWeights();
-    literal_to_clause.resize(LITERALS+1);
+    watches.resize(LITERALS+1);
     size_t clause_nr = 0;
     do {
         unsigned int w = kWeights[clause_nr++];
 
         clause_to_weight.push_back(w);
-        unsat_literals.push_back(kNrLiterals);
-        for(unsigned int i = 0; i < kNrLiterals; i++){
-            literal_t l = literals[i]+xary[i];
-            literal_to_clause[l].push_back(CLAUSES);
-        }
+        clause_begin.push_back(clause_literals.size());
+        for(unsigned int i = 0; i < kNrLiterals; i++)
+            clause_literals.push_back(literals[i]+xary[i]);
+        watches[literals[0]+xary[0]].push_back(CLAUSES);
         CLAUSES++;
     } while(xary.Increment());
 }
@@ -155,65 +165,72 @@ void sat::init(bayesgraph &g, int variable){
 
     // DEBUG: VARIALBES == variable_to_literal.size() == dimension.size();
     // DEBUG: CLAUSES == clauses_to_weight.size()
-    // DEBUG: LITERALS == literal_to_variable.size() == literal_to_clause.size()
+    // DEBUG: LITERALS == literal_to_variable.size() == watches.size()
 
-    total_unsat_clauses = CLAUSES;
+    clause_begin.push_back(clause_literals.size());
     total_unsat_variables = VARIABLES;
 
     sat_variable.resize(VARIABLES);
-    literal_constraint.resize(LITERALS+1);
-    sat_literal_clause.resize(CLAUSES);
+    literal_value.resize(LITERALS+1);
 
     literals_left = dimension;
     fill(sat_variable.begin(), sat_variable.end(), false);
-    fill(literal_constraint.begin(), literal_constraint.end(), false);
-    fill(sat_literal_clause.begin(), sat_literal_clause.end(), 0);
+    fill(literal_value.begin(), literal_value.end(), 0);
+
+    family_unsat_variables.resize(families.size());
+    for(unsigned int f = 0; f < families.size(); f++)
+        family_unsat_variables[f] = families[f].size();
 }
 
-satisfy_t sat::impose_constraint(literal_t l){
-    literal_t L = abs(l);
-    variable_t v = literal_to_variable[L];
-    if(sat_variable[v]){
-        return redundant;
-    } else {
-        history.resize(history.size()+1);
-        history.back().push_back(l);
-        #ifdef DEBUG
-        if(literal_constraint[abs(l)])
-            fprintf(stderr, "already conditioned on literal %d\n", l);
-        #endif
-        literal_constraint[abs(l)] = true;
-        if(negated(l)) {
-            unsigned int &count = literals_left[literal_to_variable[L]];
-            count--;
-
-            if(count == 0)
-                return unsatisfiable;
-            else return unsatisfied;
-        } else {
-            for(unsigned int i = 0; i < dimension[v]; i++){
-                literal_t l = variable_to_literal[v] + i;
-                if(!literal_constraint[l])
-                    history.back().push_back(-1*l);
-            }
-            sat_variable[v] = true;
-            total_unsat_variables--;
-            return satisfiable;
-        }
+inline void sat::set_state(literal_t L, uint64_t bits){
+    const size_t kBit = 2 * (size_t) L;
+    uint64_t &word = residual_state[kBit / 64];
+    word = (word & ~(3ULL << (kBit % 64))) | (bits << (kBit % 64));
+}
+
+inline void sat::set_value(literal_t L, int8_t value){
+    literal_value[L] = value;
+    if(tracking && variable_open_families[literal_to_variable[L]] > 0)
+        set_state(L, value + 1);
+}
+
+inline void sat::assign(literal_t l){
+    set_value(abs(l), negated(l) ? -1 : 1);
+    trail.push_back(l);
+}
+
+// the literals of a variable are part of the residual key as long as one of
+// its families is open
+void sat::open_family(unsigned int f){
+    const std::vector<unsigned int> &kFamily = families[f];
+    for(auto it = kFamily.begin(); it != kFamily.end(); it++){
+        if(variable_open_families[*it]++ > 0)
+            continue;
+
+        const literal_t kBase = variable_to_literal[*it];
+        for(unsigned int d = 0; d < dimension[*it]; d++)
+            set_state(kBase+d, literal_value[kBase+d] + 1);
     }
 }
 
-void sat::release_constraint(literal_t l){
-    literal_constraint[abs(l)] = false;
-    if(negated(l)) {
-        unsigned int &count = literals_left[literal_to_variable[abs(l)]];
-        count++;
-    } else {
-        sat_variable[literal_to_variable[l]] = false;
-        total_unsat_variables++;
+void sat::close_family(unsigned int f){
+    const std::vector<unsigned int> &kFamily = families[f];
+    for(auto it = kFamily.begin(); it != kFamily.end(); it++){
+        if(--variable_open_families[*it] > 0)
+            continue;
+
+        const literal_t kBase = variable_to_literal[*it];
+        for(unsigned int d = 0; d < dimension[*it]; d++)
+            set_state(kBase+d, 3);
     }
 }
 
+/**
+ * Conditions the theory on literal l. A clause (a row of a CPT) contributes its
+ * weight once all its literals are positive. Every clause watches one literal
+ * that is not positive, so only the clauses watching l are visited. Watches
+ * stay valid when the trail is undone, thus undo never touches the clauses.
+ */
 template <bool DETERMINISM>
 satisfy_t sat::condition(literal_t l){
     if(mapped){
@@ -226,110 +243,154 @@ satisfy_t sat::condition(literal_t l){
         l = literal_map[l];
     }
 
-    satisfy_t c_l = impose_constraint(l);
-    if(c_l != redundant){
-        for(auto it = history.back().begin(); it != history.back().end(); it++){
-            literal_t l = *it;
-            if(negated(l)){
-                // condition f on negated l
-                std::vector<literal_t> &l_to_c = literal_to_clause[-1*l];
-                for(auto it = l_to_c.begin(); it != l_to_c.end(); it++){
-                    unsigned int c = *it;
-                    literal_t &sat_l = sat_literal_clause[c];
-
-                    if(!sat_l){
-                        sat_l = l;
-                        total_unsat_clauses--;
-                    }
+    const literal_t L = abs(l);
+    const variable_t v = literal_to_variable[L];
+    if(sat_variable[v])
+        return redundant;
+
+    #ifdef DEBUG
+    if(literal_value[L] != 0)
+        fprintf(stderr, "already conditioned on literal %d\n", l);
+    #endif
+
+    trail_lim.push_back(trail.size());
+    assign(l);
+    if(negated(l)){
+        unsigned int &count = literals_left[v];
+        count--;
+
+        // an open clause remains as long as v has a value left
+        if(count == 0)
+            return unsatisfiable;
+        else return unsatisfied;
+    }
+
+    for(unsigned int i = 0; i < dimension[v]; i++){
+        literal_t m = variable_to_literal[v] + i;
+        if(!literal_value[m])
+            assign(-1*m);
+    }
+    sat_variable[v] = true;
+    total_unsat_variables--;
+    const std::vector<unsigned int> &kFamilies = variable_to_families[v];
+    for(auto it = kFamilies.begin(); it != kFamilies.end(); it++)
+        if(--family_unsat_variables[*it] == 0 && tracking)
+            close_family(*it);
+
+    satisfy_t c_l = satisfiable;
+    std::vector<unsigned int> &watching = watches[L];
+    for(size_t i = 0; i < watching.size();){
+        const unsigned int c = watching[i];
+
+        // find another literal to watch
+        literal_t *m = &clause_literals[clause_begin[c]];
+        literal_t *kEnd = &clause_literals[clause_begin[c+1]];
+        while(m != kEnd && literal_value[*m] == 1)
+            m++;
+
+        if(m != kEnd){
+            watches[*m].push_back(c);
+            watching[i] = watching.back();
+            watching.pop_back();
+        } else {
+            // all literals positive, clause keeps watching l
+            weight_t w = clause_to_weight[c];
+            if(DETERMINISM){
+                if(w == 0)
+                    c_l |= unsatisfiable;
+                else if(w != 1){
+                    if(!W) W = bnc::create_weights(manager);
+                    W->insert(w);
                 }
             } else {
-                // condition f on l
-                std::vector<literal_t> &l_to_c = literal_to_clause[l];
-                for(auto it = l_to_c.begin(); it != l_to_c.end(); it++){
-                    unsigned int c = *it;
-
-                    literal_t &sat_l = sat_literal_clause[c];
-                    if(!sat_l){
-                        uint8_t &unsat_l = unsat_literals[c];
-                        unsat_l--;
-                        if(unsat_l == 0){
-                            total_unsat_clauses--;
-                            sat_l = l;
-
-                            weight_t w = clause_to_weight[c];
-                            if(DETERMINISM){
-                                if(w == 0)
-                                    c_l |= unsatisfiable;
-                                else if(w != 1){
-                                    if(!W) W = bnc::create_weights(manager);
-                                    W->insert(w);
-                                }
-                            } else {
-                                if(!W) W = bnc::create_weights(manager);
-                                W->insert(w);
-                            }
-                        }
-                    }
-                }
+                if(!W) W = bnc::create_weights(manager);
+                W->insert(w);
             }
+            i++;
         }
-        #ifdef DEBUG
-        if((total_unsat_clauses != 0 && total_unsat_variables == 0))
-            fprintf(stderr, "inconsistency between theory and sat solver\n");
-        #endif
-        if(total_unsat_clauses == 0)
-            return satisfiable | c_l;
-        else return unsatisfied | c_l;
-    } else return c_l; // redundant
+    }
+
+    // all clauses are decided iff all variables are
+    if(total_unsat_variables == 0)
+        return satisfiable | c_l;
+    else return unsatisfied | c_l;
 }
 
 void sat::undo(){
-    if(!history.empty()){
-        vector<literal_t> &L = history.back();
-        if(W) delete W;
-
-        release_constraint(L[0]);
-        for(auto it = L.rbegin(); it != L.rend(); it++){
-            literal_t l = *it;
-
-            if(negated(l)){
-                // sat for negated l
-                std::vector<literal_t> &l_to_c = literal_to_clause[-1*l];
-                for(auto it = l_to_c.begin(); it != l_to_c.end(); it++){
-                    unsigned int c = *it;
-
-                    literal_t &sat_l = sat_literal_clause[c];
-                    if(sat_l == l){
-                        sat_l = 0;
-                        total_unsat_clauses++;
-                    }
-                }
-            } else {
-                // sat for l
-                std::vector<literal_t> &l_to_c = literal_to_clause[l];
-                for(auto it = l_to_c.begin(); it != l_to_c.end(); it++){
-                    unsigned int c = *it;
-
-                    literal_t &sat_l = sat_literal_clause[c];
-                    uint8_t &unsat_l = unsat_literals[c];
-                    #ifdef DEBUG
-                    if(!sat_l && !unsat_l)
-                        fprintf(stderr, "cannot have unsatisfied clause with no literals\n");
-                    #endif
-                    if (sat_l == l && unsat_l == 0){
-                        sat_l = 0;
-                        total_unsat_clauses++;
-                        unsat_l++;
-                    } else if(!sat_l)
-                        unsat_l++;
+    if(!trail_lim.empty()){
+        if(W){
+            bnc::destroy_weights(manager, W);
+            W = NULL;
+        }
 
-                }
-            }
+        const size_t kLimit = trail_lim.back();
+        trail_lim.pop_back();
+        while(trail.size() > kLimit+1){
+            set_value(abs(trail.back()), 0);
+            trail.pop_back();
+        }
+
+        const literal_t l = trail.back();
+        const variable_t v = literal_to_variable[abs(l)];
+        trail.pop_back();
+        set_value(abs(l), 0);
+        if(negated(l)){
+            literals_left[v]++;
+        } else {
+            sat_variable[v] = false;
+            total_unsat_variables++;
+            const std::vector<unsigned int> &kFamilies = variable_to_families[v];
+            for(auto it = kFamilies.begin(); it != kFamilies.end(); it++)
+                if(family_unsat_variables[*it]++ == 0 && tracking)
+                    open_family(*it);
         }
-        history.pop_back();
     }
 }
 
+/**
+ * Maintains the state that keys residual formulas from here on. The open
+ * clauses are those of families that still have an unassigned variable, and
+ * they are determined by the values of the variables in these families. The
+ * state holds two bits per literal, its value while one of the families of
+ * its variable is open and 3 otherwise, and is updated as literals are
+ * assigned and families close or open again. The state also determines the
+ * open families, as a family is open iff one of its variables has no positive
+ * literal, and all its variables are in the key while it is open.
+ */
+void sat::track_residual(){
+    tracking = true;
+
+    variable_open_families.assign(VARIABLES, 0);
+    for(unsigned int f = 0; f < families.size(); f++){
+        if(family_unsat_variables[f] == 0)
+            continue;
+        const std::vector<unsigned int> &kFamily = families[f];
+        for(auto it = kFamily.begin(); it != kFamily.end(); it++)
+            variable_open_families[*it]++;
+    }
+
+    residual_state.assign((2 * (size_t) (LITERALS+1) + 63) / 64, 0);
+    for(unsigned int v = 0; v < VARIABLES; v++){
+        const literal_t kBase = variable_to_literal[v];
+        for(unsigned int d = 0; d < dimension[v]; d++)
+            set_state(kBase+d, variable_open_families[v] > 0 ? literal_value[kBase+d] + 1 : 3);
+    }
+}
+
+/**
+ * Computes the key of the residual formula that remains to be solved from
+ * position level of the ordering onwards. Two states with equal keys yield
+ * identical sub-diagrams. Literals that are not part of the key belong to
+ * assigned variables of closed families, which only make the decisions on
+ * them redundant.
+ */
+void sat::residual(unsigned int level, residual_t &key) const {
+    key.clear();
+    key.reserve(residual_state.size() + 1);
+    key.push_back(level);
+    key.insert(key.end(), residual_state.begin(), residual_state.end());
+}
+
 template satisfy_t sat::condition<false>(literal_t);
 template satisfy_t sat::condition<true>(literal_t);
 
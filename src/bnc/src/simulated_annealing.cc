@@ -22,6 +22,8 @@
 #include <string.h>
 #include <stdio.h>
 #include <thread>
+#include <atomic>
+#include <pthread.h>
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_siman.h>
@@ -35,6 +37,7 @@
 #include <string>
 #include "composition.h"
 #include "spanning.h"
+#include "timer.h"
 #include <cstring>
 #include <cassert>
 
@@ -95,16 +98,20 @@ void sa_ordering_print(void *xp){
         printf(" - ");
 }
 
+/* pick the two positions to swap */
+inline void sa_ordering_pick(const gsl_rng * r, unsigned int &x1, unsigned int &x2){
+    x1 = gsl_rng_get (r) % SA_VARIABLES;
+    do {
+        x2 = gsl_rng_get (r) % SA_VARIABLES;
+    } while (x2 == x1);
+}
+
 /* take a step through the TSP space */
 void sa_ordering_step(const gsl_rng * r, void *xp, UNUSED double step_size){
     ordering_t::value_type *ordering = (ordering_t::value_type*) xp;
 
-    // /* pick the two variables to swap
     unsigned int x1,x2;
-    x1 = gsl_rng_get (r) % SA_VARIABLES;
-    do {
-        x2 = gsl_rng_get (r) % SA_VARIABLES;
-    } while (x2 == x1);
+    sa_ordering_pick(r, x1, x2);
 
     literal_t l = ordering[x1];
     ordering[x1] = ordering[x2];
@@ -118,6 +125,55 @@ struct anneal_xp {
     energy_function_t energy_f;
 };
 
+/* gsl_siman_solve copies the ordering for every step and evaluates it from
+ * scratch, while the chain score swaps positions in place and only evaluates
+ * the levels in between. Otherwise the schedule follows gsl_siman_solve. */
+void anneal_chain(const gsl_rng *r, anneal_xp *data, const gsl_siman_params_t &kParams, bool print){
+    IncrementalBound bound(sa_bound);
+    bound.Reset(&(data->ordering[0]));
+
+    double energy = bound.GetRatio();
+    double best_energy = energy;
+    std::vector<ordering_t::value_type> best_ordering(bound.GetOrdering());
+
+    if(print)
+        printf("#-iter  #-evals   temperature     position   energy     best_energy\n");
+
+    double temperature = kParams.t_initial;
+    unsigned int n_evals = 1;
+    for(unsigned int n_iter = 0; ; n_iter++){
+        for(int i = 0; i < kParams.iters_fixed_T; i++){
+            unsigned int x1,x2;
+            sa_ordering_pick(r, x1, x2);
+            bound.Propose(x1, x2);
+            const double kEnergy = bound.GetRatio();
+            ++n_evals;
+
+            if(kEnergy < energy || gsl_rng_uniform(r) < exp(-(kEnergy - energy)/(kParams.k * temperature))){
+                bound.Accept();
+                energy = kEnergy;
+                if(energy < best_energy){
+                    best_energy = energy;
+                    best_ordering = bound.GetOrdering();
+                }
+            } else
+                bound.Reject();
+        }
+
+        if(print){
+            printf("%5u %7u  %12g", n_iter, n_evals, temperature);
+            sa_ordering_print((void*) &(bound.GetOrdering()[0]));
+            printf("  %12g  %12g\n", energy, best_energy);
+        }
+
+        temperature /= kParams.mu_t;
+        if(temperature < kParams.t_min)
+            break;
+    }
+
+    std::copy(best_ordering.begin(), best_ordering.end(), data->ordering.begin());
+}
+
 void* anneal(void *xp){
     anneal_xp *data = (anneal_xp*) xp;
     ordering_t::value_type *basic_ordering = &(data->ordering[0]);
@@ -129,7 +185,9 @@ void* anneal(void *xp){
         bnc::OPT_SA_TEMPERATURE_DAMP_FACTOR, bnc::OPT_SA_TEMPERATURE_MIN};
 
     double score_original = (data->energy_f)((void*) basic_ordering);
-    if(data->thread_id == 0 && bnc::OPT_SA_PRINT_ORDERING){
+    if(data->energy_f == ::sa_ordering_energy<0>){
+        anneal_chain(r, data, params, data->thread_id == 0 && bnc::OPT_SA_PRINT_ORDERING);
+    } else if(data->thread_id == 0 && bnc::OPT_SA_PRINT_ORDERING){
         gsl_siman_solve(r, basic_ordering, data->energy_f, sa_ordering_step,
             NULL, sa_ordering_print, NULL, NULL, NULL,
             SA_VARIABLES*sizeof(ordering_t::value_type), params);
@@ -150,6 +208,233 @@ void* anneal(void *xp){
     return 0;
 }
 
+/************************************
+** parallel tempering
+************************************/
+
+/* replica that copies its state for every step, like gsl_siman_solve */
+class SimanReplica {
+    public:
+        SimanReplica(const void *kState, size_t size, gsl_siman_Efunc_t energy_f, gsl_siman_step_t step_f) :
+            energy_f_(energy_f), step_f_(step_f), x_((const char*) kState, (const char*) kState + size), new_x_(size) {
+            energy_ = energy_f_((void*) &(x_[0]));
+            new_energy_ = energy_;
+        }
+
+        inline double Energy() const { return energy_; }
+
+        inline double Propose(const gsl_rng *r){
+            std::copy(x_.begin(), x_.end(), new_x_.begin());
+            step_f_(r, (void*) &(new_x_[0]), STEP_SIZE);
+            new_energy_ = energy_f_((void*) &(new_x_[0]));
+            return new_energy_;
+        }
+
+        inline void Accept(){
+            x_.swap(new_x_);
+            energy_ = new_energy_;
+        }
+
+        inline void Reject(){}
+        inline const void* GetState() const { return &(x_[0]); }
+        inline size_t GetSize() const { return x_.size(); }
+
+    private:
+        gsl_siman_Efunc_t energy_f_;
+        gsl_siman_step_t step_f_;
+        std::vector<char> x_, new_x_;
+        double energy_, new_energy_;
+};
+
+/* replica that swaps positions in place and evaluates the chain score incrementally */
+class ChainReplica {
+    public:
+        ChainReplica(const ordering_t &kOrdering) : bound_(sa_bound) {
+            bound_.Reset(&(kOrdering[0]));
+            energy_ = new_energy_ = bound_.GetRatio();
+        }
+
+        inline double Energy() const { return energy_; }
+
+        inline double Propose(const gsl_rng *r){
+            unsigned int x1,x2;
+            sa_ordering_pick(r, x1, x2);
+            bound_.Propose(x1, x2);
+            new_energy_ = bound_.GetRatio();
+            return new_energy_;
+        }
+
+        inline void Accept(){
+            bound_.Accept();
+            energy_ = new_energy_;
+        }
+
+        inline void Reject(){ bound_.Reject(); }
+        inline const void* GetState() const { return &(bound_.GetOrdering()[0]); }
+        inline size_t GetSize() const { return SA_VARIABLES*sizeof(ordering_t::value_type); }
+
+    private:
+        IncrementalBound bound_;
+        double energy_, new_energy_;
+};
+
+template <class Replica>
+struct tempering_xp {
+    std::vector<Replica> *replicas;
+    std::vector<double> ladder;             // temperature per rung, hottest first
+    std::vector<unsigned int> rung;         // rung of each replica
+    std::vector<unsigned int> replica_at;   // replica at each rung
+    const gsl_rng_type *rng_type;
+    gsl_rng *exchange_rng;
+
+    pthread_mutex_t best_lock;
+    std::vector<char> best;
+    double best_energy;
+
+    pthread_barrier_t barrier;
+    Timer timer;
+    unsigned int rounds;
+    unsigned int exchanges;
+    bool stop;
+};
+
+template <class Replica>
+struct tempering_thread_xp {
+    tempering_xp<Replica> *shared;
+    unsigned int replica;
+};
+
+/* Swaps the replicas of adjacent rungs, alternating between even and odd
+ * pairs, and decides whether the time budget is exhausted. All threads stop
+ * after the same round. */
+template <class Replica>
+void exchange_replicas(tempering_xp<Replica> *shared){
+    const std::vector<Replica> &kReplicas = *(shared->replicas);
+    const unsigned int kNrRungs = shared->ladder.size();
+    for(unsigned int k = shared->rounds % 2; k+1 < kNrRungs; k += 2){
+        const unsigned int kHot = shared->replica_at[k];
+        const unsigned int kCold = shared->replica_at[k+1];
+        const double kDelta = (1/shared->ladder[k] - 1/shared->ladder[k+1]) / BOLTZMANN
+            * (kReplicas[kHot].Energy() - kReplicas[kCold].Energy());
+        if(kDelta >= 0 || gsl_rng_uniform(shared->exchange_rng) < exp(kDelta)){
+            shared->replica_at[k] = kCold;
+            shared->replica_at[k+1] = kHot;
+            shared->rung[kCold] = k;
+            shared->rung[kHot] = k+1;
+            ++shared->exchanges;
+        }
+    }
+
+    ++shared->rounds;
+    shared->timer.Stop();
+    shared->stop = shared->timer.template GetDuration<Timer::Seconds>() >= OPT_SA_TIME;
+}
+
+template <class Replica>
+void* temper(void *xp){
+    tempering_thread_xp<Replica> *data = (tempering_thread_xp<Replica>*) xp;
+    tempering_xp<Replica> *shared = data->shared;
+    Replica &replica = (*(shared->replicas))[data->replica];
+
+    gsl_rng *r = gsl_rng_alloc(shared->rng_type);
+    gsl_rng_set(r, gsl_rng_default_seed + data->replica + 1);
+
+    double best_energy = replica.Energy();
+    while(true){
+        const double kTemperature = shared->ladder[shared->rung[data->replica]];
+        for(int i = 0; i < bnc::OPT_SA_ITERATIONS; i++){
+            const double kEnergy = replica.Propose(r);
+            if(kEnergy < replica.Energy() || gsl_rng_uniform(r) < exp(-(kEnergy - replica.Energy())/(BOLTZMANN * kTemperature))){
+                replica.Accept();
+                if(kEnergy < best_energy){
+                    best_energy = kEnergy;
+                    pthread_mutex_lock(&(shared->best_lock));
+                    if(kEnergy < shared->best_energy){
+                        shared->best_energy = kEnergy;
+                        const char *kState = (const char*) replica.GetState();
+                        std::copy(kState, kState + replica.GetSize(), shared->best.begin());
+                    }
+                    pthread_mutex_unlock(&(shared->best_lock));
+                }
+            } else
+                replica.Reject();
+        }
+
+        if(pthread_barrier_wait(&(shared->barrier)) == PTHREAD_BARRIER_SERIAL_THREAD)
+            exchange_replicas(shared);
+        pthread_barrier_wait(&(shared->barrier));
+        if(shared->stop)
+            break;
+    }
+
+    gsl_rng_free(r);
+    return NULL;
+}
+
+/* Runs one replica per thread on a geometric temperature ladder between the
+ * initial and minimal temperature, exchanging temperatures after every
+ * OPT_SA_ITERATIONS steps until OPT_SA_TIME seconds have passed. The best
+ * state found by any replica is written to result. */
+template <class Replica>
+double parallel_tempering(std::vector<Replica> &replicas, void *result){
+    const unsigned int kNrReplicas = replicas.size();
+    assert(kNrReplicas > 0);
+
+    tempering_xp<Replica> shared;
+    shared.replicas = &replicas;
+    shared.ladder.resize(kNrReplicas);
+    shared.rung.resize(kNrReplicas);
+    shared.replica_at.resize(kNrReplicas);
+    for(unsigned int i = 0; i < kNrReplicas; i++){
+        const double kFraction = (kNrReplicas > 1 ? i / (double) (kNrReplicas-1) : 1);
+        shared.ladder[i] = OPT_SA_TEMPERATURE_INITIAL * std::pow(OPT_SA_TEMPERATURE_MIN / OPT_SA_TEMPERATURE_INITIAL, kFraction);
+        shared.rung[i] = i;
+        shared.replica_at[i] = i;
+    }
+
+    shared.rng_type = gsl_rng_env_setup();
+    shared.exchange_rng = gsl_rng_alloc(shared.rng_type);
+    gsl_ieee_env_setup ();
+
+    shared.best.assign((const char*) replicas[0].GetState(), (const char*) replicas[0].GetState() + replicas[0].GetSize());
+    shared.best_energy = replicas[0].Energy();
+    shared.rounds = 0;
+    shared.exchanges = 0;
+    shared.stop = false;
+    pthread_mutex_init(&(shared.best_lock), NULL);
+    pthread_barrier_init(&(shared.barrier), NULL, kNrReplicas);
+    shared.timer.Start();
+
+    // boot threads
+    pthread_t threads[kNrReplicas];
+    tempering_thread_xp<Replica> xp[kNrReplicas];
+    for(unsigned int i = 0; i < kNrReplicas; i++){
+        xp[i].shared = &shared;
+        xp[i].replica = i;
+        if(pthread_create(&(threads[i]), NULL, ::temper<Replica>, (void*)&(xp[i]))){
+            fprintf(stderr, "Error creating thread %u of %u\n", i+1, kNrReplicas);
+            exit(1);
+        }
+    }
+
+    // wait until finished
+    for(unsigned int i = 0; i < kNrReplicas; i++){
+        if(pthread_join(threads[i],NULL)){
+            fprintf(stderr, "Error canceling thread %u of %u\n", i+1, kNrReplicas);
+            exit(1);
+        }
+    }
+
+    std::copy(shared.best.begin(), shared.best.end(), (char*) result);
+    printf("Tempering score %lf after %u rounds (%u exchanges, %.1lfs)\n", shared.best_energy, shared.rounds, shared.exchanges, shared.timer.template GetDuration<Timer::Seconds>());
+
+    pthread_barrier_destroy(&(shared.barrier));
+    pthread_mutex_destroy(&(shared.best_lock));
+    gsl_rng_free(shared.exchange_rng);
+
+    return shared.best_energy;
+}
+
 int ordering_t::anneal(bayesnet *bn, const partition_t &kPartition, ordering_t &best_ordering, unsigned int score_function){
     // precondition:
     // 0 ordering contains partition and cutset variables
@@ -187,7 +472,7 @@ int ordering_t::anneal(bayesnet *bn, const partition_t &kPartition, ordering_t &
             exit(1);
     }
 
-    const unsigned int kNrThreads = std::thread::hardware_concurrency();
+    const unsigned int kNrThreads = (bnc::OPT_WORKERS > 0 ? bnc::OPT_WORKERS : std::thread::hardware_concurrency());
     assert(kNrThreads > 0);
 
     std::string filename = files.get_filename(VARIABLE_ORDERING,"intermediate");
@@ -197,7 +482,16 @@ int ordering_t::anneal(bayesnet *bn, const partition_t &kPartition, ordering_t &
     double best_energy = std::numeric_limits<double>::max();
     unsigned int stable_energy = 0;
     for(unsigned int run = 0; OPT_SA_RUNS == 0 || run < OPT_SA_RUNS; run++){
-        if(OPT_SA_PARALLELISM){
+        if(OPT_SA_PARALLELISM && OPT_SA_TEMPERING){
+            if(score_function == 0){
+                std::vector<ChainReplica> replicas(kNrThreads, ChainReplica(best_ordering));
+                parallel_tempering(replicas, (void*) &(best_ordering[0]));
+            } else {
+                std::vector<SimanReplica> replicas(kNrThreads, SimanReplica(&(best_ordering[0]),
+                    SA_VARIABLES*sizeof(ordering_t::value_type), energy_f, sa_ordering_step));
+                parallel_tempering(replicas, (void*) &(best_ordering[0]));
+            }
+        } else if(OPT_SA_PARALLELISM){
             // boot threads
             pthread_t threads[kNrThreads];
             for(unsigned int i = 0; i < kNrThreads; i++){
@@ -275,7 +569,7 @@ double sa_partition_energy(void *xp);
 void sa_partition_step(const gsl_rng * r, void *xp, double step_size);
 void sa_partition_print(void *xp);
 
-double sa_max_cutset_score;
+std::atomic<double> sa_max_cutset_score; // shared by tempering replicas
 
 /* energy for the travelling salesman problem */
 double sa_partition_score_balance(const unsigned int *kPartitionSize){
@@ -342,8 +636,9 @@ double sa_partition_cutset_score(const unsigned int *kPartitionMap, const unsign
         if(scores[p] > 1)
             score += scores[p];
 
-    if(score > sa_max_cutset_score)
-        sa_max_cutset_score = score;
+    // replicas race here, so only ever raise the maximum
+    double max_score = sa_max_cutset_score.load();
+    while(score > max_score && !sa_max_cutset_score.compare_exchange_weak(max_score, score));
 
     return score;
 }
@@ -462,7 +757,11 @@ void partitioner::generate_partitions_sa(bayesnet* bn, bn_partitions_t& result)
             deleted_edges[index] = true;
         }
 
-        if(gNrPartitions < gNrVariables){
+        if(gNrPartitions < gNrVariables && bnc::OPT_SA_PARALLELISM && bnc::OPT_SA_TEMPERING){
+            const unsigned int kNrThreads = (bnc::OPT_WORKERS > 0 ? bnc::OPT_WORKERS : std::thread::hardware_concurrency());
+            std::vector<SimanReplica> replicas(kNrThreads, SimanReplica(input, kTotalBytes, sa_partition_energy, sa_partition_step));
+            parallel_tempering(replicas, (void*) input);
+        } else if(gNrPartitions < gNrVariables){
             // perform simulated annealing
             gsl_rng * r = gsl_rng_alloc (gsl_rng_env_setup()) ;
             gsl_ieee_env_setup ();
@@ -26,6 +26,7 @@ class Architecture {
 
         bool IsPartitioned() const;
         void SetPartitionOrdering(const ordering_t &);
+        void SetCompositionOrdering(const ordering_t &);
         const ordering_t& GetOrdering() const;
         const ordering_t& GetPartitionOrdering() const;
         const Composition &GetComposition() const;
@@ -55,6 +56,7 @@ class Architecture {
         void DeterminePartitionOrdering(const bn_partitions_t&);
 
         Composition comp_;
+        ordering_t composition_ordering_;
 
         Independence independence_;
         Persistence persistence_;
@@ -1,5 +1,5 @@
-#ifndef LOCKFREEQUEUE_H
-#define LOCKFREEQUEUE_H
+#ifndef BNMC_LOCKFREEQUEUE_H
+#define BNMC_LOCKFREEQUEUE_H
 
 #include <array>
 #include <atomic>
@@ -1,5 +1,5 @@
-#ifndef MANAGER_H
-#define MANAGER_H
+#ifndef BNMC_MANAGER_H
+#define BNMC_MANAGER_H
 
 #include <bn-to-cnf/exceptions.h>
 #include <bn-to-cnf/cnf.h>
@@ -21,6 +21,7 @@ struct Manager {
         ~Manager();
 
         void Read(file_t);
+        void Load(bayesnet*, const literal_mapping_t&);
         filename_t files;
         std::string logfile;
 
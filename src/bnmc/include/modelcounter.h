@@ -12,6 +12,8 @@
 #include "cache.h"
 #include <bnc/timer.h>
 
+class compiler;
+
 namespace bnmc {
 
 class Interface;
@@ -22,6 +24,7 @@ class ModelCounter {
     public:
         ModelCounter();
         void Read();
+        void Load(compiler&);
 
         void Init(Evidence&);
 
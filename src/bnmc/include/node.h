@@ -1,5 +1,5 @@
-#ifndef NODE_H
-#define NODE_H
+#ifndef BNMC_NODE_H
+#define BNMC_NODE_H
 
 #include <bn-to-cnf/config.h>
 #include <vector>
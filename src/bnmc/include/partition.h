@@ -10,6 +10,11 @@
 #include "evidence.h"
 #include <bnc/dynamicarray.h>
 #include "multigraph.h"
+
+class compiler;
+struct weighted_node;
+namespace bnc { class MultiGraphProbability; }
+
 namespace bnmc {
 
 template <ModelType> class ModelCounter;
@@ -29,9 +34,12 @@ class Partition {
         typedef DynamicArray<LiteralNode> LiteralArithmeticCircuit;
 
         void Read(const ModelType,unsigned int partition_id = 0);
+        void Load(const ModelType, compiler&, unsigned int partition_id = 0);
         const size_t GetCircuitSize() const;
     private:
         void Read(const ModelType, std::string);
+        void Load(const ModelType, const weighted_node*);
+        void Load(const ModelType, const bnc::MultiGraphProbability&);
 
         ordering_t ordering_;
         ArithmeticCircuit ac_;
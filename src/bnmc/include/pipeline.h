@@ -0,0 +1,38 @@
+#ifndef BNMC_INCLUDE_PIPELINE_H_
+#define BNMC_INCLUDE_PIPELINE_H_
+
+#include <vector>
+#include <bn-to-cnf/bayesnet.h>
+#include <bnc/files.h>
+#include "modelcounter.h"
+#include "types.h"
+
+namespace bnmc {
+
+/**
+ * Compiles a Bayesian network in-process and loads the circuit into a model
+ * counter, as bnc followed by the 'load' commands of bnmc would, but without
+ * writing and parsing the mapping, partition and circuit files in between.
+ *
+ * Construction initializes the bnc options, which may be adjusted before
+ * compiling. The options that determine the circuit type are set according
+ * to the model type. Files are only written for the types passed to Persist,
+ * using the file names set in bnc::files.
+ */
+class Pipeline {
+    public:
+        Pipeline();
+
+        void Persist(file_t);
+
+        // takes ownership of the network, like Manager::Read(BN)
+        template <ModelType kModelType>
+        void Compile(bayesnet*, ModelCounter<kModelType>&);
+
+    private:
+        std::vector<file_t> persist_;
+};
+
+}
+
+#endif
@@ -103,6 +103,12 @@ void Architecture::SetPartitionOrdering(const ordering_t &kPartitionOrdering){
     comp_.BuildOrdering(kPartitionOrdering);
 }
 
+// composition ordering to use on Init when no composition ordering file is set,
+// an empty ordering lets Init determine one
+void Architecture::SetCompositionOrdering(const ordering_t &kCompositionOrdering){
+    composition_ordering_ = kCompositionOrdering;
+}
+
 std::vector<size_t> Architecture::GetTierWidths() const {
     const auto &kNodes = comp_.GetNodes();
 
@@ -150,6 +156,12 @@ void Architecture::DeterminePartitionOrdering(const bn_partitions_t &kPartitions
         if(ordering.size() != kPartitions.size())
             throw ArchitectureException("Composition ordering in file '%s' has %u elements but there are %u partitions",
                 filename.c_str(), ordering.size(), kPartitions.size());
+    } else if(!composition_ordering_.empty()){
+        ordering = composition_ordering_;
+
+        if(ordering.size() != kPartitions.size())
+            throw ArchitectureException("Composition ordering has %u elements but there are %u partitions",
+                ordering.size(), kPartitions.size());
     } else ordering = comp_.FindOrdering();
 
     SetPartitionOrdering(ordering);
@@ -8,6 +8,7 @@
 #include <unistd.h>
 #include <unordered_map>
 #include <bnc/timer.h>
+#include <bnc/dynamicarray.h>
 #include <algorithm>
 #include <bn-to-cnf/exceptions.h>
 #include <bnc/exceptions.h>
@@ -353,6 +354,9 @@ int Interface::Load(void*v){
         Print(ERR, "could not load %s\n", arguments_.c_str());
         return 1;
     }
+
+    if(subcommand != "net" && subcommand != "map" && DynamicArrayStorage::IsEnabled())
+        Print(MSG, "%s", DynamicArrayStorage::Report().c_str());
     return 0;
 }
 
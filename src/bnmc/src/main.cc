@@ -2,12 +2,16 @@
 #include "options.h"
 #include <stdio.h>
 #include <unistd.h>
+#include <string.h>
 #include "memory.h"
+#include <bnc/dynamicarray.h>
 
 using namespace bnmc;
 
 void help(){
-    fprintf(stderr, "Usage:\n   ./bnmc [-w <#workers>]\n\n");
+    fprintf(stderr, "Usage:\n   ./bnmc [-w <#workers>] [-H] [-n <local|interleave>]\n\n");
+    fprintf(stderr, "    -H : back large circuits by transparent huge pages\n");
+    fprintf(stderr, "    -n : NUMA placement of large circuits, on the node touching them first or interleaved\n");
 }
 
 void limit_memory(){
@@ -26,7 +30,7 @@ int main(int argc, char **argv){
 
     int c;
     bool clear_workers = true;
-    while ((c = getopt(argc, argv, "w:b:h")) != -1){
+    while ((c = getopt(argc, argv, "w:b:Hn:h")) != -1){
         switch (c){
             case'w':
                 if(clear_workers){
@@ -38,6 +42,19 @@ int main(int argc, char **argv){
             case'b':
                 manager.buffer = std::atoi(optarg);
                 break;
+            case'H':
+                DynamicArrayStorage::SetHugePages(true);
+                break;
+            case'n':
+                if(strcmp(optarg,"local") == 0)
+                    DynamicArrayStorage::SetPlacement(DynamicArrayStorage::kFirstTouch);
+                else if(strcmp(optarg,"interleave") == 0)
+                    DynamicArrayStorage::SetPlacement(DynamicArrayStorage::kInterleave);
+                else {
+                    help();
+                    return 1;
+                }
+                break;
             case 'h':
                 help();
                 return 1;
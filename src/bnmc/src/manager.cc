@@ -68,5 +68,16 @@ void Manager::Read(file_t type){
     }
 }
 
+// takes ownership of the network, like Read(BN) does, and copies the mapping
+// that was encoded in memory instead of reading it from the mapping file
+void Manager::Load(bayesnet *bn, const literal_mapping_t &kMapping){
+    if(this->bn && this->bn != bn)
+        delete(this->bn);
+
+    this->bn = bn;
+    mapping = kMapping;
+    have_bn = true;
+    have_mapping = true;
 }
 
+}
@@ -87,6 +87,14 @@ void ModelCounter<kModelType>::Read(){
     Prepare();
 }
 
+template <ModelType kModelType>
+void ModelCounter<kModelType>::Load(compiler &comp){
+    partition_.resize(1);
+    partition_[0].Load(kModelType, comp);
+
+    Prepare();
+}
+
 
 //template <ModelType kModelType>
 //void ModelCounter<kModelType>::ExcludeQueryVariable(){
@@ -7,6 +7,7 @@
 #include <bnc/bayesgraph.h>
 #include <bnc/exceptions.h>
 #include <climits>
+#include <bnc/compiler.h>
 #include "modelcounter.h"
 #include "io.h"
 #include "options.h"
@@ -83,6 +84,26 @@ void ModelCounter<ModelType::PWPBDD>::Read(){
     PrepareCache();
 }
 
+template <>
+void ModelCounter<ModelType::PWPBDD>::Load(compiler &comp){
+    bnc::manager_t &compiler_manager = comp.get_manager();
+
+    // copy partitions, their cutsets are already determined
+    const bn_partitions_t &kPartitions = compiler_manager.partitions;
+    bn_partitions_.resize(kPartitions.size());
+    for(unsigned int partition_id = 0; partition_id < kPartitions.size(); partition_id++)
+        bn_partitions_[partition_id].partition = kPartitions[partition_id].partition;
+
+    partition_.resize(bn_partitions_.size());
+    for(unsigned int partition_id = 0; partition_id < partition_.size(); partition_id++)
+        partition_[partition_id].Load(ModelType::PWPBDD,comp,partition_id);
+
+    // initialize
+    architecture_.SetCompositionOrdering(compiler_manager.composition_ordering);
+    Prepare();
+    PrepareCache();
+}
+
 template <>
 template <>
 probability_t ModelCounter<ModelType::PWPBDD>::TraverseArchitecture<N>(const Architecture &kArchitecture, Cache &cache, EvidenceList &evidence_list, const ConditionTierList &kConditionTierList, const unsigned int kTier);
@@ -5,9 +5,20 @@
 #include <set>
 #include <unordered_map>
 #include <bnc/multigraphpdef.h>
+#include <bnc/compiler.h>
+#include <stack>
 
 namespace bnmc {
 
+// symbolic weights 0 and 1 are constants, others index the mapping's probabilities
+static inline probability_t GetProbability(const unsigned int kSymbolicWeight, const unsigned int kLiterals, const std::vector<probability_t> &kWeightToProbability){
+    assert((kSymbolicWeight == 0 || kSymbolicWeight == 1) || (kSymbolicWeight >= kLiterals+1));
+    if(kSymbolicWeight == 0 || kSymbolicWeight == 1)
+        return (double) kSymbolicWeight;
+    else
+        return kWeightToProbability[kSymbolicWeight-(kLiterals+1)];
+}
+
 const size_t Partition::GetCircuitSize() const {
     if(ac_.GetSize())
         return ac_.GetSize();
@@ -42,11 +53,7 @@ void Partition::Read(const ModelType kModelType, std::string filename){
                     if(fscanf(file, " %u", &symbolic_w) != 1)
                         throw IoException("Error while reading weight %u of node %u", j, i);
 
-                    assert((symbolic_w == 0 || symbolic_w == 1) || (symbolic_w >= LITERALS+1));
-                    if(symbolic_w == 0 || symbolic_w == 1)
-                        w *= (double) symbolic_w;
-                    else
-                        w *= weight_to_probability[symbolic_w-(LITERALS+1)];
+                    w *= GetProbability(symbolic_w, LITERALS, weight_to_probability);
                 }
                 if(i == 0)
                     w = 0;
@@ -174,5 +181,147 @@ void Partition::Read(const ModelType kModelType, const unsigned int kPartitionId
     }
 }
 
+// Builds the circuit from a WPBDD in memory. Nodes are indexed in pre-order
+// like bnc::write_bdd does, hence the result equals reading its output.
+void Partition::Load(const ModelType kModelType, const weighted_node *kRoot){
+    if(!(kModelType == ModelType::PWPBDD || kModelType == ModelType::WPBDD))
+        throw IoException("Load option not supported by model type");
+
+    // build numeric index for each node, terminals are at 0 and 1
+    std::unordered_map<const weighted_node*, NodeIndex> index;
+    std::vector<const weighted_node*> nodes(2, NULL);
+    std::stack<const weighted_node*> s;
+    s.push(kRoot);
+    while(!s.empty()){
+        const weighted_node *n = s.top();
+        s.pop();
+
+        if(n && index.find(n) == index.end()){
+            if(weighted_node::is_terminal(n)){
+                const NodeIndex kIndex = (weighted_node::is_satisfiable(n)?1:0);
+                index[n] = kIndex;
+                nodes[kIndex] = n;
+            } else {
+                index[n] = nodes.size();
+                nodes.push_back(n);
+                s.push(n->e);
+                s.push(n->t);
+            }
+        }
+    }
+
+    const std::vector<probability_t>& weight_to_probability = manager.mapping.get_weight_to_probability();
+    const unsigned int LITERALS = manager.mapping.get_nr_literals();
+
+    if(!ac_.Resize(nodes.size()))
+        throw IoException("Could not allocate %lu nodes", nodes.size());
+
+    for(unsigned int i = 0; i < nodes.size(); i++){
+        LiteralNode n = TERMINAL_LITERAL_NODE;
+        probability_t w = 1;
+        if(i > 1){
+            const weighted_node *kNode = nodes[i];
+            n.l = kNode->l;
+            n.t = index[kNode->t];
+            n.e = index[kNode->e];
+            if(kNode->W)
+                for(auto it = kNode->W->begin(); it != kNode->W->end(); it++)
+                    w *= GetProbability(*it, LITERALS, weight_to_probability);
+        } else if(i == 0)
+            w = 0;
+
+        ac_[i] = n;
+        ac_[i].w = w;
+        if(i == 0 || i == 1)
+            ac_[i].v = manager.mapping.get_nr_variables();
+    }
 }
 
+// Builds the circuit from a multigraph in memory, indexing its nodes in the
+// pre-order of MultiGraphProbability::DumpDD
+void Partition::Load(const ModelType kModelType, const bnc::MultiGraphProbability &kGraph){
+    if(!(kModelType == ModelType::MULTIGRAPH || kModelType == ModelType::TDMULTIGRAPH))
+        throw IoException("Load option not supported by model type");
+
+    if(kModelType == ModelType::MULTIGRAPH && kGraph.GetSpanningTree().IsTree())
+        throw IoException("Multigraph cannot be tree driven");
+
+    typedef bnc::MultiGraphProbability::Node BncNode;
+    const BncNode *kTerminal = kGraph.GetTerminal();
+
+    // build numeric index, the terminal is at 0
+    std::unordered_map<const BncNode*, size_t> index;
+    std::vector<const BncNode*> nodes(1, kTerminal);
+    index[kTerminal] = 0;
+    size_t nr_of_edges = 0;
+
+    std::stack<const BncNode*> s;
+    s.push(kGraph.GetRoot());
+    while(!s.empty()){
+        const BncNode *kNode = s.top();
+        s.pop();
+
+        if(index.find(kNode) == index.end()){
+            for(auto edge = kNode->rEdgeBegin(); edge != kNode->rEdgeEnd(); edge--)
+                s.push(edge->to);
+
+            index[kNode] = nodes.size();
+            nodes.push_back(kNode);
+            nr_of_edges += kNode->size;
+        }
+    }
+
+    auto &mg = (kModelType == ModelType::TDMULTIGRAPH? tdmgc_:mgc_);
+
+    const size_t kNrTerminals = 1;
+    if(!mg.Resize(nodes.size(),nr_of_edges))
+        throw IoException("Failed to allocate %lu nodes and %lu edges", nodes.size()-kNrTerminals, nr_of_edges);
+
+    mg.SetNrTerminals(kNrTerminals);
+    mg.SetRootIndex(kNrTerminals);
+    auto* terminal = mg.CreateNode(0);
+    terminal->variable = 0;
+    mg.StoreNode(0);
+
+    for(size_t i = kNrTerminals; i < nodes.size(); i++){
+        const BncNode *kNode = nodes[i];
+
+        MultiGraph::Node *node = mg.CreateNode(kNode->size);
+        node->variable = kNode->variable;
+        mg.StoreNode(kNode->size);
+
+        const bool kIsAnd = node->IsAnd();
+        for(unsigned int j = 0; j < kNode->size; j++){
+            node->edges[j].to = mg.GetNode(index[kNode->edges[j].to]);
+            node->edges[j].probability = (kIsAnd?1:kNode->edges[j].probability);
+        }
+    }
+}
+
+void Partition::Load(const ModelType kModelType, compiler &comp, const unsigned int kPartitionId){
+    switch(kModelType){
+        case ModelType::WPBDD:
+        case ModelType::PWPBDD:
+            {
+                std::vector<bnc::node*> &wpbdds = comp.get_wpbdds();
+                if(kPartitionId >= wpbdds.size())
+                    throw IoException("Compiler holds no WPBDD for partition %u", kPartitionId);
+                Load(kModelType, wpbdds[kPartitionId]);
+            }
+            break;
+        case ModelType::MULTIGRAPH:
+        case ModelType::TDMULTIGRAPH:
+            {
+                std::vector<bnc::MultiGraphProbability> &graphs = comp.get_pmultigraphs();
+                if(kPartitionId >= graphs.size())
+                    throw IoException("Compiler holds no multigraph for partition %u", kPartitionId);
+                Load(kModelType, graphs[kPartitionId]);
+            }
+            break;
+        default:
+            throw IoException("Load option not supported for this model type");
+            break;
+    }
+}
+
+}
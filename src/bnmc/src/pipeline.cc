@@ -0,0 +1,58 @@
+#include "pipeline.h"
+#include "options.h"
+#include "exceptions.h"
+#include <bnc/compiler.h>
+#include <bnc/options.h>
+
+namespace bnmc {
+
+Pipeline::Pipeline(){
+    bnc::init_options();
+}
+
+void Pipeline::Persist(file_t type){
+    persist_.push_back(type);
+}
+
+template <ModelType kModelType>
+void Pipeline::Compile(bayesnet *bn, ModelCounter<kModelType> &counter){
+    switch(kModelType){
+        case ModelType::WPBDD:
+        case ModelType::PWPBDD:
+            // circuits are traversed uncollapsed, as pg compiles them
+            bnc::OPT_BDD_TYPE = bdd_t::wpbdd;
+            bnc::OPT_COLLAPSE = false;
+            bnc::OPT_PARTITION = (kModelType == ModelType::PWPBDD);
+            break;
+        case ModelType::MULTIGRAPH:
+        case ModelType::TDMULTIGRAPH:
+            // circuits are read with probabilities on the edges
+            bnc::OPT_BDD_TYPE = (kModelType == ModelType::MULTIGRAPH? bdd_t::multigraph : bdd_t::tdmultigraph);
+            bnc::OPT_USE_PROBABILITY = true;
+            bnc::OPT_PARTITION = false;
+            break;
+        default:
+            throw IoException("Compile option not supported for this model type");
+    }
+
+    compiler comp;
+    comp.set_compilation_type(bnc::OPT_COMPILATION_TYPE);
+    comp.set_bdd_type(bnc::OPT_BDD_TYPE);
+    comp.encode(bn);
+    comp.load();
+    comp.compile();
+
+    // circuits refer to the mapping the compiler encoded
+    manager.Load(bn, comp.get_manager().get_bayesgraph());
+    counter.Load(comp);
+
+    for(auto it = persist_.begin(); it != persist_.end(); it++)
+        comp.write(*it);
+}
+
+template void Pipeline::Compile(bayesnet*, ModelCounter<ModelType::WPBDD>&);
+template void Pipeline::Compile(bayesnet*, ModelCounter<ModelType::PWPBDD>&);
+template void Pipeline::Compile(bayesnet*, ModelCounter<ModelType::MULTIGRAPH>&);
+template void Pipeline::Compile(bayesnet*, ModelCounter<ModelType::TDMULTIGRAPH>&);
+
+}
@@ -0,0 +1,85 @@
+/*
+ * EliminationGraph.h
+ *
+ *  This file is part of DAOOPT.
+ *
+ *  DAOOPT is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  DAOOPT is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DAOOPT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ELIMINATIONGRAPH_H_
+#define ELIMINATIONGRAPH_H_
+
+#include "_base.h"
+#include "Graph.h"
+
+#include <boost/atomic.hpp>
+
+namespace daoopt {
+
+/*
+ * Graph used for computing randomized minfill orderings. Adjacency is
+ * stored as one bitset per node, so that a copy is a flat array copy and
+ * common neighborhoods are computed a word at a time. For every node the
+ * number of edges among its neighbors is maintained incrementally while
+ * eliminating, which yields its minfill score without rescanning its
+ * neighborhood.
+ */
+class EliminationGraph {
+protected:
+  int m_n;                      // No. of nodes
+  int m_words;                  // No. of 64 bit words per adjacency row
+  int m_remaining;              // No. of nodes not yet eliminated
+  vector<uint64_t> m_adj;       // Adjacency rows, m_words per node
+  vector<int> m_degree;         // Current no. of neighbors
+  vector<int> m_triangles;      // Current no. of edges among the neighbors
+  vector<bool> m_eliminated;    // Nodes eliminated so far
+
+public:
+  EliminationGraph(Graph& g);
+
+public:
+  /* minfill score, i.e. no. of edges added when eliminating node i */
+  nCost scoreMinfill(int i) const;
+
+  /* Computes a randomized minfill ordering, breaking ties (within the
+   * tolerance) with the given generator. Returns the induced width, or
+   * INT_MAX as soon as the width exceeds the limit. The limit is read
+   * in every step, so it may be lowered concurrently. The graph is
+   * consumed, eliminate a copy to reuse it. */
+  int eliminate(vector<int>& elim, const boost::atomic<int>& limit,
+                int tolerance, boost::minstd_rand& rng);
+
+protected:
+  bool hasEdge(int i, int j) const;
+  void addEdge(int i, int j);
+  void removeNode(int i);
+  int commonNeighbors(int i, int j) const;
+};
+
+/****************************
+ *  Inline implementations  *
+ ****************************/
+
+inline nCost EliminationGraph::scoreMinfill(int i) const {
+  const nCost d = m_degree[i];
+  return d*(d-1)/2 - m_triangles[i];
+}
+
+inline bool EliminationGraph::hasEdge(int i, int j) const {
+  return (m_adj[i*m_words + (j>>6)] >> (j&63)) & 1;
+}
+
+}  // namespace daoopt
+
+#endif /* ELIMINATIONGRAPH_H_ */
@@ -87,6 +87,11 @@ protected:
 
   static Heuristic* newHeuristic(Problem*, Pseudotree*, ProgramOptions*);
 
+  /* runs the randomized minfill iterations concurrently, improving on the
+   * given ordering of width w; returns the width of the best ordering */
+  int findOrderingConcurrent(Graph& g, vector<int>& elim, int w,
+                             int& iterCount, time_t start);
+
 public:
   bool start() const;
   bool parseOptions(int argc, char** argv);
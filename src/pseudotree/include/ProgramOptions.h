@@ -58,6 +58,7 @@ public:
   int order_iterations; // no. of randomized order finding iterations
   int order_timelimit; // no. of seconds to look for variable ordering
   int order_tolerance; // allowed range of deviation from suggested optimal minfill heuristic
+  int order_threads; // no. of concurrent ordering iterations (0: all cores)
   int cutoff_depth; // fixed cutoff depth for central search
   int cutoff_width; // fixed width for central cutoff
   int nodes_init; // number of nodes for local initialization (times 10^6)
@@ -106,7 +107,7 @@ inline ProgramOptions::ProgramOptions() :
 		      par_solveLocal(false), par_preOnly(false), par_postOnly(false), rotate(false),
 		      order_cvo(false), match(-1), mplp(-1), mplps(-1), jglp(-1), jglps(-1),
 		      ibound(0), cbound(0), cbound_worker(0),
-		      threads(0), order_iterations(0), order_timelimit(0), order_tolerance(0),
+		      threads(0), order_iterations(0), order_timelimit(0), order_tolerance(0), order_threads(0),
 		      cutoff_depth(NONE), cutoff_width(NONE),
 		      nodes_init(NONE), memlimit(NONE),
 		      cutoff_size(NONE), local_size(NONE), maxSubprob(NONE),
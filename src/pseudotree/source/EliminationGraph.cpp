@@ -0,0 +1,220 @@
+/*
+ * EliminationGraph.cpp
+ *
+ *  This file is part of DAOOPT.
+ *
+ *  DAOOPT is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  DAOOPT is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with DAOOPT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "EliminationGraph.h"
+
+namespace daoopt {
+
+/* uniformly random integer in [0,hi), in the style of rand::next(hi) */
+static inline size_t randomIndex(boost::minstd_rand& rng, size_t hi) {
+  return static_cast<size_t>( rng() / (rng.max()+1.0) * hi );
+}
+
+
+EliminationGraph::EliminationGraph(Graph& g) {
+  m_n = g.getStatNodes();
+  m_words = (m_n + 63) / 64;
+  m_remaining = m_n;
+  m_adj.resize((size_t) m_n * m_words, 0);
+  m_degree.resize(m_n, 0);
+  m_triangles.resize(m_n, 0);
+  m_eliminated.resize(m_n, false);
+
+  const set<int> nodes = g.getNodes();
+  for (set<int>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+    assert(*it < m_n);
+    const set<int>& N = g.getNeighbors(*it);
+    for (set<int>::const_iterator itN = N.begin(); itN != N.end(); ++itN)
+      m_adj[(*it)*m_words + ((*itN)>>6)] |= uint64_t(1) << ((*itN)&63);
+    m_degree[*it] = N.size();
+  }
+
+  // every edge among the neighbors of i closes a triangle with i, and is
+  // seen once from either endpoint
+  for (int i=0; i<m_n; ++i) {
+    int twice = 0;
+    const uint64_t* row = &m_adj[i*m_words];
+    for (int w=0; w<m_words; ++w) {
+      for (uint64_t bits = row[w]; bits; bits &= bits-1) {
+        int j = (w<<6) + __builtin_ctzll(bits);
+        twice += commonNeighbors(i,j);
+      }
+    }
+    m_triangles[i] = twice/2;
+  }
+}
+
+
+/* no. of nodes adjacent to both i and j */
+int EliminationGraph::commonNeighbors(int i, int j) const {
+  const uint64_t* a = &m_adj[i*m_words];
+  const uint64_t* b = &m_adj[j*m_words];
+  int count = 0;
+  for (int w=0; w<m_words; ++w)
+    count += __builtin_popcountll(a[w] & b[w]);
+  return count;
+}
+
+
+/* Adds the fill edge (i,j). Every common neighbor c of i and j gains an edge
+ * among its neighbors, while i and j each gain one per common neighbor. */
+void EliminationGraph::addEdge(int i, int j) {
+  uint64_t* a = &m_adj[i*m_words];
+  uint64_t* b = &m_adj[j*m_words];
+  int common = 0;
+  for (int w=0; w<m_words; ++w) {
+    for (uint64_t bits = a[w] & b[w]; bits; bits &= bits-1) {
+      ++m_triangles[(w<<6) + __builtin_ctzll(bits)];
+      ++common;
+    }
+  }
+  m_triangles[i] += common;
+  m_triangles[j] += common;
+
+  a[j>>6] |= uint64_t(1) << (j&63);
+  b[i>>6] |= uint64_t(1) << (i&63);
+  ++m_degree[i];
+  ++m_degree[j];
+}
+
+
+/* Removes node i, whose neighbors must form a clique: each neighbor loses
+ * its edges to the other neighbors of i from its own neighborhood. */
+void EliminationGraph::removeNode(int i) {
+  uint64_t* row = &m_adj[i*m_words];
+  const int lost = m_degree[i] - 1;
+  for (int w=0; w<m_words; ++w) {
+    for (uint64_t bits = row[w]; bits; bits &= bits-1) {
+      int j = (w<<6) + __builtin_ctzll(bits);
+      m_adj[j*m_words + (i>>6)] &= ~(uint64_t(1) << (i&63));
+      --m_degree[j];
+      m_triangles[j] -= lost;
+    }
+    row[w] = 0;
+  }
+  m_degree[i] = 0;
+  m_triangles[i] = 0;
+  m_eliminated[i] = true;
+  --m_remaining;
+}
+
+
+int EliminationGraph::eliminate(vector<int>& elim, const boost::atomic<int>& limit,
+                                int tolerance, boost::minstd_rand& rng) {
+  int width = UNKNOWN;
+  elim.clear();
+  elim.reserve(m_n);
+
+  // keeps track of minimal score nodes
+  vector<vector<int> > candidates(tolerance+1);
+  vector<nCost> candScore(tolerance+1);
+  vector<int> simplicial; // simplicial nodes (score 0)
+  vector<int> neighbors;
+
+  // eliminate nodes until all gone
+  while (m_remaining != 0) {
+
+    for (int i=0; i<=tolerance; ++i) {
+      candidates[i].clear();
+      candScore[i] = numeric_limits<nCost>::max();
+    }
+    simplicial.clear();
+
+    // find node to eliminate
+    for (int i=0; i<m_n; ++i) {
+      if (m_eliminated[i])
+        continue;
+      nCost score = scoreMinfill(i);
+      if (score == 0) {
+        simplicial.push_back(i);
+        continue;
+      }
+      for (int j=0; j<=tolerance; ++j) {
+        if (score == candScore[j]) {
+          candidates[j].push_back(i);
+          break;
+        } else if (score < candScore[j]) {  // move back candidate lists
+          for (int k=tolerance; k>j; --k) {
+            candidates[k].swap(candidates[k-1]);
+            candScore[k] = candScore[k-1];
+          }
+          candidates[j].clear();
+          candidates[j].push_back(i);
+          candScore[j] = score;
+          break;
+        }
+      }
+    }
+
+    // eliminate all nodes with score=0 -> no edges will have to be added,
+    // and the remaining ones stay simplicial
+    for (vector<int>::iterator it=simplicial.begin(); it!=simplicial.end(); ++it) {
+      elim.push_back(*it);
+      width = max(width, m_degree[*it]);
+      removeNode(*it);
+    }
+
+    // early termination condition: width above given limit
+    if (width > limit.load(boost::memory_order_relaxed))
+      return INT_MAX;
+
+    // anything left to eliminate? If not, we are done!
+    if (candScore[0] == numeric_limits<nCost>::max())
+      return width;
+
+    // Pick one of the minimal score nodes (with score >= 1),
+    // breaking ties randomly
+    size_t candTotal = 0;
+    for (int i=0; i<=tolerance && candScore[i] != numeric_limits<nCost>::max(); ++i)
+      candTotal += candidates[i].size();
+    size_t choice = randomIndex(rng, candTotal);
+    int nextNode = NONE;
+    for (int i=0; i<=tolerance; ++i) {
+      if (choice < candidates[i].size()) {
+        nextNode = candidates[i][choice];
+        break;
+      } else
+        choice -= candidates[i].size();
+    }
+    elim.push_back(nextNode);
+
+    // update width of implied tree decomposition
+    width = max(width, m_degree[nextNode]);
+    if (width > limit.load(boost::memory_order_relaxed))
+      return INT_MAX;
+
+    // connect neighbors in primal graph
+    neighbors.clear();
+    const uint64_t* row = &m_adj[nextNode*m_words];
+    for (int w=0; w<m_words; ++w)
+      for (uint64_t bits = row[w]; bits; bits &= bits-1)
+        neighbors.push_back((w<<6) + __builtin_ctzll(bits));
+    for (vector<int>::iterator it = neighbors.begin(); it != neighbors.end(); ++it)
+      for (vector<int>::iterator it2 = it+1; it2 != neighbors.end(); ++it2)
+        if (!hasEdge(*it,*it2))
+          addEdge(*it,*it2);
+
+    // remove node from primal graph, scores of affected nodes follow
+    removeNode(nextNode);
+  }
+
+  return width;
+}
+
+}  // namespace daoopt
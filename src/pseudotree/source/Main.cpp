@@ -27,6 +27,10 @@
 string daoopt::UAI2012::filename = "";
 
 #include "cvo/ARPall.hxx"
+#include "EliminationGraph.h"
+
+#include "boost/bind.hpp"
+#include "boost/thread.hpp"
 
 #define VERSIONINFO "1.1.2-UAI14"
 
@@ -107,6 +111,112 @@ bool Main::loadProblem() {
 }
 
 
+/* State shared by the concurrent minfill iterations */
+struct OrderingSearch {
+  EliminationGraph* master;       // elimination graph copied by each iteration
+  Graph* g;                       // primal graph for building pseudo trees
+  Problem* problem;
+  ProgramOptions* options;
+  Pseudotree* pseudotree;         // pseudo tree of the incumbent ordering
+  vector<int>* elim;              // incumbent ordering
+  boost::atomic<int> width;       // incumbent width, prunes running iterations
+  boost::mutex mtx;               // guards everything below and the incumbent
+  int remaining, iterCount, sinceLast;
+  time_t start;
+};
+
+/* Runs minfill iterations until the iteration or time limit is reached. An
+ * iteration is abandoned as soon as its width exceeds the incumbent's. */
+static void orderingThread(OrderingSearch* search, int seed) {
+  ProgramOptions* opt = search->options;
+  boost::minstd_rand rng(seed);
+  vector<int> elimCand;  // new ordering candidate
+
+  while (true) {
+    {
+      boost::mutex::scoped_lock lk(search->mtx);
+      if (opt->order_iterations != NONE && search->remaining <= 0)
+        break;
+      if (opt->order_timelimit != NONE
+          && difftime(time(NULL), search->start) > opt->order_timelimit)
+        break;
+      --search->remaining;
+    }
+
+    EliminationGraph G(*search->master);
+    int new_w = G.eliminate(elimCand, search->width, opt->order_tolerance, rng);
+
+    boost::mutex::scoped_lock lk(search->mtx);
+    bool improved = false;  // improved in this iteration?
+    int w = search->width;
+    if (new_w < w) {
+      *search->elim = elimCand; improved = true;
+      search->pseudotree->build(*search->g, elimCand, opt->cbound);
+      search->width = new_w;
+      cout << " " << search->iterCount << ':' << new_w << '/' << search->pseudotree->getHeight() << flush;
+    } else if (new_w == w) {
+      Pseudotree ptCand(search->problem, opt->subprobOrder);
+      ptCand.build(*search->g, elimCand, opt->cbound);
+      if (ptCand.getHeight() < search->pseudotree->getHeight()) {
+        *search->elim = elimCand; improved = true;
+        search->pseudotree->build(*search->g, elimCand, opt->cbound);
+        cout << " " << search->iterCount << ':' << w << '/' << search->pseudotree->getHeight() << flush;
+      }
+    }
+    ++search->iterCount, ++search->sinceLast;
+
+    // Adaptive ordering scheme
+    if (improved && opt->autoIter && search->remaining > 0) {
+      search->remaining = max(search->remaining, search->sinceLast+1);
+      search->sinceLast = 0;
+    }
+  }
+}
+
+int Main::findOrderingConcurrent(Graph& g, vector<int>& elim, int w,
+                                 int& iterCount, time_t start) {
+  EliminationGraph master(g);
+
+  OrderingSearch search;
+  search.master = &master;
+  search.g = &g;
+  search.problem = m_problem.get();
+  search.options = m_options.get();
+  search.pseudotree = m_pseudotree.get();
+  search.elim = &elim;
+  search.width = w;
+  search.remaining = m_options->order_iterations;
+  search.iterCount = 0;
+  search.sinceLast = 0;
+  search.start = start;
+
+  int threads = m_options->order_threads;
+  if (threads <= 0)
+    threads = max(1u, boost::thread::hardware_concurrency());
+  if (m_options->order_iterations != NONE)
+    threads = min(threads, max(1, m_options->order_iterations));
+#ifdef NOTHREADS
+  threads = 1;
+#endif
+
+  // seeds are drawn up front to keep runs reproducible for a given seed
+  vector<int> seeds(threads);
+  for (int i=0; i<threads; ++i)
+    seeds[i] = rand::next();
+
+  if (threads == 1) {
+    orderingThread(&search, seeds[0]);
+  } else {
+    boost::thread_group workers;
+    for (int i=0; i<threads; ++i)
+      workers.create_thread(boost::bind(&orderingThread, &search, seeds[i]));
+    workers.join_all();
+  }
+
+  iterCount = search.iterCount;
+  return search.width;
+}
+
 bool Main::findOrLoadOrdering() {
   // Create primal graph of *reduced* problem
   Graph g(m_problem->getN());
@@ -192,27 +302,24 @@ bool Main::findOrLoadOrdering() {
   int iterCount=0, sinceLast=0;
   int remaining = m_options->order_iterations;
 
-  while (true) {
+  if (!m_options->order_cvo)
+    w = findOrderingConcurrent(g, elim, w, iterCount, time_order_start);
+  else while (true) {
 
     if (m_options->order_iterations != NONE && remaining == 0)
       break;
 
     vector<int> elimCand;  // new ordering candidate
     bool improved = false;  // improved in this iteration?
-    int new_w;
-    if (m_options->order_cvo) {
-      *cvoGraph = *cvoMasterGraph;
-      new_w = cvoGraph->ComputeVariableEliminationOrder_Simple_wMinFillOnly(
-          w, true, false, 10, -1, 0.0, *cvoAvlVars2CheckScore, *cvoTempAdjVarSpace);
-      if (new_w != 0)
-        new_w = INT_MAX;
-      else {
-        new_w = cvoGraph->_VarElimOrderWidth;
-        elimCand.assign(cvoGraph->_VarElimOrder,
-                        cvoGraph->_VarElimOrder + cvoGraph->_nNodes);
-      }
-    } else {
-      new_w = m_pseudotree->eliminate(g,elimCand,w);
+    *cvoGraph = *cvoMasterGraph;
+    int new_w = cvoGraph->ComputeVariableEliminationOrder_Simple_wMinFillOnly(
+        w, true, false, 10, -1, 0.0, *cvoAvlVars2CheckScore, *cvoTempAdjVarSpace);
+    if (new_w != 0)
+      new_w = INT_MAX;
+    else {
+      new_w = cvoGraph->_VarElimOrderWidth;
+      elimCand.assign(cvoGraph->_VarElimOrder,
+                      cvoGraph->_VarElimOrder + cvoGraph->_nNodes);
     }
     if (new_w < w) {
       elim = elimCand; w = new_w; improved = true;
@@ -0,0 +1,75 @@
+#ifndef ESPRESSO_H
+#define ESPRESSO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <map>
+#include <vector>
+
+/**
+ * Heuristic two-level minimizer in the style of Espresso. Instead of
+ * enumerating minterms and primes like qm, it iterates expand, irredundant
+ * and reduce on a cover of cubes until the cover no longer shrinks. The
+ * result is a near minimal sum-of-products that contains the on-set and is
+ * contained in the on-set and the don't care set.
+ *
+ * Cubes have no fixed width: each cube is stored as two bitsets, the
+ * variables that may be 0 and those that may be 1, so that containment,
+ * intersection and cofactors are computed a word at a time. Containment in
+ * a cover is decided by a tautology check on its cofactor (unate recursive
+ * paradigm), hence no off-set is computed.
+ */
+class espresso {
+    public:
+        espresso();
+
+        // variables are named by the literals the caller uses for them
+        void add_variable(uint32_t, int index = -1);
+        // cube as signed variables, a positive variable is true in the cube
+        void add_model(const std::vector<int32_t>&);
+        void add_dont_care(const std::vector<int32_t>&);
+        void clear();
+        int solve();
+
+        unsigned int get_primes_size();
+        void get_clause(std::vector<int32_t>&, unsigned int);
+        void print();
+
+    private:
+        typedef uint64_t word_t;
+        typedef std::vector<word_t> cubes_t; // cubes of 2*words words each
+        struct index_t {
+            size_t words;                // words per row
+            std::vector<word_t> rows;    // 2 rows of cube bits per variable
+        };
+
+        void add(cubes_t&, const std::vector<int32_t>&);
+        inline word_t* get(cubes_t &c, size_t i) const { return &c[i*2*words]; };
+        inline const word_t* get(const cubes_t &c, size_t i) const { return &c[i*2*words]; };
+        inline size_t count(const cubes_t &c) const { return (words?c.size()/(2*words):0); };
+
+        bool contains(const word_t*, const word_t*) const;
+        bool universal(const word_t*) const;
+        unsigned int literals(const word_t*) const;
+        void build_index(const cubes_t&, index_t&) const;
+        void update_index(index_t&, size_t, const word_t*) const;
+        bool covered(const word_t*, const cubes_t&, const index_t&, const std::vector<char>&) const;
+        bool tautology(cubes_t&) const;
+        void cofactor(const cubes_t&, const index_t&, const word_t*, cubes_t&, const std::vector<char>*) const;
+
+        void single_cube_containment(cubes_t&) const;
+        void expand(cubes_t&);
+        void irredundant(cubes_t&);
+        void reduce(cubes_t&);
+        bool cheaper(const cubes_t&, const cubes_t&) const;
+
+        size_t words;
+        std::vector<uint32_t> variables;
+        std::map<uint32_t, unsigned int> variable_to_index;
+        std::vector< std::vector<int32_t> > on, dc;
+        cubes_t F, D;
+        index_t index_D;
+        std::vector<word_t> mask;
+};
+
+#endif
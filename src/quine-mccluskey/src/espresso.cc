@@ -0,0 +1,525 @@
+#include "espresso.h"
+#include <algorithm>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+using namespace std;
+
+static inline unsigned int popcount(uint64_t x){
+    return __builtin_popcountll(x);
+}
+
+static inline unsigned int ctz(uint64_t x){
+    return __builtin_ctzll(x);
+}
+
+espresso::espresso(){
+    clear();
+}
+
+void espresso::clear(){
+    words = 0;
+    variables.clear();
+    variable_to_index.clear();
+    on.clear();
+    dc.clear();
+    F.clear();
+    D.clear();
+    mask.clear();
+}
+
+void espresso::add_variable(uint32_t v, int index){
+    if(index == -1)
+        index = variables.size();
+    if(variables.size() <= (unsigned int) index)
+        variables.resize(index+1);
+    variables[index] = v;
+    variable_to_index[v] = index;
+}
+
+void espresso::add_model(const vector<int32_t> &literals){
+    on.push_back(literals);
+}
+
+void espresso::add_dont_care(const vector<int32_t> &literals){
+    dc.push_back(literals);
+}
+
+// appends a cube, a variable that may be 0 has its bit set in the first
+// half, a variable that may be 1 in the second half
+void espresso::add(cubes_t &cubes, const vector<int32_t> &literals){
+    size_t offset = cubes.size();
+    cubes.resize(offset+2*words);
+    word_t *c = &cubes[offset];
+    for(size_t w = 0; w < words; w++)
+        c[w] = c[words+w] = mask[w];
+
+    for(unsigned int i = 0; i < literals.size(); i++){
+        auto it = variable_to_index.find(abs(literals[i]));
+        if(it == variable_to_index.end()){
+            fprintf(stderr, "espresso: unknown variable %d\n", abs(literals[i]));
+            exit(1);
+        }
+        const word_t bit = (word_t) 1 << (it->second & 63);
+        if(literals[i] > 0)
+            c[it->second >> 6] &= ~bit;
+        else
+            c[words + (it->second >> 6)] &= ~bit;
+    }
+
+    // drop contradicting cubes
+    for(size_t w = 0; w < words; w++){
+        if((c[w] | c[words+w]) != mask[w]){
+            cubes.resize(offset);
+            break;
+        }
+    }
+}
+
+// a contains b
+bool espresso::contains(const word_t *a, const word_t *b) const {
+    for(size_t w = 0; w < 2*words; w++)
+        if(b[w] & ~a[w])
+            return false;
+    return true;
+}
+
+bool espresso::universal(const word_t *a) const {
+    for(size_t w = 0; w < words; w++)
+        if((a[w] & a[words+w]) != mask[w])
+            return false;
+    return true;
+}
+
+unsigned int espresso::literals(const word_t *a) const {
+    unsigned int n = 0;
+    for(size_t w = 0; w < words; w++)
+        n += popcount(a[w] ^ a[words+w]);
+    return n;
+}
+
+// transposes G: row 2*v+b is the set of cubes in which variable v may take
+// the value b, so that the cubes intersecting a given cube are found by and-ing
+// the rows of its literals
+void espresso::build_index(const cubes_t &G, index_t &index) const {
+    index.words = (count(G)+63)/64;
+    index.rows.assign(2*64*words*index.words, 0);
+    for(size_t i = 0; i < count(G); i++)
+        update_index(index, i, get(G,i));
+}
+
+void espresso::update_index(index_t &index, size_t i, const word_t *c) const {
+    const word_t bit = (word_t) 1 << (i & 63);
+    for(size_t v = 0; v < 64*words; v++){
+        for(unsigned int value = 0; value < 2; value++){
+            word_t &row = index.rows[(2*v+value)*index.words + (i >> 6)];
+            if(c[value*words + (v >> 6)] & ((word_t) 1 << (v & 63)))
+                row |= bit;
+            else
+                row &= ~bit;
+        }
+    }
+}
+
+// cubes of G that intersect c, with the variables of c made free, are
+// appended to result
+void espresso::cofactor(const cubes_t &G, const index_t &index, const word_t *c, cubes_t &result, const vector<char> *skip) const {
+    vector<word_t> candidates(index.words, ~(word_t) 0);
+    if(count(G) & 63)
+        candidates.back() = ((word_t) 1 << (count(G) & 63)) - 1;
+    for(size_t w = 0; w < words; w++){
+        for(word_t bits = (c[w] ^ c[words+w]) & mask[w]; bits; bits &= bits-1){
+            const size_t v = 64*w + ctz(bits);
+            const word_t *row = &index.rows[(2*v + ((c[words+w] & bits & -bits) ? 1 : 0))*index.words];
+            for(size_t k = 0; k < index.words; k++)
+                candidates[k] &= row[k];
+        }
+    }
+
+    size_t n = count(result), bound = n;
+    for(size_t k = 0; k < index.words; k++)
+        bound += popcount(candidates[k]);
+    result.resize(bound*2*words);
+
+    for(size_t k = 0; k < index.words; k++){
+        for(word_t bits = candidates[k]; bits; bits &= bits-1){
+            const size_t i = 64*k + ctz(bits);
+            if(skip && (*skip)[i])
+                continue;
+
+            const word_t *g = get(G,i);
+            word_t *r = get(result,n++);
+            for(size_t w = 0; w < words; w++){
+                r[w] = g[w] | (~c[w] & mask[w]);
+                r[words+w] = g[words+w] | (~c[words+w] & mask[w]);
+            }
+        }
+    }
+    result.resize(n*2*words);
+}
+
+// c is contained in the cubes of G that are not skipped and D
+bool espresso::covered(const word_t *c, const cubes_t &G, const index_t &index, const vector<char> &skip) const {
+    cubes_t cofactors;
+    cofactors.reserve(2*words*64);
+    cofactor(G, index, c, cofactors, &skip);
+    cofactor(D, index_D, c, cofactors, NULL);
+    return tautology(cofactors);
+}
+
+// unate recursive paradigm, G is destroyed
+bool espresso::tautology(cubes_t &G) const {
+    vector<word_t> zero(words), one(words), unate(words);
+    while(true){
+        if(count(G) == 0)
+            return false;
+
+        // columns, and the fraction of the space the cubes could cover
+        double volume = 0;
+        fill(zero.begin(), zero.end(), 0);
+        fill(one.begin(), one.end(), 0);
+        for(size_t i = 0; i < count(G); i++){
+            const word_t *g = get(G,i);
+            if(universal(g))
+                return true;
+            for(size_t w = 0; w < words; w++){
+                zero[w] |= g[w] & ~g[words+w];
+                one[w] |= g[words+w] & ~g[w];
+            }
+            volume += ldexp(1.0, -(int) literals(g));
+        }
+        if(volume < 1.0 - 1e-9)
+            return false;
+
+        // a cover that is unate in a variable is a tautology only if the
+        // cubes that don't depend on that variable are
+        bool any = false;
+        for(size_t w = 0; w < words; w++){
+            unate[w] = zero[w] ^ one[w];
+            any |= (unate[w] != 0);
+        }
+        if(!any)
+            break;
+
+        size_t n = 0;
+        for(size_t i = 0; i < count(G); i++){
+            const word_t *g = get(G,i);
+            bool keep = true;
+            for(size_t w = 0; w < words && keep; w++)
+                keep = !((g[w] ^ g[words+w]) & unate[w]);
+            if(keep){
+                if(n != i)
+                    copy(g, g+2*words, get(G,n));
+                n++;
+            }
+        }
+        G.resize(n*2*words);
+    }
+
+    // few variables left, or the cover as a truth table
+    unsigned int binate = 0;
+    for(size_t w = 0; w < words; w++)
+        binate += popcount(zero[w]);
+    if(binate <= 6){
+        static const word_t pattern[6] = {
+            0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+            0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+        };
+        const word_t all = (binate == 6 ? ~(word_t) 0 : ((word_t) 1 << (1 << binate)) - 1);
+        word_t table = 0;
+        for(size_t i = 0; i < count(G) && table != all; i++){
+            const word_t *g = get(G,i);
+            word_t minterms = all;
+            unsigned int j = 0;
+            for(size_t w = 0; w < words; w++){
+                for(word_t bits = zero[w]; bits; bits &= bits-1, j++){
+                    const word_t bit = bits & -bits;
+                    if(!(g[w] & bit))
+                        minterms &= pattern[j];
+                    else if(!(g[words+w] & bit))
+                        minterms &= ~pattern[j];
+                }
+            }
+            table |= minterms;
+        }
+        return table == all;
+    }
+
+    // split on the variable that is fixed in most cubes
+    vector<unsigned int> fixed(64*words, 0);
+    for(size_t i = 0; i < count(G); i++){
+        const word_t *g = get(G,i);
+        for(size_t w = 0; w < words; w++)
+            for(word_t bits = g[w] ^ g[words+w]; bits; bits &= bits-1)
+                fixed[64*w + ctz(bits)]++;
+    }
+    const size_t v = max_element(fixed.begin(), fixed.end()) - fixed.begin();
+    const word_t bit = (word_t) 1 << (v & 63);
+
+    cubes_t H;
+    for(unsigned int half = 0; half < 2; half++){
+        H.resize(G.size());
+        size_t n = 0;
+        for(size_t i = 0; i < count(G); i++){
+            const word_t *g = get(G,i);
+            if(!(g[half*words + (v >> 6)] & bit))
+                continue;
+            word_t *h = get(H,n++);
+            copy(g, g+2*words, h);
+            h[v >> 6] |= bit;
+            h[words + (v >> 6)] |= bit;
+        }
+        H.resize(n*2*words);
+        if(!tautology(H))
+            return false;
+    }
+    return true;
+}
+
+void espresso::single_cube_containment(cubes_t &G) const {
+    vector<char> removed(count(G), 0);
+    for(size_t i = 0; i < count(G); i++){
+        if(removed[i])
+            continue;
+        for(size_t j = 0; j < count(G); j++)
+            if(i != j && !removed[j] && contains(get(G,i), get(G,j)))
+                removed[j] = 1;
+    }
+
+    size_t n = 0;
+    for(size_t i = 0; i < count(G); i++){
+        if(!removed[i]){
+            if(n != i)
+                copy(get(G,i), get(G,i)+2*words, get(G,n));
+            n++;
+        }
+    }
+    G.resize(n*2*words);
+}
+
+// make every cube prime by freeing its variables as long as it stays within
+// the on-set and don't cares, cubes that become covered are dropped
+void espresso::expand(cubes_t &G){
+    vector<size_t> order(count(G));
+    for(size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){
+        return literals(get(G,a)) < literals(get(G,b));
+    });
+
+    index_t index;
+    build_index(G, index);
+    vector<char> removed(count(G), 0);
+    vector<char> none(count(G), 0);
+    vector<word_t> c(2*words), half(2*words);
+    vector<unsigned int> score(64*words);
+    vector<size_t> candidates;
+    for(size_t k = 0; k < order.size(); k++){
+        const size_t i = order[k];
+        if(removed[i])
+            continue;
+        copy(get(G,i), get(G,i)+2*words, c.begin());
+
+        // free the variables first that keep most other cubes out of c
+        fill(score.begin(), score.end(), 0);
+        for(size_t j = 0; j < count(G); j++){
+            if(removed[j] || j == i)
+                continue;
+            const word_t *g = get(G,j);
+            for(size_t w = 0; w < 2*words; w++)
+                for(word_t bits = g[w] & ~c[w]; bits; bits &= bits-1)
+                    score[64*(w % words) + ctz(bits)]++;
+        }
+        candidates.clear();
+        for(size_t w = 0; w < words; w++)
+            for(word_t bits = c[w] ^ c[words+w]; bits; bits &= bits-1)
+                candidates.push_back(64*w + ctz(bits));
+        stable_sort(candidates.begin(), candidates.end(), [&](size_t a, size_t b){
+            return score[a] > score[b];
+        });
+
+        for(size_t l = 0; l < candidates.size(); l++){
+            const size_t v = candidates[l];
+            const word_t bit = (word_t) 1 << (v & 63);
+
+            // c is covered already, so only the half that is added matters
+            copy(c.begin(), c.end(), half.begin());
+            half[v >> 6] ^= bit;
+            half[words + (v >> 6)] ^= bit;
+            if(covered(&half[0], G, index, none)){
+                c[v >> 6] |= bit;
+                c[words + (v >> 6)] |= bit;
+            }
+        }
+        copy(c.begin(), c.end(), get(G,i));
+        update_index(index, i, &c[0]);
+
+        for(size_t j = 0; j < count(G); j++)
+            if(j != i && !removed[j] && contains(&c[0], get(G,j)))
+                removed[j] = none[j] = 1;
+    }
+
+    size_t n = 0;
+    for(size_t i = 0; i < count(G); i++){
+        if(!removed[i]){
+            if(n != i)
+                copy(get(G,i), get(G,i)+2*words, get(G,n));
+            n++;
+        }
+    }
+    G.resize(n*2*words);
+}
+
+// drop cubes covered by the other cubes and the don't cares, smallest first
+void espresso::irredundant(cubes_t &G){
+    vector<size_t> order(count(G));
+    for(size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){
+        return literals(get(G,a)) > literals(get(G,b));
+    });
+
+    index_t index;
+    build_index(G, index);
+    vector<char> removed(count(G), 0);
+    for(size_t k = 0; k < order.size(); k++){
+        const size_t i = order[k];
+        removed[i] = 1;
+        if(!covered(get(G,i), G, index, removed))
+            removed[i] = 0;
+    }
+
+    size_t n = 0;
+    for(size_t i = 0; i < count(G); i++){
+        if(!removed[i]){
+            if(n != i)
+                copy(get(G,i), get(G,i)+2*words, get(G,n));
+            n++;
+        }
+    }
+    G.resize(n*2*words);
+}
+
+// shrink every cube to the part that is not covered by the other cubes, so
+// that the next expand may take a different direction
+void espresso::reduce(cubes_t &G){
+    vector<size_t> order(count(G));
+    for(size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){
+        return literals(get(G,a)) < literals(get(G,b));
+    });
+
+    index_t index;
+    build_index(G, index);
+    vector<char> skip(count(G), 0);
+    vector<word_t> half(2*words);
+    for(size_t k = 0; k < order.size(); k++){
+        const size_t i = order[k];
+        word_t *c = get(G,i);
+        skip[i] = 1;
+        for(size_t w = 0; w < words; w++){
+            for(word_t bits = c[w] & c[words+w] & mask[w]; bits; bits &= bits-1){
+                const word_t bit = bits & -bits;
+
+                // if the part of c where the variable is 1 is covered
+                // elsewhere, c only needs the part where it is 0
+                for(unsigned int value = 0; value < 2; value++){
+                    copy(c, c+2*words, half.begin());
+                    half[(1-value)*words + w] &= ~bit;
+                    if(covered(&half[0], G, index, skip)){
+                        c[value*words + w] &= ~bit;
+                        break;
+                    }
+                }
+            }
+        }
+        update_index(index, i, c);
+        skip[i] = 0;
+    }
+}
+
+// fewer cubes first, fewer literals second
+bool espresso::cheaper(const cubes_t &a, const cubes_t &b) const {
+    if(count(a) != count(b))
+        return count(a) < count(b);
+
+    size_t la = 0, lb = 0;
+    for(size_t i = 0; i < count(a); i++)
+        la += literals(get(a,i));
+    for(size_t i = 0; i < count(b); i++)
+        lb += literals(get(b,i));
+    return la < lb;
+}
+
+int espresso::solve(){
+    words = max((size_t) 1, (variables.size()+63)/64);
+    mask.assign(words, 0);
+    for(size_t v = 0; v < variables.size(); v++)
+        mask[v >> 6] |= (word_t) 1 << (v & 63);
+
+    F.clear();
+    D.clear();
+    for(unsigned int i = 0; i < on.size(); i++)
+        add(F, on[i]);
+    for(unsigned int i = 0; i < dc.size(); i++)
+        add(D, dc[i]);
+    if(count(F) == 0)
+        return 0;
+    build_index(D, index_D);
+
+    single_cube_containment(F);
+    expand(F);
+    irredundant(F);
+
+    cubes_t best = F;
+    while(true){
+        reduce(F);
+        expand(F);
+        irredundant(F);
+        if(!cheaper(F, best))
+            break;
+        best = F;
+    }
+    F.swap(best);
+
+    return count(F);
+}
+
+unsigned int espresso::get_primes_size(){
+    return count(F);
+}
+
+void espresso::get_clause(vector<int32_t> &literals, unsigned int e){
+    const word_t *c = get(F,e);
+    for(size_t v = 0; v < variables.size(); v++){
+        const word_t bit = (word_t) 1 << (v & 63);
+        const bool zero = c[v >> 6] & bit;
+        const bool one = c[words + (v >> 6)] & bit;
+        if(zero && !one)
+            literals.push_back(-1*variables[v]);
+        else if(one && !zero)
+            literals.push_back(variables[v]);
+    }
+}
+
+void espresso::print(){
+    printf("(");
+    for(unsigned int s = 0; s < get_primes_size(); s++){
+        if(s > 0)
+           printf("  ∨  "); // or
+
+        vector<int32_t> literals;
+        get_clause(literals, s);
+        printf("(");
+        for(unsigned int i = 0; i < literals.size(); i++){
+            if(i > 0)
+                printf(" ∧ "); // and
+            if(literals[i] < 0)
+                printf("¬"); // not
+            printf("%d", abs(literals[i]));
+        }
+        printf(")");
+    }
+    printf(")\n");
+}